@@ -0,0 +1,84 @@
+#include "cache_attribution.h"
+
+#include <algorithm>
+
+namespace Ripes {
+
+namespace {
+
+double sortValue(const AccessCounters& counters, CacheAttribution::SortKey key) {
+    switch (key) {
+    case CacheAttribution::SortKey::Accesses: return counters.accesses;
+    case CacheAttribution::SortKey::Hits: return counters.hits;
+    case CacheAttribution::SortKey::Misses: return counters.misses;
+    case CacheAttribution::SortKey::Writebacks: return counters.writebacks;
+    case CacheAttribution::SortKey::MissRate: return counters.missRate();
+    }
+    return 0;
+}
+
+}  // namespace
+
+CacheAttribution::CacheAttribution() {
+    setRegions(defaultRegions());
+}
+
+std::vector<MemoryRegion> CacheAttribution::defaultRegions() {
+    // Follows the default RISC-V memory layout of the simulator; .text at 0x0, static data at 0x10000000, the heap
+    // growing upwards from the end of static data and the stack growing downwards from 0x7ffffff0.
+    return {{"Text", 0x00000000, 0x0FFFFFFF},
+            {"Globals", 0x10000000, 0x17FFFFFF},
+            {"Heap", 0x18000000, 0x6FFFFFFF},
+            {"Stack", 0x70000000, 0xFFFFFFFF}};
+}
+
+void CacheAttribution::setRegions(const std::vector<MemoryRegion>& regions) {
+    m_regions = regions;
+    m_regionCounters.assign(m_regions.size(), AccessCounters());
+}
+
+void CacheAttribution::reset() {
+    m_pcCounters.clear();
+    m_unattributedAccesses = 0;
+    m_regionCounters.assign(m_regions.size(), AccessCounters());
+}
+
+void CacheAttribution::record(uint64_t pc, uint64_t address, bool isHit, bool isWriteback, int delta) {
+    if (pc != s_invalidPC) {
+        m_pcCounters[pc].apply(isHit, isWriteback, delta);
+    } else {
+        m_unattributedAccesses += delta;
+    }
+
+    // The number of regions is small; a linear scan is cheaper than any search structure
+    for (unsigned i = 0; i < m_regions.size(); i++) {
+        if (address >= m_regions[i].start && address <= m_regions[i].end) {
+            m_regionCounters[i].apply(isHit, isWriteback, delta);
+            break;
+        }
+    }
+}
+
+std::vector<std::pair<uint64_t, AccessCounters>> CacheAttribution::getTopPCs(SortKey key, unsigned n) const {
+    std::vector<std::pair<uint64_t, AccessCounters>> pcs;
+    pcs.reserve(m_pcCounters.size());
+    m_pcCounters.forEach([&](uint64_t pc, const AccessCounters& counters) {
+        // Entries are never removed from the table; PCs whose accesses have all been undone are skipped
+        if (counters.accesses > 0) {
+            pcs.push_back({pc, counters});
+        }
+    });
+
+    const auto cmp = [key](const auto& lhs, const auto& rhs) {
+        return sortValue(lhs.second, key) > sortValue(rhs.second, key);
+    };
+    if (n != 0 && n < pcs.size()) {
+        std::partial_sort(pcs.begin(), pcs.begin() + n, pcs.end(), cmp);
+        pcs.resize(n);
+    } else {
+        std::sort(pcs.begin(), pcs.end(), cmp);
+    }
+    return pcs;
+}
+
+}  // namespace Ripes
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <QString>
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "open_addressing_map.h"
+
+namespace Ripes {
+
+/**
+ * @brief The AccessCounters struct
+ * Hit/miss/writeback counters for some subset of the accesses performed to a cache.
+ */
+struct AccessCounters {
+    int accesses = 0;
+    int hits = 0;
+    int misses = 0;
+    int writebacks = 0;
+
+    double missRate() const { return accesses == 0 ? 0 : static_cast<double>(misses) / accesses; }
+    /// Counts (@p delta = 1) or uncounts (@p delta = -1, upon undo) an access
+    void apply(bool isHit, bool isWriteback, int delta) {
+        accesses += delta;
+        hits += isHit ? delta : 0;
+        misses += isHit ? 0 : delta;
+        writebacks += isWriteback ? delta : 0;
+    }
+};
+
+/**
+ * @brief The MemoryRegion struct
+ * A named, inclusive address range [start; end] used for bucketing cache accesses by the kind of memory accessed.
+ */
+struct MemoryRegion {
+    QString name;
+    uint64_t start;
+    uint64_t end;
+};
+
+/**
+ * @brief The CacheAttribution class
+ * Attributes cache accesses to the program counter of the instruction which performed the access, as well as to the
+ * memory region which was accessed.
+ */
+class CacheAttribution {
+public:
+    static constexpr uint64_t s_invalidPC = OpenAddressingMap<AccessCounters, uint64_t>::s_emptyKey;
+
+    enum class SortKey { Accesses, Hits, Misses, Writebacks, MissRate };
+
+    CacheAttribution();
+
+    /**
+     * @brief record
+     * Adds (@p delta = 1) or removes (@p delta = -1, when undoing an access) an access to @p address, performed by the
+     * instruction at @p pc, from the attribution tables. Accesses with an invalid PC are only attributed to a region.
+     */
+    void record(uint64_t pc, uint64_t address, bool isHit, bool isWriteback, int delta);
+    void reset();
+
+    /**
+     * @brief setRegions
+     * Sets the address regions which accesses are bucketed into. Changing the regions clears the region counters.
+     */
+    void setRegions(const std::vector<MemoryRegion>& regions);
+    const std::vector<MemoryRegion>& getRegions() const { return m_regions; }
+    const std::vector<AccessCounters>& getRegionCounters() const { return m_regionCounters; }
+
+    /**
+     * @brief getTopPCs
+     * @returns up to @p n (PC, counters) pairs sorted in descending order by @p key. If @p n is 0, all PCs are
+     * returned.
+     */
+    std::vector<std::pair<uint64_t, AccessCounters>> getTopPCs(SortKey key, unsigned n = 0) const;
+    /**
+     * @brief getUnattributedAccesses
+     * @returns the number of accesses which were recorded with an invalid PC, and hence not attributed to any
+     * instruction.
+     */
+    int getUnattributedAccesses() const { return m_unattributedAccesses; }
+    size_t getBytes() const { return m_pcCounters.getBytes() + m_regionCounters.size() * sizeof(AccessCounters); }
+
+    static std::vector<MemoryRegion> defaultRegions();
+
+private:
+    OpenAddressingMap<AccessCounters, uint64_t> m_pcCounters;
+    std::vector<MemoryRegion> m_regions;
+    std::vector<AccessCounters> m_regionCounters;
+    int m_unattributedAccesses = 0;
+};
+
+const static std::map<CacheAttribution::SortKey, QString> s_attributionSortKeyStrings{
+    {CacheAttribution::SortKey::Accesses, "Accesses"},
+    {CacheAttribution::SortKey::Hits, "Hits"},
+    {CacheAttribution::SortKey::Misses, "Misses"},
+    {CacheAttribution::SortKey::Writebacks, "Writebacks"},
+    {CacheAttribution::SortKey::MissRate, "Miss rate"}};
+
+}  // namespace Ripes
@@ -0,0 +1,328 @@
+#include "cache_coherence.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+namespace Ripes {
+
+bool CoherenceTraceReader::read(const std::string& path, std::vector<CoherenceAccess>& trace) {
+    m_error.clear();
+    m_cores = 0;
+    std::FILE* file = std::fopen(path.c_str(), "r");
+    if (file == nullptr) {
+        m_error = "Could not open '" + path + "': " + std::strerror(errno);
+        return false;
+    }
+
+    char line[256];
+    unsigned lineNumber = 0;
+    while (std::fgets(line, sizeof(line), file) != nullptr) {
+        lineNumber++;
+        const char* pos = line;
+        while (std::isspace(static_cast<unsigned char>(*pos))) {
+            pos++;
+        }
+        if (*pos == '\0' || *pos == '#') {
+            continue;
+        }
+
+        CoherenceAccess access;
+        char* end;
+        const unsigned long core = std::strtoul(pos, &end, 10);
+        bool valid = end != pos && core < 64;
+        pos = end;
+        while (std::isspace(static_cast<unsigned char>(*pos))) {
+            pos++;
+        }
+        const char kind = static_cast<char>(std::tolower(static_cast<unsigned char>(*pos)));
+        valid &= (kind == 'r' || kind == 'w') && std::isspace(static_cast<unsigned char>(pos[1]));
+        if (valid) {
+            pos++;
+            access.address = std::strtoull(pos, &end, 0);
+            valid = end != pos;
+            for (pos = end; valid && *pos != '\0'; pos++) {
+                valid = std::isspace(static_cast<unsigned char>(*pos));
+            }
+        }
+        if (!valid) {
+            m_error = path + ":" + std::to_string(lineNumber) + ": expected '<core> <r|w> <address>'";
+            std::fclose(file);
+            return false;
+        }
+        access.core = static_cast<unsigned>(core);
+        access.isWrite = kind == 'w';
+        m_cores = std::max(m_cores, access.core + 1);
+        trace.push_back(access);
+    }
+
+    const bool failed = std::ferror(file) != 0;
+    std::fclose(file);
+    if (failed) {
+        m_error = "Error while reading '" + path + "'";
+        return false;
+    }
+    return true;
+}
+
+void CacheCoherenceSim::reset(const Config& config) {
+    m_config = config;
+    m_config.cores = std::min(std::max(m_config.cores, 1u), 64u);
+    m_config.blockBits = std::min(m_config.blockBits, 5);
+    m_config.threads = std::min(std::max(m_config.threads, 1u), 1u << m_config.setBits);
+
+    m_lines.assign(static_cast<size_t>(m_config.cores) << (m_config.setBits + m_config.wayBits), Line());
+    m_shards.clear();
+    m_shards.resize(m_config.threads);
+    for (auto& shard : m_shards) {
+        shard.cores.assign(m_config.cores, CoreStats());
+        shard.history.resize(m_config.cores);
+    }
+}
+
+CacheCoherenceSim::Line* CacheCoherenceSim::find(unsigned core, uint64_t block) {
+    return const_cast<Line*>(static_cast<const CacheCoherenceSim*>(this)->find(core, block));
+}
+
+const CacheCoherenceSim::Line* CacheCoherenceSim::find(unsigned core, uint64_t block) const {
+    const Line* set = getSet(core, getSetIdx(block));
+    for (unsigned way = 0; way < (1u << m_config.wayBits); way++) {
+        if (set[way].state != MesiState::Invalid && set[way].block == block) {
+            return &set[way];
+        }
+    }
+    return nullptr;
+}
+
+void CacheCoherenceSim::access(const CoherenceAccess& access) {
+    const uint64_t block = access.address >> (m_config.wordBits + m_config.blockBits);
+    this->access(m_shards[getShardIdx(block)], access);
+}
+
+void CacheCoherenceSim::run(const std::vector<CoherenceAccess>& trace) {
+    const auto runShard = [&](unsigned shardIdx) {
+        Shard& shard = m_shards[shardIdx];
+        for (const auto& access : trace) {
+            const uint64_t block = access.address >> (m_config.wordBits + m_config.blockBits);
+            if (getShardIdx(block) == shardIdx) {
+                this->access(shard, access);
+            }
+        }
+    };
+
+    // Shards operate on disjoint sets of lines and on their own statistics; no synchronization is required
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < m_shards.size(); i++) {
+        workers.emplace_back(runShard, i);
+    }
+    runShard(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void CacheCoherenceSim::access(Shard& shard, const CoherenceAccess& access) {
+    const unsigned core = access.core % m_config.cores;
+    const uint64_t block = access.address >> (m_config.wordBits + m_config.blockBits);
+    const uint32_t wordBit = 1u << ((access.address >> m_config.wordBits) & ((1u << m_config.blockBits) - 1));
+    auto& stats = shard.cores[core];
+    stats.accesses++;
+    shard.now++;
+
+    Line* line = find(core, block);
+    if (line != nullptr) {
+        stats.hits++;
+        if (access.isWrite) {
+            if (line->state == MesiState::Shared) {
+                shard.bus.busUpgr++;
+                invalidateOthers(shard, core, block, wordBit);
+            }
+            // Exclusive lines are upgraded silently
+            line->state = MesiState::Modified;
+        }
+    } else {
+        stats.misses++;
+        CoreBlock& history = shard.history[core][block];
+        const BlockState* blockState = shard.blocks.find(block);
+        if (blockState != nullptr && (blockState->invalidatedCores >> core & 1)) {
+            // Coherence miss; the data is truly shared if another core wrote the accessed word since the invalidation
+            if (history.writtenWords & wordBit) {
+                stats.trueSharingMisses++;
+            } else {
+                stats.falseSharingMisses++;
+                shard.blocks[block].sharing.falseSharingMisses++;
+            }
+            shard.blocks[block].invalidatedCores &= ~(1ull << core);
+            history.writtenWords = 0;
+        } else if (!history.seen) {
+            stats.coldMisses++;
+        } else {
+            stats.replacementMisses++;
+        }
+        history.seen = true;
+
+        // Snoop the other caches. At most one other cache holds the block exclusively or modified, which supplies the
+        // data. On a read, the copy is downgraded to shared (flushing it to memory if modified); on a write, it is
+        // invalidated below.
+        bool shared = false;
+        for (unsigned other = 0; other < m_config.cores; other++) {
+            Line* otherLine = other == core ? nullptr : find(other, block);
+            if (otherLine == nullptr) {
+                continue;
+            }
+            shared = true;
+            if (otherLine->state == MesiState::Modified || otherLine->state == MesiState::Exclusive) {
+                shard.bus.cacheToCache++;
+                if (!access.isWrite) {
+                    if (otherLine->state == MesiState::Modified) {
+                        shard.bus.flushes++;
+                    }
+                    otherLine->state = MesiState::Shared;
+                    otherLine->dirtyWords = 0;
+                }
+            }
+        }
+
+        line = &fill(shard, core, block);
+        if (access.isWrite) {
+            shard.bus.busRdX++;
+            invalidateOthers(shard, core, block, wordBit);
+            line->state = MesiState::Modified;
+        } else {
+            shard.bus.busRd++;
+            line->state = shared ? MesiState::Shared : MesiState::Exclusive;
+        }
+    }
+
+    line->accessedWords |= wordBit;
+    line->lastUse = shard.now;
+    if (access.isWrite) {
+        line->dirtyWords |= wordBit;
+
+        // Record the write for the cores which have lost the block, to classify their next miss on it
+        const BlockState* blockState = shard.blocks.find(block);
+        uint64_t invalidatedCores = blockState == nullptr ? 0 : blockState->invalidatedCores & ~(1ull << core);
+        while (invalidatedCores != 0) {
+            const unsigned other = __builtin_ctzll(invalidatedCores);
+            invalidatedCores &= invalidatedCores - 1;
+            shard.history[other][block].writtenWords |= wordBit;
+        }
+    }
+}
+
+CacheCoherenceSim::Line& CacheCoherenceSim::fill(Shard& shard, unsigned core, uint64_t block) {
+    // Fill an invalid way if available, else evict the least recently used way
+    Line* set = getSet(core, getSetIdx(block));
+    Line* victim = set;
+    for (unsigned way = 0; way < (1u << m_config.wayBits); way++) {
+        if (set[way].state == MesiState::Invalid) {
+            victim = &set[way];
+            break;
+        }
+        if (set[way].lastUse < victim->lastUse) {
+            victim = &set[way];
+        }
+    }
+
+    if (victim->state == MesiState::Modified) {
+        shard.cores[core].writebacks++;
+        shard.bus.writebacks++;
+    }
+    *victim = Line();
+    victim->block = block;
+    return *victim;
+}
+
+void CacheCoherenceSim::invalidateOthers(Shard& shard, unsigned core, uint64_t block, uint32_t wordBit) {
+    for (unsigned other = 0; other < m_config.cores; other++) {
+        Line* otherLine = other == core ? nullptr : find(other, block);
+        if (otherLine == nullptr) {
+            continue;
+        }
+
+        BlockState& blockState = shard.blocks[block];
+        blockState.sharing.block = block;
+        blockState.sharing.invalidations++;
+        if ((otherLine->accessedWords & wordBit) == 0) {
+            blockState.sharing.falseInvalidations++;
+        }
+        if (otherLine->state == MesiState::Modified) {
+            // The modified copy is flushed to memory before being invalidated
+            shard.bus.flushes++;
+            if ((otherLine->dirtyWords & wordBit) == 0) {
+                blockState.sharing.falseDirtyConflicts++;
+            }
+        }
+        blockState.invalidatedCores |= 1ull << other;
+        shard.history[other][block].writtenWords = wordBit;
+        shard.cores[other].invalidations++;
+        *otherLine = Line();
+    }
+}
+
+MesiState CacheCoherenceSim::getState(unsigned core, uint64_t address) const {
+    const Line* line = find(core, address >> (m_config.wordBits + m_config.blockBits));
+    return line == nullptr ? MesiState::Invalid : line->state;
+}
+
+CacheCoherenceSim::CoreStats CacheCoherenceSim::getCoreStats(unsigned core) const {
+    CoreStats total;
+    for (const auto& shard : m_shards) {
+        const auto& stats = shard.cores.at(core);
+        total.accesses += stats.accesses;
+        total.hits += stats.hits;
+        total.misses += stats.misses;
+        total.coldMisses += stats.coldMisses;
+        total.replacementMisses += stats.replacementMisses;
+        total.trueSharingMisses += stats.trueSharingMisses;
+        total.falseSharingMisses += stats.falseSharingMisses;
+        total.invalidations += stats.invalidations;
+        total.writebacks += stats.writebacks;
+    }
+    return total;
+}
+
+CacheCoherenceSim::BusStats CacheCoherenceSim::getBusStats() const {
+    BusStats total;
+    for (const auto& shard : m_shards) {
+        total.busRd += shard.bus.busRd;
+        total.busRdX += shard.bus.busRdX;
+        total.busUpgr += shard.bus.busUpgr;
+        total.flushes += shard.bus.flushes;
+        total.cacheToCache += shard.bus.cacheToCache;
+        total.writebacks += shard.bus.writebacks;
+    }
+    return total;
+}
+
+std::vector<CacheCoherenceSim::BlockSharing> CacheCoherenceSim::getFalseSharing(unsigned n) const {
+    std::vector<BlockSharing> blocks;
+    for (const auto& shard : m_shards) {
+        shard.blocks.forEach([&](uint64_t block, const BlockState& state) {
+            if (state.sharing.falseInvalidations + state.sharing.falseSharingMisses > 0) {
+                blocks.push_back(state.sharing);
+                blocks.back().block = block;
+            }
+        });
+    }
+
+    // Ties are broken by block address, such that the order is independent of the sharding and of the hash tables
+    const auto cmp = [](const BlockSharing& lhs, const BlockSharing& rhs) {
+        const uint64_t l = lhs.falseInvalidations + lhs.falseSharingMisses;
+        const uint64_t r = rhs.falseInvalidations + rhs.falseSharingMisses;
+        return l != r ? l > r : lhs.block < rhs.block;
+    };
+    if (n != 0 && n < blocks.size()) {
+        std::partial_sort(blocks.begin(), blocks.begin() + n, blocks.end(), cmp);
+        blocks.resize(n);
+    } else {
+        std::sort(blocks.begin(), blocks.end(), cmp);
+    }
+    return blocks;
+}
+
+}  // namespace Ripes
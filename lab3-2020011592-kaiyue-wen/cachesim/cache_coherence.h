@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "open_addressing_map.h"
+
+namespace Ripes {
+
+/**
+ * @brief The CoherenceAccess struct
+ * An access of an interleaved multi-threaded trace, performed by the core @var core.
+ */
+struct CoherenceAccess {
+    uint64_t address;
+    unsigned core;
+    bool isWrite;
+};
+
+enum class MesiState : uint8_t { Invalid, Shared, Exclusive, Modified };
+
+/**
+ * @brief The CoherenceTraceReader class
+ * Reads interleaved multi-threaded traces from text files with an access per line, in the order of the accesses:
+ *   <core> <r|w> <address>
+ * where the core is a decimal index below 64, and the address is decimal or hexadecimal (0x-prefixed). Empty lines
+ * and lines starting with '#' are ignored.
+ */
+class CoherenceTraceReader {
+public:
+    /**
+     * @brief read
+     * Appends the accesses of the trace file at @p path to @p trace. @returns false, and sets the error string, if the
+     * file could not be read or contains a malformed line.
+     */
+    bool read(const std::string& path, std::vector<CoherenceAccess>& trace);
+    const std::string& errorString() const { return m_error; }
+    /**
+     * @brief getCores
+     * @returns the number of cores accessing the most recently read trace; one more than the highest core index.
+     */
+    unsigned getCores() const { return m_cores; }
+
+private:
+    std::string m_error;
+    unsigned m_cores = 0;
+};
+
+/**
+ * @brief The CacheCoherenceSim class
+ * Multi-core simulation of private, write-back and write-allocate L1 caches with LRU replacement, kept coherent by a
+ * snooping MESI protocol on an atomic bus. Accesses are performed in trace order; each access completes (including
+ * all snooping) before the next one starts.
+ *
+ * Misses of a core are classified as cold misses (the core has never held the block), coherence misses (the core
+ * lost the block to an invalidation) and replacement misses. Coherence misses are true sharing misses if the accessed
+ * word was written by another core since the invalidation, and false sharing misses otherwise. Likewise, each line
+ * tracks the words accessed and the words written (as CacheWay::dirtyBlocks does) by its core, such that an
+ * invalidation caused by a write to a word which the invalidated copy never accessed, or never wrote whilst holding it
+ * modified, is attributed to false sharing of the block.
+ *
+ * Sets do not interact: a block maps to the same set in every core, and coherence actions only involve the copies of
+ * a single block. The caches are therefore partitioned by set index into shards, each of which may be simulated on a
+ * separate host thread. Every shard performs the accesses to its sets in trace order, such that results are
+ * deterministic and independent of the number of threads.
+ *
+ * The offline tools/cachecoherence_sim program drives the simulator with a trace file, and reports its statistics.
+ */
+class CacheCoherenceSim {
+public:
+    struct Config {
+        unsigned cores = 2;  // At most 64
+        int setBits = 6;
+        int wayBits = 2;
+        int blockBits = 3;  // 2^N words per line; at most 5
+        int wordBits = 2;   // 2^N bytes per word
+        unsigned threads = 1;  // Shards, simulated on separate host threads by run()
+    };
+
+    struct CoreStats {
+        uint64_t accesses = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t coldMisses = 0;
+        uint64_t replacementMisses = 0;
+        uint64_t trueSharingMisses = 0;
+        uint64_t falseSharingMisses = 0;
+        uint64_t invalidations = 0;  // Copies of this core invalidated by writes of other cores
+        uint64_t writebacks = 0;     // Modified lines evicted by this core
+
+        uint64_t coherenceMisses() const { return trueSharingMisses + falseSharingMisses; }
+    };
+
+    struct BusStats {
+        uint64_t busRd = 0;         // Read misses
+        uint64_t busRdX = 0;        // Write misses; invalidates all other copies
+        uint64_t busUpgr = 0;       // Writes to shared lines; invalidates all other copies
+        uint64_t flushes = 0;       // Modified lines written back when snooped
+        uint64_t cacheToCache = 0;  // Misses served by another cache
+        uint64_t writebacks = 0;    // Modified lines written back when evicted
+
+        uint64_t transactions() const { return busRd + busRdX + busUpgr + writebacks; }
+    };
+
+    /**
+     * @brief The BlockSharing struct
+     * Invalidation counters of a single block.
+     */
+    struct BlockSharing {
+        uint64_t block = 0;  // Block address (ie. the address with the block- and byte offset bits removed)
+        uint64_t invalidations = 0;
+        uint64_t falseInvalidations = 0;    // Invalidations by a write to a word which the copy never accessed
+        uint64_t falseDirtyConflicts = 0;   // Invalidations of a modified copy by a write to a word it did not write
+        uint64_t falseSharingMisses = 0;
+    };
+
+    /**
+     * @brief reset
+     * Invalidates all caches, clears all statistics and applies @p config.
+     */
+    void reset(const Config& config);
+    const Config& getConfig() const { return m_config; }
+
+    /**
+     * @brief access
+     * Performs a single access on the calling thread.
+     */
+    void access(const CoherenceAccess& access);
+
+    /**
+     * @brief run
+     * Performs all accesses of @p trace, with each shard simulated on its own host thread.
+     */
+    void run(const std::vector<CoherenceAccess>& trace);
+
+    MesiState getState(unsigned core, uint64_t address) const;
+    CoreStats getCoreStats(unsigned core) const;
+    BusStats getBusStats() const;
+
+    /**
+     * @brief getFalseSharing
+     * @returns up to @p n blocks (all if @p n is 0) with false sharing, in descending order of their false sharing
+     * invalidations and misses.
+     */
+    std::vector<BlockSharing> getFalseSharing(unsigned n = 0) const;
+
+private:
+    struct Line {
+        uint64_t block = 0;
+        MesiState state = MesiState::Invalid;
+        uint32_t accessedWords = 0;
+        uint32_t dirtyWords = 0;
+        uint64_t lastUse = 0;
+    };
+
+    /**
+     * @brief The CoreBlock struct
+     * History of a block with respect to a single core.
+     */
+    struct CoreBlock {
+        bool seen = false;
+        uint32_t writtenWords = 0;  // Words written by other cores since the block was invalidated
+    };
+
+    struct BlockState {
+        BlockSharing sharing;
+        uint64_t invalidatedCores = 0;  // Cores which lost the block to an invalidation and have not missed on it since
+    };
+
+    struct Shard {
+        std::vector<CoreStats> cores;
+        BusStats bus;
+        std::vector<OpenAddressingMap<CoreBlock, uint64_t>> history;  // Per core
+        OpenAddressingMap<BlockState, uint64_t> blocks;
+        uint64_t now = 0;
+    };
+
+    unsigned getSetIdx(uint64_t block) const { return static_cast<unsigned>(block & ((1u << m_config.setBits) - 1)); }
+    unsigned getShardIdx(uint64_t block) const { return getSetIdx(block) % m_shards.size(); }
+    Line* getSet(unsigned core, unsigned setIdx) {
+        return &m_lines[(static_cast<size_t>(core) << m_config.setBits | setIdx) << m_config.wayBits];
+    }
+    const Line* getSet(unsigned core, unsigned setIdx) const {
+        return &m_lines[(static_cast<size_t>(core) << m_config.setBits | setIdx) << m_config.wayBits];
+    }
+    Line* find(unsigned core, uint64_t block);
+    const Line* find(unsigned core, uint64_t block) const;
+
+    void access(Shard& shard, const CoherenceAccess& access);
+    Line& fill(Shard& shard, unsigned core, uint64_t block);
+    void invalidateOthers(Shard& shard, unsigned core, uint64_t block, uint32_t wordBit);
+
+    Config m_config;
+    std::vector<Line> m_lines;  // [core][set][way]
+    std::vector<Shard> m_shards;
+};
+
+}  // namespace Ripes
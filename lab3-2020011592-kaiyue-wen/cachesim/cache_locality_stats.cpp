@@ -0,0 +1,65 @@
+#include "cache_locality_stats.h"
+
+#include <algorithm>
+
+namespace Ripes {
+
+void CacheReuseHistogram::reset() {
+    m_accessCount = 0;
+    m_lastAccess.clear();
+    std::fill(m_buckets.begin(), m_buckets.end(), 0);
+    m_coldAccesses = 0;
+}
+
+CacheReuseHistogram::Outcome CacheReuseHistogram::access(uint64_t block) {
+    Outcome outcome;
+    m_accessCount++;
+
+    uint64_t& lastAccess = m_lastAccess[block];
+    outcome.previousAccess = lastAccess;
+    if (lastAccess == 0) {
+        m_coldAccesses++;
+    } else {
+        const uint64_t distance = m_accessCount - lastAccess;
+        outcome.bucket = std::min(63 - __builtin_clzll(distance), static_cast<int>(s_buckets) - 1);
+        m_buckets[outcome.bucket]++;
+    }
+    lastAccess = m_accessCount;
+    return outcome;
+}
+
+void CacheReuseHistogram::revert(uint64_t block, const Outcome& outcome) {
+    m_lastAccess[block] = outcome.previousAccess;
+    if (outcome.bucket < 0) {
+        m_coldAccesses--;
+    } else {
+        m_buckets[outcome.bucket]--;
+    }
+    m_accessCount--;
+}
+
+void CacheSetHeatMap::reset(unsigned sets) {
+    m_accesses.assign(sets, 0);
+    m_misses.assign(sets, 0);
+    m_maxMisses = 0;
+}
+
+void CacheSetHeatMap::record(unsigned setIdx, bool isHit, int delta) {
+    if (setIdx >= m_accesses.size()) {
+        return;
+    }
+    m_accesses[setIdx] += delta;
+    if (isHit) {
+        return;
+    }
+
+    m_misses[setIdx] += delta;
+    if (delta > 0) {
+        m_maxMisses = std::max(m_maxMisses, m_misses[setIdx]);
+    } else if (m_misses[setIdx] + 1 == m_maxMisses) {
+        // The set may have held the maximum miss count
+        m_maxMisses = *std::max_element(m_misses.begin(), m_misses.end());
+    }
+}
+
+}  // namespace Ripes
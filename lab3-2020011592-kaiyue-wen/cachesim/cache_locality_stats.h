@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "open_addressing_map.h"
+
+namespace Ripes {
+
+/**
+ * @brief The CacheReuseHistogram class
+ * Histogram of reuse distances, in log2-sized buckets. The reuse distance of an access is the number of accesses
+ * performed since the previous access to the same block; bucket i counts reuse distances in [2^i; 2^(i+1)[, and the
+ * last bucket also counts any longer distance. Accesses to blocks which have not previously been accessed are counted
+ * separately as cold accesses.
+ * The histogram is updated incrementally with a single hash table lookup per access.
+ */
+class CacheReuseHistogram {
+public:
+    static constexpr unsigned s_buckets = 32;
+
+    /**
+     * @brief The Outcome struct
+     * Records the changes made by an access, such that it may be reverted when the cache simulator is rolled back.
+     */
+    struct Outcome {
+        uint64_t previousAccess = 0;  // Access number (1-indexed) of the previous access to the block; 0 if cold
+        int bucket = -1;              // Bucket which was incremented; -1 if the access was cold
+    };
+
+    void reset();
+    Outcome access(uint64_t block);
+    void revert(uint64_t block, const Outcome& outcome);
+
+    const std::vector<uint64_t>& getBuckets() const { return m_buckets; }
+    uint64_t getColdAccesses() const { return m_coldAccesses; }
+    size_t getBytes() const { return m_lastAccess.getBytes() + m_buckets.size() * sizeof(uint64_t); }
+
+private:
+    uint64_t m_accessCount = 0;
+    OpenAddressingMap<uint64_t, uint64_t> m_lastAccess;
+    std::vector<uint64_t> m_buckets = std::vector<uint64_t>(s_buckets, 0);
+    uint64_t m_coldAccesses = 0;
+};
+
+/**
+ * @brief The CacheSetHeatMap class
+ * Per-set access and miss counters, used to identify sets under high pressure.
+ */
+class CacheSetHeatMap {
+public:
+    void reset(unsigned sets);
+    void record(unsigned setIdx, bool isHit, int delta);
+
+    const std::vector<unsigned>& getAccesses() const { return m_accesses; }
+    const std::vector<unsigned>& getMisses() const { return m_misses; }
+    unsigned getMaxMisses() const { return m_maxMisses; }
+
+private:
+    std::vector<unsigned> m_accesses;
+    std::vector<unsigned> m_misses;
+    unsigned m_maxMisses = 0;
+};
+
+}  // namespace Ripes
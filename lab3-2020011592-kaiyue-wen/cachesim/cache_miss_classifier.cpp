@@ -0,0 +1,97 @@
+#include "cache_miss_classifier.h"
+
+namespace Ripes {
+
+void CacheMissClassifier::reset(unsigned capacity) {
+    if (m_capacity != capacity) {
+        m_nodes = std::vector<Node>(capacity);
+        m_capacity = capacity;
+    }
+    m_blocks.clear();
+    m_used = 0;
+    m_head = s_noNode;
+    m_tail = s_noNode;
+}
+
+void CacheMissClassifier::unlink(uint32_t node) {
+    const Node& n = m_nodes[node];
+    (n.prev != s_noNode ? m_nodes[n.prev].next : m_head) = n.next;
+    (n.next != s_noNode ? m_nodes[n.next].prev : m_tail) = n.prev;
+}
+
+void CacheMissClassifier::link(uint32_t node, uint32_t next) {
+    const uint32_t prev = next != s_noNode ? m_nodes[next].prev : m_tail;
+    m_nodes[node].prev = prev;
+    m_nodes[node].next = next;
+    (prev != s_noNode ? m_nodes[prev].next : m_head) = node;
+    (next != s_noNode ? m_nodes[next].prev : m_tail) = node;
+}
+
+CacheMissClassifier::Outcome CacheMissClassifier::access(uint64_t block, bool allocate) {
+    Outcome outcome;
+    BlockState& state = m_blocks[block];
+    outcome.firstTouch = !state.seen;
+    state.seen = true;
+
+    if (state.node != s_noNode) {
+        // Shadow hit; move the block to the MRU position
+        outcome.shadowHit = true;
+        const uint32_t next = m_nodes[state.node].next;
+        if (next != s_noNode) {
+            outcome.hadSuccessor = true;
+            outcome.successor = m_nodes[next].block;
+        }
+        unlink(state.node);
+        link(state.node, m_head);
+        return outcome;
+    }
+
+    if (!allocate || m_capacity == 0) {
+        return outcome;
+    }
+
+    // Shadow miss; insert the block, evicting the LRU block if the shadow cache is full
+    uint32_t node = m_used;
+    if (m_used == m_capacity) {
+        node = m_tail;
+        outcome.evicted = true;
+        outcome.evictedBlock = m_nodes[node].block;
+        unlink(node);
+        m_blocks[outcome.evictedBlock].node = s_noNode;
+    } else {
+        m_used++;
+    }
+    // Looking up the evicted block may have grown the map, so the state of this block is looked up again
+    m_blocks[block].node = node;
+    m_nodes[node].block = block;
+    link(node, m_head);
+    outcome.inserted = true;
+    return outcome;
+}
+
+void CacheMissClassifier::revert(uint64_t block, const Outcome& outcome) {
+    BlockState& state = m_blocks[block];
+    if (outcome.shadowHit) {
+        // Move the block back in front of its previous successor
+        const uint32_t node = state.node;
+        unlink(node);
+        link(node, outcome.hadSuccessor ? m_blocks[outcome.successor].node : s_noNode);
+    } else if (outcome.inserted) {
+        const uint32_t node = state.node;
+        state.node = s_noNode;
+        unlink(node);
+        if (outcome.evicted) {
+            m_nodes[node].block = outcome.evictedBlock;
+            m_blocks[outcome.evictedBlock].node = node;
+            link(node, s_noNode);
+        } else {
+            m_used--;
+        }
+    }
+
+    if (outcome.firstTouch) {
+        m_blocks[block].seen = false;
+    }
+}
+
+}  // namespace Ripes
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "open_addressing_map.h"
+
+namespace Ripes {
+
+/**
+ * @brief The CacheMissClassifier class
+ * Classifies cache misses according to the 3C model. A block which has never been referenced before is a compulsory
+ * miss. Otherwise, the access is replayed in a shadow fully-associative LRU cache holding as many blocks as the
+ * simulated cache; a miss in the shadow cache is a capacity miss, whereas a hit in the shadow cache (but a miss in
+ * the simulated cache) is a conflict miss.
+ * The classifier operates on block addresses (ie. the address with the block- and byte offset bits removed).
+ *
+ * The recency list of the shadow cache is kept in a preallocated array of capacity nodes, linked by index, and the
+ * state of each referenced block in an OpenAddressingMap. Resetting the classifier clears the map and the list in
+ * constant time; the node array is only reallocated if the capacity changes.
+ */
+class CacheMissClassifier {
+public:
+    /**
+     * @brief The Outcome struct
+     * Result of a shadow access. Besides the classification itself, the outcome records the changes made to the
+     * shadow state, such that the access may be reverted when the cache simulator is rolled back.
+     */
+    struct Outcome {
+        bool firstTouch = false;  // True if the block has never been accessed before
+        bool shadowHit = false;   // True if the block was resident in the shadow fully-associative cache
+        bool inserted = false;    // True if the block was (re)inserted in the shadow cache
+        bool hadSuccessor = false;
+        uint64_t successor = 0;  // The block which was next in recency order before the block was moved to the front
+        bool evicted = false;
+        uint64_t evictedBlock = 0;
+    };
+
+    /**
+     * @brief reset
+     * Clears all classification state and resizes the shadow cache to hold @p capacity blocks.
+     */
+    void reset(unsigned capacity);
+
+    /**
+     * @brief access
+     * Performs an access to @p block in the shadow cache. If @p allocate is false, a missing block is not brought
+     * into the shadow cache (mirroring a write miss in a no-write-allocate cache).
+     */
+    Outcome access(uint64_t block, bool allocate);
+
+    /**
+     * @brief revert
+     * Reverts the most recent access to @p block, given the @p outcome returned by that access. Accesses must be
+     * reverted in the reverse order of which they were performed.
+     */
+    void revert(uint64_t block, const Outcome& outcome);
+
+    /**
+     * @brief getBytes
+     * @returns an estimate of the memory held by the classifier, which grows with the number of distinct blocks
+     * accessed.
+     */
+    size_t getBytes() const { return m_blocks.getBytes() + m_nodes.capacity() * sizeof(Node); }
+
+private:
+    static constexpr uint32_t s_noNode = static_cast<uint32_t>(-1);
+
+    struct BlockState {
+        bool seen = false;
+        uint32_t node = s_noNode;  // Node of the block in the recency list, if resident in the shadow cache
+    };
+    struct Node {
+        uint64_t block;
+        uint32_t prev;
+        uint32_t next;
+    };
+
+    void unlink(uint32_t node);
+    /**
+     * @brief link
+     * Links @p node into the recency list in front of @p next; at the back of the list if @p next is s_noNode.
+     */
+    void link(uint32_t node, uint32_t next);
+
+    unsigned m_capacity = 0;
+    OpenAddressingMap<BlockState, uint64_t> m_blocks;
+
+    // Shadow fully-associative LRU cache. The head of the list is the most recently used block. Nodes are allocated in
+    // order until all m_capacity nodes are in use, after which the node of the evicted block is reused.
+    std::vector<Node> m_nodes;
+    uint32_t m_used = 0;
+    uint32_t m_head = s_noNode;
+    uint32_t m_tail = s_noNode;
+};
+
+}  // namespace Ripes
@@ -0,0 +1,60 @@
+#include "cache_mshr.h"
+
+#include <algorithm>
+
+namespace Ripes {
+
+void CacheMshrFile::reset(unsigned registers) {
+    m_registers.assign(registers, Register());
+    m_now = 0;
+}
+
+CacheMshrFile::Outcome CacheMshrFile::access(uint64_t block, uint64_t cycle, bool allocate, unsigned latency,
+                                             unsigned missLatency) {
+    Outcome outcome;
+    outcome.oldNow = m_now;
+    m_now = std::max(m_now, cycle);
+
+    // Secondary miss; the data is available once the fill of the block completes. The block may be resident in the
+    // cache already, given that the cache simulator itself fills lines immediately.
+    for (const auto& reg : m_registers) {
+        if (reg.readyCycle > m_now && reg.block == block) {
+            outcome.merged = true;
+            outcome.latency = std::max(latency, static_cast<unsigned>(reg.readyCycle - m_now));
+            return outcome;
+        }
+    }
+
+    if (!allocate || m_registers.empty()) {
+        outcome.latency = allocate ? missLatency : latency;
+        return outcome;
+    }
+
+    // Primary miss; allocate the register which is (or becomes) free the earliest, stalling until it is free
+    const auto it = std::min_element(m_registers.begin(), m_registers.end(),
+                                     [](const Register& a, const Register& b) { return a.readyCycle < b.readyCycle; });
+    if (it->readyCycle > m_now) {
+        outcome.stallCycles = static_cast<unsigned>(it->readyCycle - m_now);
+        m_now = it->readyCycle;
+    }
+    outcome.allocated = true;
+    outcome.slot = static_cast<unsigned>(it - m_registers.begin());
+    outcome.oldBlock = it->block;
+    outcome.oldReadyCycle = it->readyCycle;
+    outcome.busyCycles = missLatency;
+    outcome.latency = outcome.stallCycles + missLatency;
+    it->block = block;
+    it->readyCycle = m_now + missLatency;
+    return outcome;
+}
+
+void CacheMshrFile::revert(const Outcome& outcome) {
+    if (outcome.allocated) {
+        auto& reg = m_registers.at(outcome.slot);
+        reg.block = outcome.oldBlock;
+        reg.readyCycle = outcome.oldReadyCycle;
+    }
+    m_now = outcome.oldNow;
+}
+
+}  // namespace Ripes
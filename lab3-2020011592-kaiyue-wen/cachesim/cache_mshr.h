@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Ripes {
+
+/**
+ * @brief The CacheMshrFile class
+ * Miss status holding registers of a non-blocking cache. Each register tracks a block which is being filled from the
+ * next level of the memory hierarchy, until the cycle in which the fill completes. Misses to a block which is already
+ * in flight (secondary misses) merge into its register, whereas a primary miss allocates a register; if all registers
+ * are in use, the miss stalls until the earliest fill completes.
+ *
+ * The file keeps its own notion of time, which is advanced to the cycle of each access and by each stall. Thus, stalls
+ * are accounted for even if the processor model does not act upon them.
+ * The file operates on sector addresses (see CacheSim::getSectorAddress), since a sectored cache fills a sector at a
+ * time; without sectoring, these are the block addresses.
+ */
+class CacheMshrFile {
+public:
+    /**
+     * @brief The Outcome struct
+     * Timing of an access, and the register state it replaced (for revert()).
+     */
+    struct Outcome {
+        unsigned latency = 0;      // Cycles until the data of the access is available
+        unsigned stallCycles = 0;  // Cycles spent waiting for a free register
+        bool merged = false;       // True if the access merged into a register of a block in flight
+        bool allocated = false;    // True if the access allocated a register
+        unsigned busyCycles = 0;   // Cycles for which the allocated register is occupied
+
+        unsigned slot = 0;
+        uint64_t oldBlock = 0;
+        uint64_t oldReadyCycle = 0;
+        uint64_t oldNow = 0;
+    };
+
+    /**
+     * @brief reset
+     * Clears all registers and resizes the file to @p registers registers. With 0 registers, the cache is blocking.
+     */
+    void reset(unsigned registers);
+    bool isNonBlocking() const { return !m_registers.empty(); }
+
+    /**
+     * @brief access
+     * Performs an access to @p block in @p cycle. @p allocate is true if the access misses and fills a line, after
+     * @p missLatency cycles. Other accesses complete after @p latency cycles, unless the block is in flight.
+     */
+    Outcome access(uint64_t block, uint64_t cycle, bool allocate, unsigned latency, unsigned missLatency);
+
+    /**
+     * @brief revert
+     * Reverts the most recent access not yet reverted, which returned @p outcome.
+     */
+    void revert(const Outcome& outcome);
+
+private:
+    struct Register {
+        uint64_t block = 0;
+        uint64_t readyCycle = 0;  // The register is free once the current cycle reaches the ready cycle
+    };
+
+    std::vector<Register> m_registers;
+    uint64_t m_now = 0;
+};
+
+}  // namespace Ripes
@@ -8,10 +8,13 @@
 namespace Ripes {
 
 struct CacheWay {
-    uint32_t tag = -1;
+    uint64_t tag = -1;
     std::set<unsigned> dirtyBlocks;
     bool dirty = false;
     bool valid = false;
+    // Valid bits of the sectors of the line; bit i is set if sector i has been filled. A line which is not sectored
+    // consists of a single sector.
+    uint32_t validSectors = 0;
 
     // LRU algorithm relies on invalid cache ways to have an initial high value. -1 ensures maximum value for all
     // way sizes.
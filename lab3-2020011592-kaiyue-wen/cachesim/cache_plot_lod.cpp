@@ -0,0 +1,94 @@
+#include "cache_plot_lod.h"
+
+#include <algorithm>
+
+namespace Ripes {
+
+void SeriesPyramid::build(std::vector<double> x, std::vector<double> y) {
+    m_x = std::move(x);
+    m_y = std::move(y);
+    m_levels.clear();
+
+    // The first level summarizes the points of the series; each following level summarizes the level below it
+    std::vector<Bucket> points(m_x.size());
+    for (uint32_t i = 0; i < points.size(); i++) {
+        points[i] = {i, i};
+    }
+    const std::vector<Bucket>* below = &points;
+    while (below->size() > 1) {
+        std::vector<Bucket> level((below->size() + s_fanout - 1) / s_fanout);
+        for (size_t b = 0; b < level.size(); b++) {
+            Bucket bucket = (*below)[b * s_fanout];
+            const size_t end = std::min(below->size(), (b + 1) * s_fanout);
+            for (size_t i = b * s_fanout + 1; i < end; i++) {
+                const Bucket& child = (*below)[i];
+                if (m_y[child.minIdx] < m_y[bucket.minIdx]) {
+                    bucket.minIdx = child.minIdx;
+                }
+                if (m_y[child.maxIdx] > m_y[bucket.maxIdx]) {
+                    bucket.maxIdx = child.maxIdx;
+                }
+            }
+            level[b] = bucket;
+        }
+        m_levels.push_back(std::move(level));
+        below = &m_levels.back();
+    }
+}
+
+void SeriesPyramid::query(double xMin, double xMax, unsigned buckets, std::vector<uint32_t>& indices) const {
+    indices.clear();
+    if (m_x.empty()) {
+        return;
+    }
+
+    // Index range [lo; hi] of points to consider, including the nearest point on either side of the x range
+    const size_t first = std::lower_bound(m_x.begin(), m_x.end(), xMin) - m_x.begin();
+    const size_t last = std::upper_bound(m_x.begin(), m_x.end(), xMax) - m_x.begin();
+    const uint32_t lo = first > 0 ? first - 1 : 0;
+    const uint32_t hi = std::min(last, m_x.size() - 1);
+    if (hi < lo) {
+        return;
+    }
+
+    buckets = std::max(buckets, 1u);
+    const uint64_t count = hi - lo + 1;
+    if (count <= 2ull * buckets) {
+        for (uint32_t i = lo; i <= hi; i++) {
+            indices.push_back(i);
+        }
+        return;
+    }
+
+    // Select the coarsest level which provides at least the requested number of buckets
+    size_t levelIdx = 0;
+    uint64_t bucketSize = s_fanout;
+    while (levelIdx + 1 < m_levels.size() && count / (bucketSize * s_fanout) >= buckets) {
+        levelIdx++;
+        bucketSize *= s_fanout;
+    }
+    const auto& level = m_levels[levelIdx];
+
+    auto push = [&](uint32_t idx) {
+        if (indices.empty() || indices.back() < idx) {
+            indices.push_back(idx);
+        }
+    };
+
+    push(lo);
+    for (uint64_t b = lo / bucketSize; b <= hi / bucketSize; b++) {
+        const Bucket& bucket = level[b];
+        // Buckets at the edges of the range may extend beyond it; only their in-range extrema are drawn
+        const uint32_t a = std::min(bucket.minIdx, bucket.maxIdx);
+        const uint32_t c = std::max(bucket.minIdx, bucket.maxIdx);
+        if (a > lo && a < hi) {
+            push(a);
+        }
+        if (c > lo && c < hi) {
+            push(c);
+        }
+    }
+    push(hi);
+}
+
+}  // namespace Ripes
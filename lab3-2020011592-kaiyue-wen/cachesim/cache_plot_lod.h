@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Ripes {
+
+/**
+ * @brief The SeriesPyramid class
+ * Multi-resolution min/max summary of a plot series, used to draw series of millions of points at the resolution of
+ * the screen. Level i of the pyramid summarizes buckets of s_fanout^(i+1) consecutive points by the indices of their
+ * minimum and maximum values. A query for an x range selects the coarsest level which still yields at least the
+ * requested number of buckets, and returns the extrema of each bucket. As such, the cost of a query is proportional
+ * to the number of requested buckets and not the length of the series, and no peak nor dip is lost in downsampling.
+ */
+class SeriesPyramid {
+public:
+    static constexpr unsigned s_fanout = 4;
+
+    /**
+     * @brief build
+     * Builds the pyramid over the series (@p x, @p y). @p x must be non-decreasing.
+     */
+    void build(std::vector<double> x, std::vector<double> y);
+
+    /**
+     * @brief query
+     * Sets @p indices to the sorted indices of the points to draw for the x range [@p xMin; @p xMax], using roughly
+     * @p buckets buckets. The nearest points outside the range are included, such that the series continues to the
+     * edges of the plot.
+     */
+    void query(double xMin, double xMax, unsigned buckets, std::vector<uint32_t>& indices) const;
+
+    size_t size() const { return m_x.size(); }
+    double x(uint32_t idx) const { return m_x[idx]; }
+    double y(uint32_t idx) const { return m_y[idx]; }
+
+private:
+    struct Bucket {
+        uint32_t minIdx;
+        uint32_t maxIdx;
+    };
+
+    std::vector<double> m_x;
+    std::vector<double> m_y;
+    std::vector<std::vector<Bucket>> m_levels;
+};
+
+}  // namespace Ripes
@@ -1,5 +1,6 @@
 #include "cache_policy_object.h"
 #include "cache_organize_component.h"
+#include "cache_tracepoints.h"
 #include <iostream>
 
 
@@ -8,7 +9,7 @@ namespace Ripes {
 
 void RandomPolicy::locateEvictionWay(std::pair<unsigned, CacheWay*>& ew,
                                      CacheSet& cacheSet, unsigned setIdx) {
-    ew.first = std::rand() % ways;
+    ew.first = engine() % ways;
     ew.second = &cacheSet[ew.first];
 }
 
@@ -199,14 +200,13 @@ void DipPolicy::updateCacheSetReplFields(CacheSet &cacheSet, unsigned int setIdx
             liphit += 1;
         }
     }
-    // printf("%d %d %d %d %d\n",counter, lipall, lruall,liphit,lruhit);
     if(counter == 100000){
         counter = 0;
         double one = 1.0;
         double lrurate = (lruall > 0) ? (lruhit*one)/lruall :0;
         double liprate = (lipall > 0) ? (liphit*one)/lipall :0;
         lru = (lrurate > liprate);
-        // printf("%f %f\n",lrurate,liprate);
+        CACHE_TRACEPOINT(DipSwitch, lru, lrurate * 1e6, liprate * 1e6);
         lruall = 0;
         lruhit = 0;
         lipall = 0;
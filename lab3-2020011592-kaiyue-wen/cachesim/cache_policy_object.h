@@ -3,6 +3,7 @@
 
 #include "cache_organize_component.h"
 #include <iostream>
+#include <random>
 
 namespace Ripes {
 
@@ -13,6 +14,13 @@ public:
     virtual void locateEvictionWay(std::pair<unsigned, CacheWay*>& ew, CacheSet& cacheSet, unsigned setIdx) = 0;
     virtual void updateCacheSetReplFields(CacheSet& cacheSet, unsigned int setIdx, unsigned wayIdx, bool isHit) = 0;
     virtual void revertCacheSetReplFields(CacheSet& cacheSet, const CacheWay& oldWay, unsigned wayIdx) = 0;
+    // Copy of the policy, including any state kept outside of the cache sets
+    virtual CachePolicyBase* clone() const = 0;
+    // Resets any state kept outside of the cache sets, as upon creating the policy
+    virtual void reset() {}
+    bool hasGeometry(int number_ways, int number_sets, int number_blocks) const {
+        return ways == number_ways && sets == number_sets && blocks == number_blocks;
+    }
     virtual ~CachePolicyBase() {}
 protected:
     int ways;
@@ -26,7 +34,13 @@ public:
     void locateEvictionWay(std::pair<unsigned, CacheWay*>& ew, CacheSet& cacheSet, unsigned setIdx) override;
     void updateCacheSetReplFields(CacheSet& cacheSet, unsigned int setIdx, unsigned wayIdx, bool isHit) override;
     void revertCacheSetReplFields(CacheSet& cacheSet, const CacheWay& oldWay, unsigned wayIdx) override;
+    CachePolicyBase* clone() const override { return new RandomPolicy(*this); }
+    void reset() override { engine.seed(); }
     ~RandomPolicy() {}
+private:
+    // Owned by the policy, such that clones and snapshots replay the same evictions and caches on different threads
+    // do not share state
+    std::minstd_rand engine;
 };
 
 
@@ -36,6 +50,7 @@ public:
     void locateEvictionWay(std::pair<unsigned, CacheWay*>& ew, CacheSet& cacheSet, unsigned setIdx) override;
     void updateCacheSetReplFields(CacheSet& cacheSet, unsigned int setIdx, unsigned wayIdx, bool isHit) override;
     void revertCacheSetReplFields(CacheSet& cacheSet, const CacheWay& oldWay, unsigned wayIdx) override;
+    CachePolicyBase* clone() const override { return new LruPolicy(*this); }
     ~LruPolicy() {}
 };
 
@@ -46,6 +61,7 @@ public:
     void locateEvictionWay(std::pair<unsigned, CacheWay*>& ew, CacheSet& cacheSet, unsigned setIdx) override;
     void updateCacheSetReplFields(CacheSet& cacheSet, unsigned int setIdx, unsigned wayIdx, bool isHit) override;
     void revertCacheSetReplFields(CacheSet& cacheSet, const CacheWay& oldWay, unsigned wayIdx) override;
+    CachePolicyBase* clone() const override { return new LruLipPolicy(*this); }
     ~LruLipPolicy() {}
 };
 
@@ -55,6 +71,8 @@ public:
     void locateEvictionWay(std::pair<unsigned, CacheWay*>& ew, CacheSet& cacheSet, unsigned setIdx) override;
     void updateCacheSetReplFields(CacheSet& cacheSet, unsigned int setIdx, unsigned wayIdx, bool isHit) override;
     void revertCacheSetReplFields(CacheSet& cacheSet, const CacheWay& oldWay, unsigned wayIdx) override;
+    CachePolicyBase* clone() const override { return new DipPolicy(*this); }
+    void reset() override { *this = DipPolicy(ways, sets, blocks); }
     ~DipPolicy() {}
 private:
     unsigned lruhit = 0;
@@ -72,6 +90,7 @@ public:
     void locateEvictionWay(std::pair<unsigned, CacheWay*>& ew, CacheSet& cacheSet, unsigned setIdx) override;
     void updateCacheSetReplFields(CacheSet& cacheSet, unsigned int setIdx, unsigned wayIdx, bool isHit) override;
     void revertCacheSetReplFields(CacheSet& cacheSet, const CacheWay& oldWay, unsigned wayIdx) override;
+    CachePolicyBase* clone() const override { return new PlruPolicy(*this); }
     ~PlruPolicy() {}
 };
 
@@ -0,0 +1,246 @@
+#include "cache_stats_exporter.h"
+
+#include <cerrno>
+#include <cstring>
+
+namespace Ripes {
+
+namespace {
+
+// Number of unsigned and floating point columns which are always present
+constexpr unsigned s_uintColumns = 15;
+constexpr unsigned s_floatColumns = 8;
+
+}  // namespace
+
+CacheStatsExporter::CacheStatsExporter(Format format, unsigned windowSize)
+    : m_format(format), m_windowSize(windowSize) {
+    m_columns = {{"cycle", ColumnType::UInt32},
+                 {"accesses", ColumnType::UInt32},
+                 {"hits", ColumnType::UInt32},
+                 {"misses", ColumnType::UInt32},
+                 {"reads", ColumnType::UInt32},
+                 {"writes", ColumnType::UInt32},
+                 {"writebacks", ColumnType::UInt32},
+                 {"compulsory_misses", ColumnType::UInt32},
+                 {"capacity_misses", ColumnType::UInt32},
+                 {"conflict_misses", ColumnType::UInt32},
+                 {"sector_misses", ColumnType::UInt32},
+                 {"mshr_allocations", ColumnType::UInt32},
+                 {"mshr_merges", ColumnType::UInt32},
+                 {"write_buffer_writes", ColumnType::UInt32},
+                 {"write_buffer_transactions", ColumnType::UInt32},
+                 {"hit_rate", ColumnType::Float64},
+                 {"latency_cycles", ColumnType::Float64},
+                 {"stall_cycles", ColumnType::Float64},
+                 {"amat", ColumnType::Float64},
+                 {"mshr_busy_cycles", ColumnType::Float64},
+                 {"write_buffer_stall_cycles", ColumnType::Float64},
+                 {"fill_bytes", ColumnType::Float64},
+                 {"writeback_bytes", ColumnType::Float64}};
+    if (m_windowSize != 0) {
+        m_columns.push_back({"window_accesses", ColumnType::UInt32});
+        m_columns.push_back({"window_hits", ColumnType::UInt32});
+        m_columns.push_back({"window_hit_rate", ColumnType::Float64});
+    }
+}
+
+bool CacheStatsExporter::write(const CacheSim::AccessTrace& trace, const std::string& path) {
+    m_error.clear();
+    std::FILE* file = std::fopen(path.c_str(), m_format == Format::Binary ? "wb" : "w");
+    if (file == nullptr) {
+        m_error = "Could not open '" + path + "': " + std::strerror(errno);
+        return false;
+    }
+
+    const unsigned uintColumns = s_uintColumns + (m_windowSize != 0 ? 2 : 0);
+    const unsigned floatColumns = s_floatColumns + (m_windowSize != 0 ? 1 : 0);
+    m_uintColumns.assign(uintColumns, std::vector<uint32_t>());
+    m_floatColumns.assign(floatColumns, std::vector<double>());
+    for (auto& column : m_uintColumns) {
+        column.reserve(s_chunkRows);
+    }
+    for (auto& column : m_floatColumns) {
+        column.reserve(s_chunkRows);
+    }
+    m_text.clear();
+    m_chunkRows = 0;
+
+    writeHeader(file);
+
+    // Cumulative accesses and hits preceding each of the entries within the moving window
+    Window window = {{0, 0}};
+
+    uint32_t u[s_uintColumns + 2];
+    double f[s_floatColumns + 1];
+    for (const auto& [cycle, entry] : trace) {
+        computeRow(cycle, entry, window, u, f);
+        if (m_format == Format::Binary) {
+            for (unsigned i = 0; i < uintColumns; i++) {
+                m_uintColumns[i].push_back(u[i]);
+            }
+            for (unsigned i = 0; i < floatColumns; i++) {
+                m_floatColumns[i].push_back(f[i]);
+            }
+        } else {
+            appendTextRow(u, f, ',', m_text);
+        }
+
+        if (++m_chunkRows == s_chunkRows) {
+            flushChunk(file);
+        }
+    }
+    flushChunk(file);
+    if (m_format == Format::Binary) {
+        // Terminating chunk
+        flushChunk(file);
+    }
+
+    const bool failed = std::ferror(file) != 0;
+    if (std::fclose(file) != 0 || failed) {
+        m_error = "Error while writing '" + path + "'";
+        return false;
+    }
+    return true;
+}
+
+bool CacheStatsExporter::writeText(const CacheSim::AccessTrace& trace, unsigned firstCycle, unsigned lastCycle,
+                                   size_t maxRows, char separator, std::string& text) {
+    appendTextHeader(separator, text);
+    Window window = {{0, 0}};
+    uint32_t u[s_uintColumns + 2];
+    double f[s_floatColumns + 1];
+    size_t rows = 0;
+    for (const auto& [cycle, entry] : trace) {
+        if (cycle > lastCycle) {
+            break;
+        }
+        // Preceding rows are computed for the moving window, but not written
+        computeRow(cycle, entry, window, u, f);
+        if (cycle < firstCycle) {
+            continue;
+        }
+        if (rows++ == maxRows) {
+            return false;
+        }
+        appendTextRow(u, f, separator, text);
+    }
+    return true;
+}
+
+void CacheStatsExporter::computeRow(unsigned cycle, const CacheSim::CacheAccessTrace& entry, Window& window,
+                                    uint32_t* u, double* f) const {
+    const uint32_t accesses = entry.hits + entry.misses;
+    u[0] = cycle;
+    u[1] = accesses;
+    u[2] = entry.hits;
+    u[3] = entry.misses;
+    u[4] = entry.reads;
+    u[5] = entry.writes;
+    u[6] = entry.writebacks;
+    u[7] = entry.compulsoryMisses;
+    u[8] = entry.capacityMisses;
+    u[9] = entry.conflictMisses;
+    u[10] = entry.sectorMisses;
+    u[11] = entry.mshrAllocations;
+    u[12] = entry.mshrMerges;
+    u[13] = entry.writeBufferWrites;
+    u[14] = entry.writeBufferTransactions;
+    f[0] = accesses == 0 ? 0 : static_cast<double>(entry.hits) / accesses;
+    // Cumulative cycle counts may exceed 32 bits, and are exported as (exactly representable) doubles
+    f[1] = static_cast<double>(entry.latency);
+    f[2] = static_cast<double>(entry.stallCycles);
+    f[3] = accesses == 0 ? 0 : f[1] / accesses;
+    f[4] = static_cast<double>(entry.mshrBusyCycles);
+    f[5] = static_cast<double>(entry.writeBufferStallCycles);
+    f[6] = static_cast<double>(entry.fillBytes);
+    f[7] = static_cast<double>(entry.writebackBytes);
+    if (m_windowSize != 0) {
+        const auto start = window.front();
+        u[15] = accesses - start.first;
+        u[16] = entry.hits - start.second;
+        f[8] = u[15] == 0 ? 0 : static_cast<double>(u[16]) / u[15];
+        window.emplace_back(accesses, entry.hits);
+        if (window.size() > m_windowSize) {
+            window.pop_front();
+        }
+    }
+}
+
+void CacheStatsExporter::appendTextHeader(char separator, std::string& text) const {
+    for (unsigned c = 0; c < m_columns.size(); c++) {
+        if (c != 0) {
+            text += separator;
+        }
+        text += m_columns[c].name;
+    }
+    text += '\n';
+}
+
+void CacheStatsExporter::appendTextRow(const uint32_t* u, const double* f, char separator, std::string& text) const {
+    // Columns are written in the order of m_columns; floating point columns follow their unsigned columns
+    char buffer[32];
+    unsigned ui = 0, fi = 0;
+    for (unsigned c = 0; c < m_columns.size(); c++) {
+        if (m_columns[c].type == ColumnType::UInt32) {
+            std::snprintf(buffer, sizeof(buffer), "%u", u[ui++]);
+        } else {
+            std::snprintf(buffer, sizeof(buffer), "%.6f", f[fi++]);
+        }
+        if (c != 0) {
+            text += separator;
+        }
+        text += buffer;
+    }
+    text += '\n';
+}
+
+void CacheStatsExporter::writeHeader(std::FILE* file) {
+    const uint32_t samplingRatio = 1u << m_sampleBits;
+    if (m_format == Format::CSV) {
+        if (m_sampleBits != 0) {
+            std::fprintf(file, "# sampled: 1 in %u sets\n", samplingRatio);
+        }
+        std::string header;
+        appendTextHeader(',', header);
+        std::fputs(header.c_str(), file);
+        return;
+    }
+
+    const uint32_t version = 2;
+    const uint32_t columns = m_columns.size();
+    std::fwrite("RCST", 1, 4, file);
+    std::fwrite(&version, sizeof(version), 1, file);
+    std::fwrite(&samplingRatio, sizeof(samplingRatio), 1, file);
+    std::fwrite(&columns, sizeof(columns), 1, file);
+    for (const auto& column : m_columns) {
+        const uint8_t type = static_cast<uint8_t>(column.type);
+        const uint8_t length = std::strlen(column.name);
+        std::fwrite(&type, 1, 1, file);
+        std::fwrite(&length, 1, 1, file);
+        std::fwrite(column.name, 1, length, file);
+    }
+}
+
+void CacheStatsExporter::flushChunk(std::FILE* file) {
+    if (m_format == Format::CSV) {
+        std::fwrite(m_text.data(), 1, m_text.size(), file);
+        m_text.clear();
+    } else {
+        const uint32_t rows = m_chunkRows;
+        std::fwrite(&rows, sizeof(rows), 1, file);
+        unsigned ui = 0, fi = 0;
+        for (const auto& column : m_columns) {
+            if (column.type == ColumnType::UInt32) {
+                std::fwrite(m_uintColumns[ui].data(), sizeof(uint32_t), rows, file);
+                m_uintColumns[ui++].clear();
+            } else {
+                std::fwrite(m_floatColumns[fi].data(), sizeof(double), rows, file);
+                m_floatColumns[fi++].clear();
+            }
+        }
+    }
+    m_chunkRows = 0;
+}
+
+}  // namespace Ripes
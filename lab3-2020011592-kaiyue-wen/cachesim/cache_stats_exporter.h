@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "cachesim.h"
+
+namespace Ripes {
+
+/**
+ * @brief The CacheStatsExporter class
+ * Streams the access statistics timeline of a cache simulator to a file. The timeline is written in chunks of
+ * s_chunkRows rows, such that memory usage is independent of the length of the timeline.
+ *
+ * Each row contains the cycle and the cumulative counters of an access trace entry, the cumulative hit rate, the
+ * cumulative latency, stall cycles, MSHR and write buffer usage of the timing model, the resulting AMAT, the traffic
+ * to and from the next level in bytes and, optionally, the number of accesses and hits within a moving window over
+ * the last @p windowSize entries.
+ *
+ * Statistics of a cache simulator with set sampling cover the sampled sets only, which is recorded in the export.
+ *
+ * Two formats are supported:
+ * - CSV: a header line with the column names followed by a line per row. Sampled exports are preceded by a comment
+ *   line "# sampled: 1 in N sets".
+ * - Binary: a columnar format; a header followed by a sequence of chunks. All values are little-endian.
+ *     header:  "RCST", uint32 version (2), uint32 sampling ratio N (1 in N sets; 1 if not sampled),
+ *              uint32 column count, and per column: uint8 type (0: uint32, 1: float64), uint8 name length, name
+ *     chunk:   uint32 row count, followed by the values of each column in turn as a contiguous array
+ *   The last chunk has a row count of 0.
+ */
+class CacheStatsExporter {
+public:
+    enum class Format { CSV, Binary };
+    static constexpr unsigned s_chunkRows = 4096;
+
+    CacheStatsExporter(Format format, unsigned windowSize = 0);
+
+    /**
+     * @brief write
+     * Writes @p trace to the file at @p path. @returns false, and sets the error string, if the export failed.
+     */
+    bool write(const CacheSim::AccessTrace& trace, const std::string& path);
+    const std::string& errorString() const { return m_error; }
+
+    /**
+     * @brief writeText
+     * Writes the header line and the rows of @p trace with a cycle in [@p firstCycle; @p lastCycle] to @p text, in the
+     * CSV format with @p separator separating the columns. At most @p maxRows rows are written, such that the text
+     * remains bounded for long timelines. @returns false if rows within the range were left out.
+     */
+    bool writeText(const CacheSim::AccessTrace& trace, unsigned firstCycle, unsigned lastCycle, size_t maxRows,
+                   char separator, std::string& text);
+
+    /**
+     * @brief setSampleBits
+     * Marks the exported statistics as covering only 1 in 2^@p sampleBits sets.
+     */
+    void setSampleBits(unsigned sampleBits) { m_sampleBits = sampleBits; }
+
+private:
+    enum class ColumnType : uint8_t { UInt32, Float64 };
+    struct Column {
+        const char* name;
+        ColumnType type;
+    };
+
+    using Window = std::deque<std::pair<uint32_t, uint32_t>>;
+
+    void writeHeader(std::FILE* file);
+    void flushChunk(std::FILE* file);
+    /**
+     * @brief computeRow
+     * Computes the unsigned (@p u) and floating point (@p f) columns of the row of @p entry, and advances the moving
+     * @p window past it.
+     */
+    void computeRow(unsigned cycle, const CacheSim::CacheAccessTrace& entry, Window& window, uint32_t* u,
+                    double* f) const;
+    void appendTextHeader(char separator, std::string& text) const;
+    void appendTextRow(const uint32_t* u, const double* f, char separator, std::string& text) const;
+
+    Format m_format;
+    unsigned m_windowSize;
+    unsigned m_sampleBits = 0;
+    std::vector<Column> m_columns;
+    std::string m_error;
+
+    // Buffered rows of the current chunk. Binary chunks are buffered per column; CSV chunks as text.
+    unsigned m_chunkRows = 0;
+    std::vector<std::vector<uint32_t>> m_uintColumns;
+    std::vector<std::vector<double>> m_floatColumns;
+    std::string m_text;
+};
+
+}  // namespace Ripes
@@ -0,0 +1,100 @@
+#include "cache_symbol_attribution.h"
+
+#include <algorithm>
+
+#include "radix.h"
+
+namespace Ripes {
+
+void CacheSymbolAttribution::build(const std::map<uint32_t, QString>& symbols,
+                                   const std::vector<SectionRange>& sections) {
+    m_intervals.clear();
+
+    // Symbols are iterated in address order; each symbol ends where the next symbol begins, or at the end of the
+    // section which contains it.
+    for (auto it = symbols.begin(); it != symbols.end(); ++it) {
+        const auto section = std::find_if(sections.begin(), sections.end(), [&](const SectionRange& range) {
+            return it->first >= range.start && it->first <= range.end;
+        });
+        if (section == sections.end()) {
+            // Symbols outside any loaded section (ie. absolute symbols) cannot be accessed
+            continue;
+        }
+
+        uint32_t end = section->end;
+        const auto next = std::next(it);
+        if (next != symbols.end() && next->first - 1 < end) {
+            end = next->first - 1;
+        }
+        if (end < it->first) {
+            // Aliased symbol; the next symbol starts at the same address
+            continue;
+        }
+        m_intervals.push_back({it->first, end, it->second});
+    }
+
+    reset();
+}
+
+void CacheSymbolAttribution::setStackRegion(const MemoryRegion& region, unsigned granuleBytes) {
+    m_stackRegion = region;
+    m_stackGranuleBits = 0;
+    while ((2u << m_stackGranuleBits) <= granuleBytes) {
+        m_stackGranuleBits++;
+    }
+    m_stackCounters.clear();
+}
+
+void CacheSymbolAttribution::reset() {
+    m_symbolCounters.assign(m_intervals.size(), AccessCounters());
+    m_stackCounters.clear();
+    m_unresolvedCounters = AccessCounters();
+}
+
+int CacheSymbolAttribution::resolve(uint64_t address) const {
+    // Locate the last interval starting at or before the address
+    auto it = std::upper_bound(m_intervals.begin(), m_intervals.end(), address,
+                               [](uint64_t addr, const SymbolInterval& interval) { return addr < interval.start; });
+    if (it == m_intervals.begin()) {
+        return -1;
+    }
+    --it;
+    return address <= it->end ? static_cast<int>(it - m_intervals.begin()) : -1;
+}
+
+void CacheSymbolAttribution::record(uint64_t address, bool isHit, bool isWriteback, int delta) {
+    const int symbolIdx = resolve(address);
+    if (symbolIdx >= 0) {
+        m_symbolCounters[symbolIdx].apply(isHit, isWriteback, delta);
+    } else if (address >= m_stackRegion.start && address <= m_stackRegion.end) {
+        m_stackCounters[address >> m_stackGranuleBits].apply(isHit, isWriteback, delta);
+    } else {
+        m_unresolvedCounters.apply(isHit, isWriteback, delta);
+    }
+}
+
+std::vector<std::pair<QString, AccessCounters>> CacheSymbolAttribution::getCounters() const {
+    std::vector<std::pair<QString, AccessCounters>> counters;
+    for (unsigned i = 0; i < m_intervals.size(); i++) {
+        if (m_symbolCounters[i].accesses > 0) {
+            counters.push_back({m_intervals[i].name, m_symbolCounters[i]});
+        }
+    }
+
+    m_stackCounters.forEach([&](uint64_t granule, const AccessCounters& granuleCounters) {
+        if (granuleCounters.accesses == 0) {
+            return;
+        }
+        const int64_t offset = static_cast<int64_t>(granule << m_stackGranuleBits) - s_stackPointerInit;
+        const QString label = "sp" + QString(offset < 0 ? "-" : "+") +
+                              encodeRadixValue(static_cast<uint32_t>(offset < 0 ? -offset : offset), Radix::Hex);
+        counters.push_back({label, granuleCounters});
+    });
+
+    if (m_unresolvedCounters.accesses > 0) {
+        counters.push_back({"<unresolved>", m_unresolvedCounters});
+    }
+    return counters;
+}
+
+}  // namespace Ripes
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <QString>
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "cache_attribution.h"
+#include "open_addressing_map.h"
+
+namespace Ripes {
+
+/**
+ * @brief The CacheSymbolAttribution class
+ * Attributes cache accesses to the symbols (functions and global data structures) of the loaded program. Each symbol
+ * is assumed to extend from its address up until the next symbol, or the end of the section which contains it.
+ * Symbol intervals are kept in a sorted vector which is built once when a program is loaded, such that each access is
+ * resolved through a binary search. Accesses to the stack, which has no symbols, are attributed to their offset from
+ * the initial stack pointer.
+ */
+class CacheSymbolAttribution {
+public:
+    /// Initial value of the stack pointer in the default memory layout of the simulator
+    static constexpr uint32_t s_stackPointerInit = 0x7ffffff0;
+
+    struct SymbolInterval {
+        uint32_t start;
+        uint32_t end;  // Inclusive
+        QString name;
+    };
+
+    struct SectionRange {
+        uint32_t start;
+        uint32_t end;  // Inclusive
+    };
+
+    /**
+     * @brief build
+     * Rebuilds the symbol interval index from the @p symbols of a program with the sections @p sections. All counters
+     * are cleared.
+     */
+    void build(const std::map<uint32_t, QString>& symbols, const std::vector<SectionRange>& sections);
+
+    /**
+     * @brief setStackRegion
+     * Sets the address range which is considered to be the stack. Accesses within this range which do not resolve to
+     * a symbol are bucketed by their offset from the initial stack pointer, in granules of @p granuleBytes bytes.
+     */
+    void setStackRegion(const MemoryRegion& region, unsigned granuleBytes);
+
+    void record(uint64_t address, bool isHit, bool isWriteback, int delta);
+    void reset();
+
+    /**
+     * @brief resolve
+     * @returns the index of the symbol interval containing @p address, or -1 if no symbol contains the address.
+     */
+    int resolve(uint64_t address) const;
+
+    /**
+     * @brief getCounters
+     * @returns a (label, counters) pair for each symbol, stack granule and unresolved address bucket which has been
+     * accessed.
+     */
+    std::vector<std::pair<QString, AccessCounters>> getCounters() const;
+    size_t getBytes() const {
+        return m_intervals.size() * sizeof(SymbolInterval) + m_symbolCounters.size() * sizeof(AccessCounters) +
+               m_stackCounters.getBytes();
+    }
+
+private:
+    std::vector<SymbolInterval> m_intervals;
+    std::vector<AccessCounters> m_symbolCounters;
+
+    MemoryRegion m_stackRegion = {"Stack", 0x70000000, 0xFFFFFFFF};
+    unsigned m_stackGranuleBits = 2;
+    OpenAddressingMap<AccessCounters, uint64_t> m_stackCounters;
+
+    AccessCounters m_unresolvedCounters;
+};
+
+}  // namespace Ripes
@@ -0,0 +1,249 @@
+#include "cache_trace_capture.h"
+
+#include <cerrno>
+#include <cstring>
+
+namespace Ripes {
+
+namespace {
+
+constexpr char s_magic[4] = {'R', 'C', 'A', 'T'};
+constexpr uint32_t s_version = 2;
+constexpr long s_headerBytes = 16;
+
+// Flags byte followed by three 64-bit varints (10 bytes each) and the size
+constexpr unsigned s_maxRecordBytes = 1 + 3 * 10 + 5;
+
+enum RecordFlags : uint8_t { KindMask = 0x3, Write = 1 << 2, HasPC = 1 << 3, HasSize = 1 << 4 };
+
+uint64_t zigzag(uint64_t delta) {
+    return (delta << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(delta) >> 63);
+}
+
+uint64_t unzigzag(uint64_t value) {
+    return (value >> 1) ^ (~(value & 1) + 1);
+}
+
+uint8_t* putVarint(uint8_t* out, uint64_t value) {
+    while (value >= 0x80) {
+        *out++ = static_cast<uint8_t>(value) | 0x80;
+        value >>= 7;
+    }
+    *out++ = static_cast<uint8_t>(value);
+    return out;
+}
+
+void putUint32(std::FILE* file, uint32_t value) {
+    const uint8_t bytes[4] = {static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8),
+                              static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 24)};
+    std::fwrite(bytes, 1, sizeof(bytes), file);
+}
+
+uint32_t getUint32(const uint8_t* bytes) {
+    return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+}
+
+}  // namespace
+
+CacheTraceWriter::~CacheTraceWriter() {
+    close();
+}
+
+bool CacheTraceWriter::open(const std::string& path, Source source) {
+    close();
+    m_error.clear();
+    m_file = std::fopen(path.c_str(), "wb");
+    if (m_file == nullptr) {
+        m_error = "Could not open '" + path + "': " + std::strerror(errno);
+        return false;
+    }
+    m_path = path;
+
+    std::fwrite(s_magic, 1, sizeof(s_magic), m_file);
+    putUint32(m_file, s_version);
+    putUint32(m_file, static_cast<uint32_t>(source));
+    putUint32(m_file, 0);
+
+    m_records = 0;
+    m_writeFailed = false;
+    m_last = CapturedAccess();
+    m_chunk.resize(s_chunkBytes + s_maxRecordBytes);
+    m_used = 0;
+    m_worker = std::make_unique<CacheWorker<std::vector<uint8_t>>>([this](const std::vector<uint8_t>& chunk) {
+        if (std::fwrite(chunk.data(), 1, chunk.size(), m_file) != chunk.size()) {
+            m_writeFailed = true;
+        }
+    });
+    return true;
+}
+
+bool CacheTraceWriter::close() {
+    if (m_file == nullptr) {
+        return m_error.empty();
+    }
+    flushChunk();
+    // Finishes writing all chunks
+    m_worker.reset();
+    if (std::fclose(m_file) != 0) {
+        m_writeFailed = true;
+    }
+    m_file = nullptr;
+    if (m_writeFailed) {
+        m_error = "Could not write '" + m_path + "'";
+    }
+    return !m_writeFailed;
+}
+
+void CacheTraceWriter::append(const CapturedAccess& access) {
+    uint8_t* const start = m_chunk.data() + m_used;
+    uint8_t* out = start + 1;
+    uint8_t flags = static_cast<uint8_t>(access.kind);
+    if (access.kind == CapturedAccess::Kind::Access) {
+        flags |= (access.isWrite ? Write : 0) | (access.pc != CapturedAccess::s_noPC ? HasPC : 0) |
+                 (access.bytes != 0 ? HasSize : 0);
+        out = putVarint(out, zigzag(access.cycle - m_last.cycle));
+        out = putVarint(out, zigzag(access.address - m_last.address));
+        if (flags & HasPC) {
+            out = putVarint(out, zigzag(access.pc - m_last.pc));
+            m_last.pc = access.pc;
+        }
+        if (flags & HasSize) {
+            out = putVarint(out, access.bytes);
+        }
+        m_last.cycle = access.cycle;
+        m_last.address = access.address;
+    } else if (access.kind == CapturedAccess::Kind::Undo) {
+        out = putVarint(out, zigzag(access.cycle - m_last.cycle));
+    }
+    *start = flags;
+    m_used += out - start;
+    m_records++;
+
+    if (m_used >= s_chunkBytes) {
+        flushChunk();
+    }
+}
+
+void CacheTraceWriter::flushChunk() {
+    if (m_used == 0) {
+        return;
+    }
+    m_chunk.resize(m_used);
+    m_worker->post(std::move(m_chunk));
+    m_chunk = std::vector<uint8_t>(s_chunkBytes + s_maxRecordBytes);
+    m_used = 0;
+}
+
+CacheTraceReader::~CacheTraceReader() {
+    if (m_file != nullptr) {
+        std::fclose(m_file);
+    }
+}
+
+bool CacheTraceReader::open(const std::string& path) {
+    if (m_file != nullptr) {
+        std::fclose(m_file);
+    }
+    m_error.clear();
+    m_file = std::fopen(path.c_str(), "rb");
+    if (m_file == nullptr) {
+        m_error = "Could not open '" + path + "': " + std::strerror(errno);
+        return false;
+    }
+
+    uint8_t header[s_headerBytes];
+    if (std::fread(header, 1, sizeof(header), m_file) != sizeof(header) ||
+        std::memcmp(header, s_magic, sizeof(s_magic)) != 0 || getUint32(header + 4) != s_version) {
+        m_error = "'" + path + "' is not a cache access trace file";
+        return false;
+    }
+    m_source = static_cast<CacheTraceWriter::Source>(getUint32(header + 8));
+    m_buffer.resize(CacheTraceWriter::s_chunkBytes);
+    m_bufferOffset = s_headerBytes;
+    m_pos = m_end = 0;
+    m_last = CapturedAccess();
+    return true;
+}
+
+bool CacheTraceReader::seek(const Position& position) {
+    if (m_file == nullptr || position.offset < s_headerBytes || std::fseek(m_file, position.offset, SEEK_SET) != 0) {
+        m_error = "Could not seek in the trace file";
+        return false;
+    }
+    m_bufferOffset = position.offset;
+    m_pos = m_end = 0;
+    m_last = position.last;
+    return true;
+}
+
+bool CacheTraceReader::fill() {
+    // Keep the unread tail, such that a record never straddles the end of the buffer
+    std::memmove(m_buffer.data(), m_buffer.data() + m_pos, m_end - m_pos);
+    m_bufferOffset += static_cast<long>(m_pos);
+    m_end -= m_pos;
+    m_pos = 0;
+    m_end += std::fread(m_buffer.data() + m_end, 1, m_buffer.size() - m_end, m_file);
+    return m_end != 0;
+}
+
+bool CacheTraceReader::readVarint(uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64 && m_pos < m_end; shift += 7) {
+        const uint8_t byte = m_buffer[m_pos++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    m_error = "Truncated or corrupt record";
+    return false;
+}
+
+bool CacheTraceReader::next(CapturedAccess& access) {
+    if (m_file == nullptr || (m_end - m_pos < s_maxRecordBytes && !fill()) || m_pos == m_end) {
+        return false;
+    }
+
+    const uint8_t flags = m_buffer[m_pos++];
+    access = CapturedAccess();
+    access.kind = static_cast<CapturedAccess::Kind>(flags & KindMask);
+    if (access.kind == CapturedAccess::Kind::Access) {
+        uint64_t value;
+        if (!readVarint(value)) {
+            return false;
+        }
+        m_last.cycle += unzigzag(value);
+        if (!readVarint(value)) {
+            return false;
+        }
+        m_last.address += unzigzag(value);
+        if (flags & HasPC) {
+            if (!readVarint(value)) {
+                return false;
+            }
+            m_last.pc += unzigzag(value);
+            access.pc = m_last.pc;
+        }
+        if (flags & HasSize) {
+            if (!readVarint(value)) {
+                return false;
+            }
+            access.bytes = static_cast<unsigned>(value);
+        }
+        access.isWrite = flags & Write;
+        access.cycle = m_last.cycle;
+        access.address = m_last.address;
+    } else if (access.kind == CapturedAccess::Kind::Undo) {
+        uint64_t value;
+        if (!readVarint(value)) {
+            return false;
+        }
+        access.cycle = m_last.cycle + unzigzag(value);
+    } else if (access.kind != CapturedAccess::Kind::Reset) {
+        m_error = "Corrupt record";
+        return false;
+    }
+    return true;
+}
+
+}  // namespace Ripes
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cache_worker.h"
+
+namespace Ripes {
+
+/**
+ * Capture of the accesses of a cache simulator to a compact trace file, for later replay without executing the
+ * program on the processor model.
+ *
+ * A trace file is a header followed by a sequence of records. All values are little-endian.
+ *   header:  "RCAT", uint32 version (2), uint32 source (0: data cache, 1: instruction cache), uint32 reserved (0)
+ *   record:  uint8 flags, followed by varints (LEB128) as indicated by the flags:
+ *            bits 0-1: kind; 0: access, 1: undo of the accesses of a cycle, 2: reset of the cache
+ *            bit 2:    write access
+ *            bit 3:    PC present
+ *            bit 4:    size present (otherwise a word access)
+ *            Accesses are followed by the cycle, address and, if present, PC as zigzag-encoded deltas from those of
+ *            the previous access, and the size in bytes if present. Undo records are followed by the undone cycle,
+ *            as a zigzag-encoded delta from the cycle of the previous access. Reset records carry no values.
+ * Consecutive accesses are close in time, and mostly close in address and PC, such that an access is typically
+ * encoded in fewer than 8 bytes.
+ */
+struct CapturedAccess {
+    enum class Kind : uint8_t { Access, Undo, Reset };
+    static constexpr uint64_t s_noPC = ~static_cast<uint64_t>(0);
+
+    Kind kind = Kind::Access;
+    bool isWrite = false;
+    unsigned bytes = 0;  // 0: a word access
+    uint64_t cycle = 0;  // Of an access, or the undone cycle of an undo
+    uint64_t address = 0;
+    uint64_t pc = s_noPC;
+};
+
+/**
+ * @brief The CacheTraceWriter class
+ * Appends records to a trace file. Records are encoded into chunks of s_chunkBytes bytes on the calling thread, and
+ * full chunks are written to the file by a background thread; appending never waits for the file system.
+ */
+class CacheTraceWriter {
+public:
+    enum class Source : uint32_t { DataCache, InstrCache };
+    static constexpr unsigned s_chunkBytes = 1 << 20;
+
+    ~CacheTraceWriter();
+
+    /**
+     * @brief open
+     * Creates the trace file at @p path. @returns false, and sets the error string, if the file could not be created.
+     */
+    bool open(const std::string& path, Source source);
+    /**
+     * @brief close
+     * Writes all appended records and closes the file. @returns false, and sets the error string, if any write failed.
+     */
+    bool close();
+    bool isOpen() const { return m_file != nullptr; }
+    const std::string& errorString() const { return m_error; }
+    uint64_t getRecords() const { return m_records; }
+
+    void append(const CapturedAccess& access);
+
+private:
+    void flushChunk();
+
+    std::FILE* m_file = nullptr;
+    std::string m_path;
+    std::string m_error;
+    uint64_t m_records = 0;
+    std::atomic<bool> m_writeFailed{false};
+
+    std::vector<uint8_t> m_chunk;
+    size_t m_used = 0;
+    CapturedAccess m_last;  // Values of the previous access, from which deltas are encoded
+
+    // Declared last, such that it is destroyed (and finishes writing) before the members it writes
+    std::unique_ptr<CacheWorker<std::vector<uint8_t>>> m_worker;
+};
+
+/**
+ * @brief The CacheTraceReader class
+ * Reads the records of a trace file in order.
+ */
+class CacheTraceReader {
+public:
+    ~CacheTraceReader();
+
+    /**
+     * @brief open
+     * Opens the trace file at @p path. @returns false, and sets the error string, if the file could not be opened or
+     * is not a trace file.
+     */
+    bool open(const std::string& path);
+    const std::string& errorString() const { return m_error; }
+    CacheTraceWriter::Source getSource() const { return m_source; }
+
+    /**
+     * @brief next
+     * Reads the next record into @p access. @returns false at the end of the file, or if the file is truncated or
+     * corrupt (in which case the error string is set).
+     */
+    bool next(CapturedAccess& access);
+
+    /**
+     * @brief The Position struct
+     * Position of the next record in the file, along with the values from which its deltas are decoded, such that
+     * reading may later be resumed from it.
+     */
+    struct Position {
+        long offset = 0;
+        CapturedAccess last;
+    };
+    Position tell() const { return {m_bufferOffset + static_cast<long>(m_pos), m_last}; }
+    bool seek(const Position& position);
+
+private:
+    bool fill();
+    bool readVarint(uint64_t& value);
+
+    std::FILE* m_file = nullptr;
+    std::string m_error;
+    CacheTraceWriter::Source m_source = CacheTraceWriter::Source::DataCache;
+    std::vector<uint8_t> m_buffer;
+    long m_bufferOffset = 0;  // Offset in the file of the first byte of the buffer
+    size_t m_pos = 0;
+    size_t m_end = 0;
+    CapturedAccess m_last;
+};
+
+}  // namespace Ripes
@@ -0,0 +1,134 @@
+#include "cache_trace_replay.h"
+
+#include <QSignalBlocker>
+
+#include <algorithm>
+
+namespace Ripes {
+
+CacheTraceReplay::CacheTraceReplay(const CacheSim& configuration)
+    : m_run(CacheSim::createDetached(configuration)), m_cache(CacheSim::createDetached(configuration)) {
+    m_run->setAccessTraceLimit(s_maxTraceEntries);
+    m_cache->setAccessTraceLimit(s_maxTraceEntries);
+}
+
+void CacheTraceReplay::replayRecord(CacheSim& cache, const CapturedAccess& record) {
+    if (record.kind == CapturedAccess::Kind::Undo) {
+        // The undone cycle may not have been simulated by this cache, e.g. if set sampling dropped its accesses
+        const auto& trace = cache.getAccessTrace();
+        if (trace.size() != 0 && trace.back().first == record.cycle) {
+            cache.undo();
+        }
+    } else {
+        cache.accessInCycle(record.cycle, record.address,
+                            record.isWrite ? CacheSim::AccessType::Write : CacheSim::AccessType::Read, record.pc,
+                            record.bytes);
+    }
+}
+
+void CacheTraceReplay::addSnapshot(uint64_t position) {
+    Snapshot snapshot{position, m_reader.tell(), m_run->saveSnapshot(), 0};
+    snapshot.bytes = snapshot.state.getBytes();
+    while (m_snapshots.size() > 1 &&
+           (m_snapshots.size() == s_maxSnapshots || m_snapshotBytes + snapshot.bytes > s_maxSnapshotBytes)) {
+        // Keep every other snapshot, starting with the one at position 0
+        size_t kept = 0;
+        m_snapshotBytes = 0;
+        for (size_t i = 0; i < m_snapshots.size(); i += 2) {
+            m_snapshotBytes += m_snapshots[i].bytes;
+            m_snapshots[kept++] = std::move(m_snapshots[i]);
+        }
+        m_snapshots.resize(kept);
+        m_snapshotInterval *= 2;
+        if (position % m_snapshotInterval != 0) {
+            return;
+        }
+    }
+    m_snapshotBytes += snapshot.bytes;
+    m_snapshots.push_back(std::move(snapshot));
+}
+
+void CacheTraceReplay::clearSnapshots() {
+    m_snapshotInterval = s_initialSnapshotInterval;
+    m_snapshots.clear();
+    m_snapshotBytes = 0;
+}
+
+bool CacheTraceReplay::load(const std::string& path) {
+    m_path = path;
+    m_error.clear();
+    m_records = 0;
+    m_position = 0;
+    clearSnapshots();
+    if (!m_reader.open(path)) {
+        m_error = m_reader.errorString();
+        return false;
+    }
+
+    const QSignalBlocker blocker(m_run.get());
+    m_run->processorReset();
+    addSnapshot(0);
+    CapturedAccess record;
+    while (m_reader.next(record)) {
+        if (record.kind == CapturedAccess::Kind::Reset) {
+            // The timeline restarts along with the cache
+            m_run->processorReset();
+            m_records = 0;
+            clearSnapshots();
+            addSnapshot(0);
+            continue;
+        }
+        replayRecord(*m_run, record);
+        m_records++;
+        if (m_records % m_snapshotInterval == 0) {
+            addSnapshot(m_records);
+        }
+    }
+    if (!m_reader.errorString().empty()) {
+        m_error = m_reader.errorString();
+        return false;
+    }
+
+    // The position cache starts out in the state of the first snapshot
+    {
+        const QSignalBlocker cacheBlocker(m_cache.get());
+        m_cache->processorReset();
+    }
+    m_reader.seek(m_snapshots.front().record);
+    seek(m_records);
+    return true;
+}
+
+void CacheTraceReplay::seek(uint64_t position) {
+    position = std::min(position, m_records);
+    if (m_snapshots.empty()) {
+        return;
+    }
+
+    {
+        const QSignalBlocker blocker(m_cache.get());
+        // Replay from the current position, unless a snapshot is closer to the target position
+        const auto snapshot = std::prev(std::upper_bound(
+            m_snapshots.begin(), m_snapshots.end(), position,
+            [](uint64_t target, const Snapshot& other) { return target < other.position; }));
+        if (position < m_position || snapshot->position > m_position) {
+            m_cache->restoreSnapshot(snapshot->state, m_run->getAccessTrace());
+            m_reader.seek(snapshot->record);
+            m_position = snapshot->position;
+        }
+
+        CapturedAccess record;
+        while (m_position < position && m_reader.next(record)) {
+            replayRecord(*m_cache, record);
+            m_position++;
+        }
+    }
+    m_cache->invalidateViews();
+}
+
+unsigned CacheTraceReplay::getCycle() const {
+    const auto& trace = m_cache->getAccessTrace();
+    return trace.empty() ? 0 : trace.back().first;
+}
+
+}  // namespace Ripes
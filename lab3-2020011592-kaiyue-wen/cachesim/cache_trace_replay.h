@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cache_trace_capture.h"
+#include "cachesim.h"
+
+namespace Ripes {
+
+/**
+ * @brief The CacheTraceReplay class
+ * Replays a captured trace file on detached caches, for stepping through the trace without a processor. The timeline
+ * of the replay consists of the access and undo records following the last reset of the trace; position i is the
+ * state of the cache after the first i records.
+ *
+ * Loading the trace replays it once in full on the run cache, which then holds the statistics of the entire trace,
+ * and saves a snapshot of the cache every so many records. Seeking restores the nearest preceding snapshot on the
+ * position cache and replays the records from there, such that a seek costs at most a snapshot interval of accesses
+ * regardless of the length of the trace. The snapshot interval is doubled whenever s_maxSnapshots would be exceeded,
+ * or the snapshots would hold more than s_maxSnapshotBytes. Each snapshot holds the miss classifier, reuse histogram
+ * and attribution tables, whose size grows with the number of distinct blocks accessed; for traces with a large
+ * footprint, the memory bound thus leaves fewer snapshots, and seeks replay proportionally more accesses.
+ *
+ * The access traces of both caches are limited to about 2 * s_maxTraceEntries entries (see
+ * CacheSim::setAccessTraceLimit()), such that their memory does not grow with the length of the trace either; the
+ * statistics plotted for long traces are of a lower resolution in time.
+ */
+class CacheTraceReplay {
+public:
+    static constexpr unsigned s_maxSnapshots = 256;
+    static constexpr size_t s_maxSnapshotBytes = size_t(256) << 20;
+    static constexpr uint64_t s_initialSnapshotInterval = 1 << 12;
+    static constexpr size_t s_maxTraceEntries = 1 << 19;
+
+    /**
+     * @brief CacheTraceReplay
+     * Replays traces on caches configured as @p configuration.
+     */
+    explicit CacheTraceReplay(const CacheSim& configuration);
+
+    /**
+     * @brief load
+     * Loads and replays the trace file at @p path, and seeks to the end of the trace. @returns false, and sets the
+     * error string, if the file could not be read.
+     */
+    bool load(const std::string& path);
+    const std::string& errorString() const { return m_error; }
+    const std::string& getPath() const { return m_path; }
+
+    /**
+     * @brief seek
+     * Restores the position cache to the state after the first @p position records of the timeline. The cache does
+     * not signal the graphical views whilst seeking; they are reloaded once the position is reached.
+     */
+    void seek(uint64_t position);
+    uint64_t getPosition() const { return m_position; }
+    uint64_t getRecords() const { return m_records; }
+
+    /**
+     * @brief getCache, getRun
+     * The cache at the current position, and the cache at the end of the trace.
+     */
+    CacheSim& getCache() { return *m_cache; }
+    const CacheSim& getRun() const { return *m_run; }
+
+    /**
+     * @brief getCycle
+     * @returns the cycle of the most recent access at the current position; 0 if no access has been performed.
+     */
+    unsigned getCycle() const;
+
+private:
+    struct Snapshot {
+        uint64_t position;
+        CacheTraceReader::Position record;
+        CacheSim::Snapshot state;
+        size_t bytes;
+    };
+
+    /**
+     * @brief addSnapshot
+     * Saves a snapshot of the run cache at @p position, first thinning out the snapshots (keeping the one at position
+     * 0) and doubling the snapshot interval for as long as either bound would be exceeded. The snapshot is not saved if
+     * @p position is not a multiple of the resulting interval.
+     */
+    void addSnapshot(uint64_t position);
+    void clearSnapshots();
+    /**
+     * @brief replayRecord
+     * Applies the access or undo record @p record to @p cache.
+     */
+    static void replayRecord(CacheSim& cache, const CapturedAccess& record);
+
+    std::string m_path;
+    std::string m_error;
+    CacheTraceReader m_reader;
+
+    uint64_t m_records = 0;
+    uint64_t m_position = 0;
+    uint64_t m_snapshotInterval = s_initialSnapshotInterval;
+    std::vector<Snapshot> m_snapshots;
+    size_t m_snapshotBytes = 0;
+
+    std::unique_ptr<CacheSim> m_run;
+    std::unique_ptr<CacheSim> m_cache;
+};
+
+}  // namespace Ripes
@@ -0,0 +1,163 @@
+#include "cache_tracepoints.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Ripes {
+namespace Tracepoints {
+
+std::atomic<bool> g_enabled(false);
+
+namespace {
+
+/**
+ * @brief The RingBuffer struct
+ * Single-producer flight recorder of records. The thread owning the buffer is the only producer, and never waits for
+ * the consumer; dump() is the only consumer. Head and tail are free-running counters, and the capacity is a power of
+ * two. The tail is only accessed with the registry lock held.
+ */
+struct RingBuffer {
+    static constexpr uint64_t s_capacity = 1 << 16;
+
+    RingBuffer() : records(s_capacity) {}
+
+    uint32_t thread = 0;  // Index of the owning thread; only accessed by the owner
+    std::vector<Record> records;
+    alignas(64) std::atomic<uint64_t> head{0};
+    uint64_t tail = 0;
+};
+
+struct Registry {
+    std::mutex lock;
+    std::vector<std::unique_ptr<RingBuffer>> buffers;
+    std::vector<RingBuffer*> idleBuffers;  // Buffers of exited threads, along with their undrained records
+    uint32_t threads = 0;
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+};
+
+Registry& registry() {
+    // Intentionally leaked, such that ring buffers outlive any thread which may still emit during static destruction
+    static Registry* const reg = new Registry();
+    return *reg;
+}
+
+/**
+ * @brief The ThreadBuffer struct
+ * The ring buffer owned by a thread, which is handed back to the registry for reuse when the thread exits.
+ */
+struct ThreadBuffer {
+    RingBuffer* buffer = nullptr;
+
+    ~ThreadBuffer() {
+        if (buffer != nullptr) {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> guard(reg.lock);
+            reg.idleBuffers.push_back(buffer);
+        }
+    }
+};
+
+RingBuffer* threadBuffer() {
+    thread_local ThreadBuffer owned;
+    if (owned.buffer == nullptr) {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> guard(reg.lock);
+        if (reg.idleBuffers.empty()) {
+            reg.buffers.push_back(std::make_unique<RingBuffer>());
+            owned.buffer = reg.buffers.back().get();
+        } else {
+            owned.buffer = reg.idleBuffers.back();
+            reg.idleBuffers.pop_back();
+        }
+        owned.buffer->thread = reg.threads++;
+    }
+    return owned.buffer;
+}
+
+/**
+ * @brief The EnvironmentControl struct
+ * Enables tracing at startup if RIPES_CACHE_TRACE is set, and dumps the trace to the file it names at exit.
+ */
+struct EnvironmentControl {
+    EnvironmentControl() {
+        if (std::getenv("RIPES_CACHE_TRACE") != nullptr) {
+            setEnabled(true);
+            std::atexit([] { dump(std::getenv("RIPES_CACHE_TRACE")); });
+        }
+    }
+};
+#ifdef RIPES_CACHE_TRACEPOINTS
+const EnvironmentControl s_environmentControl;
+#endif
+
+}  // namespace
+
+void setEnabled(bool enabled) {
+    g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void emitRecord(Event event, uint64_t a0, uint64_t a1, uint64_t a2) {
+    RingBuffer* buffer = threadBuffer();
+    const uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    // Once the buffer is full, this overwrites the oldest record
+    Record& record = buffer->records[head & (RingBuffer::s_capacity - 1)];
+    record.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                            registry().epoch)
+                           .count();
+    record.args[0] = a0;
+    record.args[1] = a1;
+    record.args[2] = a2;
+    record.event = static_cast<uint16_t>(event);
+    record.reserved = 0;
+    record.thread = buffer->thread;
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+long dump(const char* path) {
+    std::FILE* file = std::fopen(path, "wb");
+    if (file == nullptr) {
+        return -1;
+    }
+
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> guard(reg.lock);
+
+    // The header is rewritten once the number of dropped records is known
+    FileHeader header;
+    std::fwrite(&header, sizeof(header), 1, file);
+
+    long written = 0;
+    uint64_t dropped = 0;
+    std::vector<Record> records;
+    for (const auto& buffer : reg.buffers) {
+        const uint64_t head = buffer->head.load(std::memory_order_acquire);
+        const uint64_t start = std::max(buffer->tail, head - std::min(head, RingBuffer::s_capacity));
+        records.clear();
+        for (uint64_t i = start; i != head; i++) {
+            records.push_back(buffer->records[i & (RingBuffer::s_capacity - 1)]);
+        }
+        // The owning thread may have overwritten the oldest of the copied records in the meantime; the record with
+        // index i is intact if the producer has not yet started writing index i + s_capacity.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t after = buffer->head.load(std::memory_order_relaxed);
+        const uint64_t valid = std::min(head, std::max(start, after + 1 - std::min(after + 1, RingBuffer::s_capacity)));
+        std::fwrite(records.data() + (valid - start), sizeof(Record), head - valid, file);
+        written += static_cast<long>(head - valid);
+        dropped += valid - buffer->tail;
+        buffer->tail = head;
+    }
+
+    header.droppedRecords = static_cast<uint32_t>(std::min<uint64_t>(dropped, UINT32_MAX));
+    std::fseek(file, 0, SEEK_SET);
+    std::fwrite(&header, sizeof(header), 1, file);
+    std::fclose(file);
+    return written;
+}
+
+}  // namespace Tracepoints
+}  // namespace Ripes
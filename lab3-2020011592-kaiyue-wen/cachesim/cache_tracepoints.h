@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Structured tracepoints for the cache simulator.
+ *
+ * Tracepoint sites are placed throughout the cache simulator and its replacement policies through the
+ * CACHE_TRACEPOINT macro. Tracepoints are compiled in only if RIPES_CACHE_TRACEPOINTS is defined; otherwise the macro
+ * expands to nothing. When compiled in, a site costs a single relaxed atomic load and a predictable branch while
+ * tracing is disabled at runtime.
+ * When enabled, each event is written as a fixed-size binary record into a lock-free single-producer ring buffer owned
+ * by the emitting thread. The ring buffers are flight recorders: once full, each event overwrites the oldest record
+ * rather than stalling the simulator, such that the most recent events are always kept. Records are drained into a
+ * trace file by dump(), which counts the records that were overwritten before being drained. The ring buffer of an
+ * exited thread is reused by the next thread to emit an event, such that the number of ring buffers is bounded by the
+ * number of concurrently emitting threads.
+ * Trace files are decoded into text or CSV by the offline cachetrace_decode tool.
+ *
+ * This header is free of Qt dependencies, such that it may be shared with the offline decoder.
+ */
+
+namespace Ripes {
+namespace Tracepoints {
+
+enum class Event : uint16_t {
+    Access,      // args: address, set << 32 | way, flags (see AccessFlags)
+    Evict,       // args: set, way, evicted tag
+    Undo,        // args: address, set, way
+    ReplLocate,  // args: set, selected way, 0
+    ReplUpdate,  // args: set, way, isHit
+    DipSwitch,   // args: use LRU, LRU hit rate (ppm), LIP hit rate (ppm)
+    N_Events
+};
+
+enum AccessFlags : uint64_t { Hit = 1 << 0, Write = 1 << 1, Writeback = 1 << 2 };
+
+struct Record {
+    uint64_t timestamp;  // Nanoseconds since an arbitrary, per-process epoch
+    uint64_t args[3];
+    uint16_t event;
+    uint16_t reserved;
+    uint32_t thread;  // Index of the emitting thread, in order of first emitted event
+};
+static_assert(sizeof(Record) == 40, "Tracepoint records must be of fixed size");
+
+/**
+ * @brief The FileHeader struct
+ * Trace files consist of a header followed by a sequence of records, in per-thread emission order.
+ */
+struct FileHeader {
+    char magic[4] = {'R', 'C', 'T', 'P'};
+    uint32_t version = 2;
+    uint32_t recordSize = sizeof(Record);
+    uint32_t droppedRecords = 0;  // Records overwritten before being dumped
+};
+
+inline const char* eventName(uint16_t event) {
+    static const char* const names[] = {"access", "evict", "undo", "repl_locate", "repl_update", "dip_switch"};
+    return event < static_cast<uint16_t>(Event::N_Events) ? names[event] : "unknown";
+}
+
+extern std::atomic<bool> g_enabled;
+
+inline bool enabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+void setEnabled(bool enabled);
+
+/**
+ * @brief emitRecord
+ * Appends a record for @p event to the ring buffer of the calling thread.
+ */
+void emitRecord(Event event, uint64_t a0, uint64_t a1, uint64_t a2);
+
+/**
+ * @brief dump
+ * Drains all ring buffers into the file at @p path. Records which a still emitting thread overwrites whilst they are
+ * drained are discarded and counted as dropped. @returns the number of records written, or -1 if the file could not
+ * be opened.
+ */
+long dump(const char* path);
+
+}  // namespace Tracepoints
+}  // namespace Ripes
+
+#ifdef RIPES_CACHE_TRACEPOINTS
+#define CACHE_TRACEPOINT(event, a0, a1, a2)                                                                           \
+    do {                                                                                                               \
+        if (Ripes::Tracepoints::enabled()) {                                                                           \
+            Ripes::Tracepoints::emitRecord(Ripes::Tracepoints::Event::event, static_cast<uint64_t>(a0),                \
+                                           static_cast<uint64_t>(a1), static_cast<uint64_t>(a2));                      \
+        }                                                                                                              \
+    } while (0)
+#else
+#define CACHE_TRACEPOINT(event, a0, a1, a2) \
+    do {                                    \
+    } while (0)
+#endif
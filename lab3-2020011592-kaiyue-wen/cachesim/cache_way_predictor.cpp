@@ -0,0 +1,52 @@
+#include "cache_way_predictor.h"
+
+#include <algorithm>
+
+namespace Ripes {
+
+void CacheWayPredictor::reset(Policy policy, unsigned sets) {
+    m_policy = policy;
+    switch (m_policy) {
+    case Policy::None: m_table.clear(); break;
+    case Policy::MRU: m_table.assign(sets, 0); break;
+    case Policy::PC: m_table.assign(std::max(sets, s_pcEntries), 0); break;
+    }
+}
+
+CacheWayPredictor::Outcome CacheWayPredictor::predict(unsigned set, uint64_t pc) const {
+    Outcome outcome;
+    if (!isEnabled()) {
+        return outcome;
+    }
+
+    // Table sizes are powers of 2
+    const unsigned mask = static_cast<unsigned>(m_table.size()) - 1;
+    if (m_policy == Policy::PC) {
+        // Fibonacci hashing of the (word-aligned) program counter; offset by the set, such that the accesses of an
+        // instruction to different sets do not all train the same entry
+        const unsigned pcHash = static_cast<unsigned>(((pc >> 1) * 0x9E3779B97F4A7C15ull) >> 40);
+        outcome.entry = (pcHash + set) & mask;
+    } else {
+        outcome.entry = set & mask;
+    }
+    outcome.predicted = true;
+    outcome.way = m_table[outcome.entry];
+    return outcome;
+}
+
+void CacheWayPredictor::train(Outcome& outcome, unsigned way) {
+    if (!outcome.predicted) {
+        return;
+    }
+    outcome.trained = true;
+    outcome.oldWay = m_table[outcome.entry];
+    m_table[outcome.entry] = way;
+}
+
+void CacheWayPredictor::revert(const Outcome& outcome) {
+    if (outcome.trained) {
+        m_table.at(outcome.entry) = outcome.oldWay;
+    }
+}
+
+}  // namespace Ripes
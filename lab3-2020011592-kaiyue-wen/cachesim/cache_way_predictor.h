@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Ripes {
+
+/**
+ * @brief The CacheWayPredictor class
+ * Way predictor of a set-associative cache. A lookup first probes (reads the tag and data of) only the predicted way;
+ * if the line is not found there, the remaining ways are probed in a second, slower probe. The predictor is a table of
+ * predicted ways, trained with the way which each access hits or fills:
+ * - MRU: one entry per set, predicting the most recently used way of the set.
+ * - PC: entries indexed by a hash of the program counter of the accessing instruction, combined with the set index.
+ *   Accesses without a known program counter share the entries of the set.
+ */
+class CacheWayPredictor {
+public:
+    enum class Policy { None, MRU, PC };
+
+    /**
+     * @brief The Outcome struct
+     * Prediction of an access, and the table entry it replaced (for revert()).
+     */
+    struct Outcome {
+        bool predicted = false;  // True if a way was predicted
+        unsigned way = 0;        // The predicted way
+
+        unsigned entry = 0;
+        bool trained = false;
+        unsigned oldWay = 0;
+    };
+
+    /**
+     * @brief reset
+     * Clears the table and sizes it for a cache of @p sets sets. PC-indexed tables have at least s_pcEntries entries.
+     */
+    void reset(Policy policy, unsigned sets);
+    bool isEnabled() const { return m_policy != Policy::None; }
+    Policy getPolicy() const { return m_policy; }
+    unsigned getEntries() const { return static_cast<unsigned>(m_table.size()); }
+
+    /**
+     * @brief predict
+     * @returns the predicted way of an access to @p set by the instruction at @p pc.
+     */
+    Outcome predict(unsigned set, uint64_t pc) const;
+
+    /**
+     * @brief train
+     * Records that the access predicted by @p outcome used @p way.
+     */
+    void train(Outcome& outcome, unsigned way);
+
+    /**
+     * @brief revert
+     * Reverts the most recent access not yet reverted, which returned @p outcome.
+     */
+    void revert(const Outcome& outcome);
+
+    static constexpr unsigned s_pcEntries = 256;
+
+private:
+    Policy m_policy = Policy::None;
+    std::vector<unsigned> m_table;
+};
+
+}  // namespace Ripes
@@ -0,0 +1,84 @@
+#include "cache_windowed_metrics.h"
+
+#include <cmath>
+
+namespace Ripes {
+
+void WindowedMetrics::setTimeline(const std::vector<double>& cycles, const std::vector<double>& accesses,
+                                  const WindowConfig& config) {
+    const size_t n = cycles.size();
+    const double size = config.size > 0 ? config.size : 1;
+    // Position of an entry along the timeline, in units of the window. The n'th access is at position n - 1.
+    auto position = [&](size_t i) { return config.unit == WindowConfig::Unit::Accesses ? accesses[i] - 1 : cycles[i]; };
+
+    m_begin.resize(n);
+    m_end.resize(n);
+    m_intervalStarts.clear();
+
+    // Fixed intervals; entry i is in interval floor(position / size)
+    double currentInterval = -1;
+    for (size_t i = 0; i < n; i++) {
+        const double interval = std::floor(position(i) / size);
+        if (interval != currentInterval) {
+            m_intervalStarts.push_back(i);
+            currentInterval = interval;
+        }
+    }
+
+    if (config.mode == WindowConfig::Mode::Moving) {
+        // The window of entry i contains all entries at positions in ]position(i) - size; position(i)]
+        size_t begin = 0;
+        for (size_t i = 0; i < n; i++) {
+            while (position(begin) <= position(i) - size) {
+                begin++;
+            }
+            m_begin[i] = begin;
+            m_end[i] = i;
+        }
+    } else {
+        for (size_t t = 0; t < m_intervalStarts.size(); t++) {
+            const uint32_t begin = m_intervalStarts[t];
+            const uint32_t end = t + 1 < m_intervalStarts.size() ? m_intervalStarts[t + 1] - 1 : n - 1;
+            for (uint32_t i = begin; i <= end; i++) {
+                m_begin[i] = begin;
+                m_end[i] = end;
+            }
+        }
+    }
+}
+
+void WindowedMetrics::apply(const std::vector<double>& cumulative, std::vector<double>& windowed) const {
+    windowed.resize(cumulative.size());
+    for (size_t i = 0; i < cumulative.size(); i++) {
+        windowed[i] = windowValue(cumulative, m_begin[i], m_end[i]);
+    }
+}
+
+std::vector<uint32_t> WindowedMetrics::detectPhases(const std::vector<double>& cumulativeMisses,
+                                                    const std::vector<double>& cumulativeAccesses,
+                                                    double threshold) const {
+    std::vector<uint32_t> boundaries;
+    double phaseMisses = 0;
+    double phaseAccesses = 0;
+    for (size_t t = 0; t < m_intervalStarts.size(); t++) {
+        const uint32_t begin = m_intervalStarts[t];
+        const uint32_t end =
+            t + 1 < m_intervalStarts.size() ? m_intervalStarts[t + 1] - 1 : cumulativeMisses.size() - 1;
+        const double misses = windowValue(cumulativeMisses, begin, end);
+        const double accesses = windowValue(cumulativeAccesses, begin, end);
+        if (accesses == 0) {
+            continue;
+        }
+
+        if (phaseAccesses != 0 && std::abs(misses / accesses - phaseMisses / phaseAccesses) > threshold) {
+            boundaries.push_back(begin);
+            phaseMisses = 0;
+            phaseAccesses = 0;
+        }
+        phaseMisses += misses;
+        phaseAccesses += accesses;
+    }
+    return boundaries;
+}
+
+}  // namespace Ripes
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Ripes {
+
+/**
+ * @brief The WindowConfig struct
+ * Describes the window over which windowed metrics are computed. A moving window covers the last @p size accesses (or
+ * cycles) up until each point of the timeline, whereas fixed intervals partition the timeline into consecutive,
+ * non-overlapping windows of @p size accesses (or cycles).
+ */
+struct WindowConfig {
+    enum class Mode { Moving, Interval };
+    enum class Unit { Accesses, Cycles };
+    Mode mode = Mode::Moving;
+    Unit unit = Unit::Accesses;
+    unsigned size = 10000;
+};
+
+/**
+ * @brief The WindowedMetrics class
+ * Derives windowed metrics from the cumulative statistics of the access trace. The window of each timeline entry is
+ * located once, in a single pass, when the timeline is set; any cumulative variable may then be windowed in linear
+ * time as the difference of its cumulative value at the two ends of the window.
+ */
+class WindowedMetrics {
+public:
+    /**
+     * @brief setTimeline
+     * Locates the windows of a timeline with entries at @p cycles, at which a cumulative number of @p accesses had
+     * been performed. Both vectors must be non-decreasing.
+     */
+    void setTimeline(const std::vector<double>& cycles, const std::vector<double>& accesses,
+                     const WindowConfig& config);
+
+    /**
+     * @brief apply
+     * Sets @p windowed to the per-window value of the @p cumulative variable at each entry of the timeline.
+     */
+    void apply(const std::vector<double>& cumulative, std::vector<double>& windowed) const;
+
+    /**
+     * @brief detectPhases
+     * Detects program phase changes by comparing the miss rate of each fixed interval to the mean miss rate of the
+     * current phase. A new phase begins when the two differ by more than @p threshold.
+     * @returns the indices of the timeline entries at which new phases begin.
+     */
+    std::vector<uint32_t> detectPhases(const std::vector<double>& cumulativeMisses,
+                                       const std::vector<double>& cumulativeAccesses, double threshold) const;
+
+private:
+    static double windowValue(const std::vector<double>& cumulative, uint32_t begin, uint32_t end) {
+        return cumulative[end] - (begin > 0 ? cumulative[begin - 1] : 0);
+    }
+
+    // First and last timeline entry of the window of each entry
+    std::vector<uint32_t> m_begin;
+    std::vector<uint32_t> m_end;
+    // First timeline entry of each fixed interval
+    std::vector<uint32_t> m_intervalStarts;
+};
+
+}  // namespace Ripes
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Ripes {
+
+/**
+ * @brief The CacheWorker class
+ * A host thread which handles posted items in the order in which they were posted. Posting does not wait for the
+ * worker; items posted whilst the worker is busy are queued, and handled as a single batch once it is done. Destroying
+ * the worker handles all queued items before joining the thread.
+ */
+template <typename Item>
+class CacheWorker {
+public:
+    explicit CacheWorker(std::function<void(const Item&)> handler)
+        : m_handler(std::move(handler)), m_thread([this] { run(); }) {}
+    ~CacheWorker() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wakeup.notify_one();
+        m_thread.join();
+    }
+    CacheWorker(const CacheWorker&) = delete;
+    CacheWorker& operator=(const CacheWorker&) = delete;
+
+    void post(const Item& item) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending.push_back(item);
+        }
+        m_wakeup.notify_one();
+    }
+    void post(Item&& item) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending.push_back(std::move(item));
+        }
+        m_wakeup.notify_one();
+    }
+
+    /**
+     * @brief sync
+     * Blocks until all posted items have been handled.
+     */
+    void sync() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_idle.wait(lock, [this] { return m_pending.empty() && !m_busy; });
+    }
+
+private:
+    void run() {
+        std::vector<Item> batch;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_wakeup.wait(lock, [this] { return m_stopping || !m_pending.empty(); });
+            if (m_pending.empty()) {
+                // Stopping, and all items have been handled
+                return;
+            }
+            batch.swap(m_pending);
+            m_busy = true;
+            lock.unlock();
+            for (const auto& item : batch) {
+                m_handler(item);
+            }
+            batch.clear();
+            lock.lock();
+            m_busy = false;
+            m_idle.notify_all();
+        }
+    }
+
+    std::function<void(const Item&)> m_handler;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    std::condition_variable m_idle;
+    std::vector<Item> m_pending;
+    bool m_busy = false;
+    bool m_stopping = false;
+    std::thread m_thread;  // Started last, once all other members have been initialized
+};
+
+}  // namespace Ripes
@@ -0,0 +1,292 @@
+#include "cache_workloads.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Ripes {
+
+// ============================================================================
+
+StrideGenerator::StrideGenerator(uint64_t base, uint32_t stride, uint32_t elements, uint32_t writeEvery)
+    : m_base(base), m_stride(stride), m_elements(std::max(elements, 1u)), m_writeEvery(writeEvery) {}
+
+void StrideGenerator::reset(uint64_t) {
+    m_idx = 0;
+    m_count = 0;
+}
+
+WorkloadAccess StrideGenerator::next() {
+    WorkloadAccess access;
+    access.address = m_base + static_cast<uint64_t>(m_idx) * m_stride;
+    m_count++;
+    access.isWrite = m_writeEvery != 0 && m_count % m_writeEvery == 0;
+    m_idx = m_idx + 1 == m_elements ? 0 : m_idx + 1;
+    return access;
+}
+
+// ============================================================================
+
+RandomGenerator::RandomGenerator(uint64_t base, uint32_t bytes, double writeFraction)
+    : m_base(base), m_words(std::max(bytes / 4, 1u)), m_writeFraction(writeFraction) {}
+
+void RandomGenerator::reset(uint64_t seed) {
+    m_rng.seed(seed);
+}
+
+WorkloadAccess RandomGenerator::next() {
+    WorkloadAccess access;
+    access.address = m_base + 4 * m_rng.nextBelow(m_words);
+    access.isWrite = m_writeFraction > 0 && m_rng.nextDouble() < m_writeFraction;
+    return access;
+}
+
+// ============================================================================
+
+WorkingSetSweepGenerator::WorkingSetSweepGenerator(uint64_t base, uint32_t minBytes, uint32_t maxBytes,
+                                                   uint32_t passes)
+    : m_base(base),
+      m_minBytes(std::max(minBytes, 4u)),
+      m_maxBytes(std::max(maxBytes, m_minBytes)),
+      m_passes(std::max(passes, 1u)) {
+    reset();
+}
+
+void WorkingSetSweepGenerator::reset(uint64_t) {
+    m_size = m_minBytes;
+    m_offset = 0;
+    m_pass = 0;
+}
+
+WorkloadAccess WorkingSetSweepGenerator::next() {
+    const WorkloadAccess access = {m_base + m_offset, false};
+    m_offset += 4;
+    if (m_offset >= m_size) {
+        m_offset = 0;
+        if (++m_pass == m_passes) {
+            m_pass = 0;
+            m_size = m_size > m_maxBytes / 2 ? m_minBytes : m_size * 2;
+        }
+    }
+    return access;
+}
+
+// ============================================================================
+
+namespace {
+
+/// log(1 + x) / x, accurate for small x
+double helper1(double x) {
+    return std::abs(x) > 1e-8 ? std::log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x));
+}
+
+/// (exp(x) - 1) / x, accurate for small x
+double helper2(double x) {
+    return std::abs(x) > 1e-8 ? std::expm1(x) / x : 1 + x * 0.5 * (1 + x * (1.0 / 3) * (1 + 0.25 * x));
+}
+
+}  // namespace
+
+ZipfGenerator::ZipfGenerator(uint64_t base, uint32_t elements, double exponent)
+    : m_base(base), m_elements(std::max(elements, 1u)), m_exponent(exponent) {
+    m_hIntegralX1 = hIntegral(1.5) - 1;
+    m_hIntegralElements = hIntegral(m_elements + 0.5);
+    m_s = 2 - hIntegralInverse(hIntegral(2.5) - h(2));
+}
+
+double ZipfGenerator::h(double x) const {
+    return std::exp(-m_exponent * std::log(x));
+}
+
+double ZipfGenerator::hIntegral(double x) const {
+    const double logX = std::log(x);
+    return helper2((1 - m_exponent) * logX) * logX;
+}
+
+double ZipfGenerator::hIntegralInverse(double x) const {
+    double t = x * (1 - m_exponent);
+    if (t < -1) {
+        t = -1;
+    }
+    return std::exp(helper1(t) * x);
+}
+
+void ZipfGenerator::reset(uint64_t seed) {
+    m_rng.seed(seed);
+}
+
+uint32_t ZipfGenerator::sampleRank() {
+    while (true) {
+        const double u = m_hIntegralElements + m_rng.nextDouble() * (m_hIntegralX1 - m_hIntegralElements);
+        const double x = hIntegralInverse(u);
+        double k = std::floor(x + 0.5);
+        k = std::min(std::max(k, 1.0), static_cast<double>(m_elements));
+        if (k - x <= m_s || u >= hIntegral(k + 0.5) - h(k)) {
+            return static_cast<uint32_t>(k);
+        }
+    }
+}
+
+WorkloadAccess ZipfGenerator::next() {
+    return {m_base + 4 * (sampleRank() - 1), false};
+}
+
+// ============================================================================
+
+PointerChaseGenerator::PointerChaseGenerator(uint64_t base, uint32_t elements, uint32_t nodeBytes)
+    : m_base(base), m_elements(std::max(elements, 1u)), m_nodeBytes(nodeBytes) {
+    uint32_t size = 1;
+    while (size < m_elements) {
+        size <<= 1;
+    }
+    m_mask = size - 1;
+    reset();
+}
+
+void PointerChaseGenerator::reset(uint64_t seed) {
+    // An LCG modulo a power of two has full period iff the increment is odd and the multiplier is 1 modulo 4
+    WorkloadRng rng;
+    rng.seed(seed);
+    m_multiplier = (static_cast<uint32_t>(rng.next()) & ~3u) | 1u;
+    m_increment = static_cast<uint32_t>(rng.next()) | 1u;
+    m_node = 0;
+}
+
+WorkloadAccess PointerChaseGenerator::next() {
+    do {
+        m_node = (m_multiplier * m_node + m_increment) & m_mask;
+    } while (m_node >= m_elements);
+    return {m_base + static_cast<uint64_t>(m_node) * m_nodeBytes, false};
+}
+
+// ============================================================================
+
+BlockedMatMulGenerator::BlockedMatMulGenerator(uint64_t baseA, uint64_t baseB, uint64_t baseC, uint32_t n,
+                                               uint32_t blockSize)
+    : m_baseA(baseA),
+      m_baseB(baseB),
+      m_baseC(baseC),
+      m_n(std::max(n, 1u)),
+      m_blockSize(std::min(std::max(blockSize, 1u), m_n)) {}
+
+void BlockedMatMulGenerator::reset(uint64_t) {
+    m_ii = m_jj = m_kk = 0;
+    m_i = m_j = m_k = 0;
+    m_phase = Phase::ReadC;
+}
+
+WorkloadAccess BlockedMatMulGenerator::next() {
+    // for ii, jj, kk: for i, j: c = C[i][j]; for k: c += A[i][k] * B[k][j]; C[i][j] = c
+    const uint32_t i = m_ii + m_i, j = m_jj + m_j, k = m_kk + m_k;
+    WorkloadAccess access;
+    switch (m_phase) {
+    case Phase::ReadC: access = {element(m_baseC, i, j), false}; break;
+    case Phase::ReadA: access = {element(m_baseA, i, k), false}; break;
+    case Phase::ReadB: access = {element(m_baseB, k, j), false}; break;
+    case Phase::WriteC: access = {element(m_baseC, i, j), true}; break;
+    }
+    advance();
+    return access;
+}
+
+void BlockedMatMulGenerator::advance() {
+    // Indices within a block are bounded by the edge of the matrix for partial blocks
+    auto blockEnd = [&](uint32_t blockStart) { return std::min(m_blockSize, m_n - blockStart); };
+
+    switch (m_phase) {
+    case Phase::ReadC: m_phase = Phase::ReadA; return;
+    case Phase::ReadA: m_phase = Phase::ReadB; return;
+    case Phase::ReadB:
+        if (++m_k < blockEnd(m_kk)) {
+            m_phase = Phase::ReadA;
+        } else {
+            m_phase = Phase::WriteC;
+        }
+        return;
+    case Phase::WriteC: break;
+    }
+
+    m_phase = Phase::ReadC;
+    m_k = 0;
+    if (++m_j < blockEnd(m_jj)) {
+        return;
+    }
+    m_j = 0;
+    if (++m_i < blockEnd(m_ii)) {
+        return;
+    }
+    m_i = 0;
+    if ((m_kk += m_blockSize) < m_n) {
+        return;
+    }
+    m_kk = 0;
+    if ((m_jj += m_blockSize) < m_n) {
+        return;
+    }
+    m_jj = 0;
+    if ((m_ii += m_blockSize) < m_n) {
+        return;
+    }
+    m_ii = 0;
+}
+
+// ============================================================================
+
+StencilGenerator::StencilGenerator(uint64_t baseIn, uint64_t baseOut, uint32_t rows, uint32_t cols)
+    : m_baseIn(baseIn), m_baseOut(baseOut), m_rows(std::max(rows, 3u)), m_cols(std::max(cols, 3u)) {}
+
+void StencilGenerator::reset(uint64_t) {
+    m_swapped = false;
+    m_i = 1;
+    m_j = 1;
+    m_point = 0;
+}
+
+WorkloadAccess StencilGenerator::next() {
+    // Center, north, south, west and east points are read, after which the center point of the output is written
+    static const int s_rowOffsets[] = {0, -1, 1, 0, 0, 0};
+    static const int s_colOffsets[] = {0, 0, 0, -1, 1, 0};
+
+    const uint64_t in = m_swapped ? m_baseOut : m_baseIn;
+    const uint64_t out = m_swapped ? m_baseIn : m_baseOut;
+    const bool isWrite = m_point == 5;
+    const uint32_t row = m_i + s_rowOffsets[m_point];
+    const uint32_t col = m_j + s_colOffsets[m_point];
+    const WorkloadAccess access = {(isWrite ? out : in) + 4 * (row * m_cols + col), isWrite};
+
+    if (++m_point == 6) {
+        m_point = 0;
+        if (++m_j == m_cols - 1) {
+            m_j = 1;
+            if (++m_i == m_rows - 1) {
+                m_i = 1;
+                m_swapped = !m_swapped;
+            }
+        }
+    }
+    return access;
+}
+
+// ============================================================================
+
+ProducerConsumerGenerator::ProducerConsumerGenerator(uint64_t base, uint32_t slots, uint32_t batch)
+    : m_base(base), m_slots(std::max(slots, 1u)), m_batch(std::min(std::max(batch, 1u), m_slots)) {}
+
+void ProducerConsumerGenerator::reset(uint64_t) {
+    m_head = 0;
+    m_idx = 0;
+    m_consuming = false;
+}
+
+WorkloadAccess ProducerConsumerGenerator::next() {
+    const WorkloadAccess access = {m_base + 4 * ((m_head + m_idx) % m_slots), !m_consuming};
+    if (++m_idx == m_batch) {
+        m_idx = 0;
+        if (m_consuming) {
+            m_head = (m_head + m_batch) % m_slots;
+        }
+        m_consuming = !m_consuming;
+    }
+    return access;
+}
+
+}  // namespace Ripes
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Ripes {
+
+/**
+ * Synthetic workload generators, emitting streams of memory accesses which may be fed directly into a cache
+ * simulator without executing a program on the processor model.
+ *
+ * All generators produce infinite streams (finite patterns wrap around), are reproducible from their seed through
+ * reset(), and perform no heap allocations; the state of a generator is a handful of integers.
+ */
+
+struct WorkloadAccess {
+    uint64_t address;
+    bool isWrite;
+};
+
+/**
+ * @brief The WorkloadRng class
+ * Small, fast pseudo-random number generator (SplitMix64) used by the randomized generators.
+ */
+class WorkloadRng {
+public:
+    void seed(uint64_t seed) { m_state = seed; }
+    uint64_t next() {
+        uint64_t z = (m_state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    /// @returns a uniformly distributed value in [0; 1[
+    double nextDouble() { return (next() >> 11) * (1.0 / (1ull << 53)); }
+    /// @returns a uniformly distributed value in [0; bound[
+    uint32_t nextBelow(uint32_t bound) { return static_cast<uint32_t>(((next() >> 32) * bound) >> 32); }
+
+private:
+    uint64_t m_state = 0;
+};
+
+class WorkloadGenerator {
+public:
+    virtual ~WorkloadGenerator() {}
+
+    /**
+     * @brief reset
+     * Restarts the stream. Two streams reset with the same seed are identical.
+     */
+    virtual void reset(uint64_t seed = 0) = 0;
+    virtual WorkloadAccess next() = 0;
+
+    void fill(WorkloadAccess* accesses, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            accesses[i] = next();
+        }
+    }
+};
+
+/**
+ * @brief The StrideGenerator class
+ * Accesses @p elements elements, @p stride bytes apart, in order and repeatedly. Every @p writeEvery'th access is a
+ * write (0: no writes).
+ */
+class StrideGenerator : public WorkloadGenerator {
+public:
+    StrideGenerator(uint64_t base, uint32_t stride, uint32_t elements, uint32_t writeEvery = 0);
+    void reset(uint64_t seed = 0) override;
+    WorkloadAccess next() override;
+
+private:
+    uint64_t m_base;
+    uint32_t m_stride, m_elements, m_writeEvery;
+    uint32_t m_idx = 0;
+    uint32_t m_count = 0;
+};
+
+/**
+ * @brief The RandomGenerator class
+ * Uniformly random word accesses within [@p base; @p base + @p bytes[. A fraction @p writeFraction of the accesses
+ * are writes.
+ */
+class RandomGenerator : public WorkloadGenerator {
+public:
+    RandomGenerator(uint64_t base, uint32_t bytes, double writeFraction = 0);
+    void reset(uint64_t seed = 0) override;
+    WorkloadAccess next() override;
+
+private:
+    uint64_t m_base;
+    uint32_t m_words;
+    double m_writeFraction;
+    WorkloadRng m_rng;
+};
+
+/**
+ * @brief The WorkingSetSweepGenerator class
+ * Sequentially traverses working sets of doubling size, from @p minBytes to @p maxBytes, @p passes times each. Hit
+ * rates drop sharply as the working set exceeds the capacity of the cache.
+ */
+class WorkingSetSweepGenerator : public WorkloadGenerator {
+public:
+    WorkingSetSweepGenerator(uint64_t base, uint32_t minBytes, uint32_t maxBytes, uint32_t passes);
+    void reset(uint64_t seed = 0) override;
+    WorkloadAccess next() override;
+
+private:
+    uint64_t m_base;
+    uint32_t m_minBytes, m_maxBytes, m_passes;
+    uint32_t m_size = 0;
+    uint32_t m_offset = 0;
+    uint32_t m_pass = 0;
+};
+
+/**
+ * @brief The ZipfGenerator class
+ * Reads @p elements words of which the element of rank k is accessed with a probability proportional to
+ * 1/k^@p exponent, modelling a hot set. Ranks are sampled in constant time, without tables, by rejection-inversion
+ * (W. Hörmann, G. Derflinger: "Rejection-inversion to generate variates from monotone discrete distributions").
+ */
+class ZipfGenerator : public WorkloadGenerator {
+public:
+    ZipfGenerator(uint64_t base, uint32_t elements, double exponent);
+    void reset(uint64_t seed = 0) override;
+    WorkloadAccess next() override;
+
+    /// @returns a rank in [1; elements]
+    uint32_t sampleRank();
+
+private:
+    double h(double x) const;
+    double hIntegral(double x) const;
+    double hIntegralInverse(double x) const;
+
+    uint64_t m_base;
+    uint32_t m_elements;
+    double m_exponent;
+    double m_hIntegralX1, m_hIntegralElements, m_s;
+    WorkloadRng m_rng;
+};
+
+/**
+ * @brief The PointerChaseGenerator class
+ * Reads @p elements nodes of @p nodeBytes bytes in a pseudo-random cyclic order which visits every node once per
+ * cycle, as when traversing a randomly linked list. The order is generated by a full-period linear congruential
+ * generator over the next power of two of @p elements, skipping values outside of the list.
+ */
+class PointerChaseGenerator : public WorkloadGenerator {
+public:
+    PointerChaseGenerator(uint64_t base, uint32_t elements, uint32_t nodeBytes);
+    void reset(uint64_t seed = 0) override;
+    WorkloadAccess next() override;
+
+private:
+    uint64_t m_base;
+    uint32_t m_elements, m_nodeBytes;
+    uint32_t m_mask = 0;
+    uint32_t m_multiplier = 1;
+    uint32_t m_increment = 1;
+    uint32_t m_node = 0;
+};
+
+/**
+ * @brief The BlockedMatMulGenerator class
+ * Accesses of a blocked multiplication C += A * B of row-major @p n x @p n word matrices, with blocks of
+ * @p blockSize x @p blockSize elements.
+ */
+class BlockedMatMulGenerator : public WorkloadGenerator {
+public:
+    BlockedMatMulGenerator(uint64_t baseA, uint64_t baseB, uint64_t baseC, uint32_t n, uint32_t blockSize);
+    void reset(uint64_t seed = 0) override;
+    WorkloadAccess next() override;
+
+private:
+    uint64_t element(uint64_t base, uint32_t row, uint32_t col) const { return base + 4 * (row * m_n + col); }
+    void advance();
+
+    uint64_t m_baseA, m_baseB, m_baseC;
+    uint32_t m_n, m_blockSize;
+    // Block indices, indices within the block, and the access within the innermost loop iteration
+    uint32_t m_ii = 0, m_jj = 0, m_kk = 0;
+    uint32_t m_i = 0, m_j = 0, m_k = 0;
+    enum class Phase { ReadC, ReadA, ReadB, WriteC } m_phase = Phase::ReadC;
+};
+
+/**
+ * @brief The StencilGenerator class
+ * Accesses of a 5-point Jacobi stencil over a @p rows x @p cols word grid. Each sweep reads the input grid and writes
+ * the output grid, after which the two grids are swapped.
+ */
+class StencilGenerator : public WorkloadGenerator {
+public:
+    StencilGenerator(uint64_t baseIn, uint64_t baseOut, uint32_t rows, uint32_t cols);
+    void reset(uint64_t seed = 0) override;
+    WorkloadAccess next() override;
+
+private:
+    uint64_t m_baseIn, m_baseOut;
+    uint32_t m_rows, m_cols;
+    bool m_swapped = false;
+    uint32_t m_i = 1, m_j = 1;
+    unsigned m_point = 0;
+};
+
+/**
+ * @brief The ProducerConsumerGenerator class
+ * A producer writes @p batch consecutive words into a ring buffer of @p slots words, after which a consumer reads the
+ * same words.
+ */
+class ProducerConsumerGenerator : public WorkloadGenerator {
+public:
+    ProducerConsumerGenerator(uint64_t base, uint32_t slots, uint32_t batch);
+    void reset(uint64_t seed = 0) override;
+    WorkloadAccess next() override;
+
+private:
+    uint64_t m_base;
+    uint32_t m_slots, m_batch;
+    uint32_t m_head = 0;
+    uint32_t m_idx = 0;
+    bool m_consuming = false;
+};
+
+/**
+ * @brief The ReplayGenerator class
+ * Repeats a fixed sequence of accesses. The sequence is not copied, and must outlive the generator.
+ */
+class ReplayGenerator : public WorkloadGenerator {
+public:
+    ReplayGenerator(const WorkloadAccess* accesses, size_t n) : m_accesses(accesses), m_n(n) {}
+    void reset(uint64_t = 0) override { m_idx = 0; }
+    WorkloadAccess next() override {
+        const WorkloadAccess access = m_accesses[m_idx];
+        m_idx = m_idx + 1 == m_n ? 0 : m_idx + 1;
+        return access;
+    }
+
+private:
+    const WorkloadAccess* m_accesses;
+    size_t m_n;
+    size_t m_idx = 0;
+};
+
+}  // namespace Ripes
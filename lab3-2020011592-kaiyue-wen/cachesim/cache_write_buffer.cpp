@@ -0,0 +1,55 @@
+#include "cache_write_buffer.h"
+
+#include <algorithm>
+
+namespace Ripes {
+
+void CacheWriteBuffer::reset(unsigned entries, unsigned drainCycles) {
+    m_entries.assign(entries, Entry());
+    m_drainCycles = std::max(drainCycles, 1u);
+    m_now = 0;
+}
+
+CacheWriteBuffer::Outcome CacheWriteBuffer::write(uint64_t block, uint64_t cycle) {
+    Outcome outcome;
+    outcome.oldNow = m_now;
+    m_now = std::max(m_now, cycle);
+
+    // Entries drain in the order of their drained cycles. An entry which has started draining can no longer be merged
+    // into.
+    uint64_t lastDrainedCycle = 0;
+    for (const auto& entry : m_entries) {
+        if (entry.drainedCycle > m_now + m_drainCycles && entry.block == block) {
+            outcome.coalesced = true;
+            return outcome;
+        }
+        lastDrainedCycle = std::max(lastDrainedCycle, entry.drainedCycle);
+    }
+
+    // Allocate the oldest entry, stalling until it has drained if it is still in use
+    const auto it = std::min_element(m_entries.begin(), m_entries.end(), [](const Entry& a, const Entry& b) {
+        return a.drainedCycle < b.drainedCycle;
+    });
+    if (it->drainedCycle > m_now) {
+        outcome.stallCycles = static_cast<unsigned>(it->drainedCycle - m_now);
+        m_now = it->drainedCycle;
+    }
+    outcome.allocated = true;
+    outcome.slot = static_cast<unsigned>(it - m_entries.begin());
+    outcome.oldBlock = it->block;
+    outcome.oldDrainedCycle = it->drainedCycle;
+    it->block = block;
+    it->drainedCycle = std::max(lastDrainedCycle, m_now) + m_drainCycles;
+    return outcome;
+}
+
+void CacheWriteBuffer::revert(const Outcome& outcome) {
+    if (outcome.allocated) {
+        auto& entry = m_entries.at(outcome.slot);
+        entry.block = outcome.oldBlock;
+        entry.drainedCycle = outcome.oldDrainedCycle;
+    }
+    m_now = outcome.oldNow;
+}
+
+}  // namespace Ripes
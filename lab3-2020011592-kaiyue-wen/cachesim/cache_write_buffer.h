@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Ripes {
+
+/**
+ * @brief The CacheWriteBuffer class
+ * Coalescing write buffer between a cache and the next level of the memory hierarchy. Writes are placed in the buffer
+ * and drained to memory in order, one entry every drain interval. A write to a block which has an entry waiting to be
+ * drained is merged into that entry; otherwise it allocates a new entry, stalling until the oldest entry has drained
+ * if the buffer is full.
+ *
+ * Like CacheMshrFile, the buffer keeps its own notion of time, advanced to the cycle of each write and by each stall.
+ * The buffer operates on block addresses (ie. the address with the block- and byte offset bits removed).
+ */
+class CacheWriteBuffer {
+public:
+    /**
+     * @brief The Outcome struct
+     * Result of a write, and the buffer state it replaced (for revert()).
+     */
+    struct Outcome {
+        bool coalesced = false;    // True if the write merged into an entry waiting to be drained
+        unsigned stallCycles = 0;  // Cycles spent waiting for a free entry
+
+        bool allocated = false;
+        unsigned slot = 0;
+        uint64_t oldBlock = 0;
+        uint64_t oldDrainedCycle = 0;
+        uint64_t oldNow = 0;
+    };
+
+    /**
+     * @brief reset
+     * Clears the buffer and resizes it to @p entries entries, draining an entry every @p drainCycles cycles. With 0
+     * entries, the buffer is disabled and writes go directly to memory.
+     */
+    void reset(unsigned entries, unsigned drainCycles);
+    bool isEnabled() const { return !m_entries.empty(); }
+
+    /**
+     * @brief write
+     * Places a write to @p block in the buffer in @p cycle.
+     */
+    Outcome write(uint64_t block, uint64_t cycle);
+
+    /**
+     * @brief revert
+     * Reverts the most recent write not yet reverted, which returned @p outcome.
+     */
+    void revert(const Outcome& outcome);
+
+private:
+    struct Entry {
+        uint64_t block = 0;
+        uint64_t drainedCycle = 0;  // The entry is free once the current cycle reaches the drained cycle
+    };
+
+    std::vector<Entry> m_entries;
+    unsigned m_drainCycles = 1;
+    uint64_t m_now = 0;
+};
+
+}  // namespace Ripes
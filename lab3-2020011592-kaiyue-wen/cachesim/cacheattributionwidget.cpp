@@ -0,0 +1,131 @@
+#include "cacheattributionwidget.h"
+
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QLabel>
+#include <QTabWidget>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+#include "radix.h"
+
+namespace {
+
+enum CounterColumn { Key = 0, Accesses, Hits, Misses, Writebacks, MissRate, MissShare, N_Columns };
+
+QTableWidgetItem* numericItem(double value) {
+    // Storing the value in the display role (rather than as text) ensures that the table sorts numerically
+    auto* item = new QTableWidgetItem();
+    item->setData(Qt::DisplayRole, value);
+    item->setFlags(item->flags() & ~Qt::ItemIsEditable);
+    return item;
+}
+
+}  // namespace
+
+namespace Ripes {
+
+CacheAttributionWidget::CacheAttributionWidget(const CacheSim& sim, QWidget* parent) : QDialog(parent), m_cache(sim) {
+    setWindowTitle("Cache Miss Attribution");
+    resize(640, 480);
+
+    auto* layout = new QVBoxLayout(this);
+    m_tabs = new QTabWidget(this);
+    layout->addWidget(m_tabs);
+
+    auto* buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    layout->addWidget(buttons);
+
+    setupInstructionTable();
+    setupRegionTable();
+    setupSymbolTable();
+}
+
+QTableWidget* CacheAttributionWidget::createCounterTable(const QString& keyHeader, int rows) {
+    auto* table = new QTableWidget(rows, N_Columns, this);
+    table->setHorizontalHeaderLabels(
+        {keyHeader, "Accesses", "Hits", "Misses", "Writebacks", "Miss rate (%)", "Share of misses (%)"});
+    table->verticalHeader()->hide();
+    table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    return table;
+}
+
+void CacheAttributionWidget::setCounterRow(QTableWidget* table, int row, const QString& key,
+                                           const AccessCounters& counters, int totalMisses) {
+    auto* keyItem = new QTableWidgetItem(key);
+    keyItem->setFlags(keyItem->flags() & ~Qt::ItemIsEditable);
+    table->setItem(row, Key, keyItem);
+    table->setItem(row, Accesses, numericItem(counters.accesses));
+    table->setItem(row, Hits, numericItem(counters.hits));
+    table->setItem(row, Misses, numericItem(counters.misses));
+    table->setItem(row, Writebacks, numericItem(counters.writebacks));
+    table->setItem(row, MissRate, numericItem(counters.missRate() * 100));
+    table->setItem(row, MissShare,
+                   numericItem(totalMisses == 0 ? 0 : static_cast<double>(counters.misses) / totalMisses * 100));
+}
+
+void CacheAttributionWidget::setupInstructionTable() {
+    const auto& attribution = m_cache.getAttribution();
+    const auto pcs = attribution.getTopPCs(CacheAttribution::SortKey::Misses);
+    if (pcs.empty() && attribution.getUnattributedAccesses() > 0) {
+        // An empty table would suggest that no instruction missed in the cache
+        auto* label = new QLabel(
+            "Instruction attribution is unavailable: the accesses of this cache were not reported along with the PC "
+            "of the accessing instruction. Accesses are still attributed to memory regions and symbols.",
+            this);
+        label->setWordWrap(true);
+        label->setAlignment(Qt::AlignCenter);
+        m_tabs->addTab(label, "Instructions");
+        return;
+    }
+
+    auto* table = createCounterTable("PC", pcs.size());
+    // Sorting is disabled whilst populating the table, to avoid rows being moved as items are inserted
+    table->setSortingEnabled(false);
+    for (unsigned i = 0; i < pcs.size(); i++) {
+        const QString pc = m_cache.getAddressBits() > 32
+                               ? "0x" + QString::number(pcs[i].first, 16).rightJustified(16, '0')
+                               : encodeRadixValue(static_cast<uint32_t>(pcs[i].first), Radix::Hex);
+        setCounterRow(table, i, pc, pcs[i].second, static_cast<int>(m_cache.getMisses()));
+    }
+    table->setSortingEnabled(true);
+    table->sortByColumn(Misses, Qt::DescendingOrder);
+
+    m_tabs->addTab(table, "Instructions");
+}
+
+void CacheAttributionWidget::setupRegionTable() {
+    const auto& attribution = m_cache.getAttribution();
+    const auto& regions = attribution.getRegions();
+    const auto& counters = attribution.getRegionCounters();
+
+    auto* table = createCounterTable("Region", regions.size());
+    table->setSortingEnabled(false);
+    for (unsigned i = 0; i < regions.size(); i++) {
+        const QString key = regions[i].name + " [" + encodeRadixValue(regions[i].start, Radix::Hex) + "; " +
+                            encodeRadixValue(regions[i].end, Radix::Hex) + "]";
+        setCounterRow(table, i, key, counters[i], static_cast<int>(m_cache.getMisses()));
+    }
+    table->setSortingEnabled(true);
+    table->sortByColumn(Misses, Qt::DescendingOrder);
+
+    m_tabs->addTab(table, "Memory regions");
+}
+
+void CacheAttributionWidget::setupSymbolTable() {
+    const auto symbols = m_cache.getSymbolAttribution().getCounters();
+
+    auto* table = createCounterTable("Symbol", symbols.size());
+    table->setSortingEnabled(false);
+    for (unsigned i = 0; i < symbols.size(); i++) {
+        setCounterRow(table, i, symbols[i].first, symbols[i].second, static_cast<int>(m_cache.getMisses()));
+    }
+    table->setSortingEnabled(true);
+    table->sortByColumn(Misses, Qt::DescendingOrder);
+
+    m_tabs->addTab(table, "Symbols");
+}
+
+}  // namespace Ripes
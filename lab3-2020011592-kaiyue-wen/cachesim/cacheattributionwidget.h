@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QDialog>
+
+#include "cachesim.h"
+
+QT_FORWARD_DECLARE_CLASS(QTableWidget);
+QT_FORWARD_DECLARE_CLASS(QTabWidget);
+
+namespace Ripes {
+
+/**
+ * @brief The CacheAttributionWidget class
+ * Dialog presenting the cache accesses of the current run, attributed to the instructions which performed them, as
+ * well as the memory regions and program symbols they accessed. All tables are sortable by clicking a column header;
+ * by default, rows are sorted by their number of misses.
+ */
+class CacheAttributionWidget : public QDialog {
+    Q_OBJECT
+
+public:
+    explicit CacheAttributionWidget(const CacheSim& sim, QWidget* parent = nullptr);
+
+private:
+    void setupInstructionTable();
+    void setupRegionTable();
+    void setupSymbolTable();
+
+    /**
+     * @brief createCounterTable
+     * Creates a table with a single key column named @p keyHeader, followed by a column for each access counter.
+     */
+    QTableWidget* createCounterTable(const QString& keyHeader, int rows);
+    void setCounterRow(QTableWidget* table, int row, const QString& key, const AccessCounters& counters,
+                       int totalMisses);
+
+    const CacheSim& m_cache;
+    QTabWidget* m_tabs = nullptr;
+};
+
+}  // namespace Ripes
@@ -1,13 +1,23 @@
 #include "cacheconfigwidget.h"
 #include "ui_cacheconfigwidget.h"
 
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QFileDialog>
+#include <QFormLayout>
+#include <QInputDialog>
+#include <QLineEdit>
 #include <QMessageBox>
 #include <QPushButton>
+#include <QSignalBlocker>
 #include <QSpinBox>
 #include <QToolButton>
 #include <QtCharts/QChartView>
+#include <tuple>
 
+#include "cacheattributionwidget.h"
 #include "cacheplotwidget.h"
+#include "cacheshadowwidget.h"
 #include "enumcombobox.h"
 
 namespace Ripes {
@@ -16,8 +26,9 @@ CacheConfigWidget::CacheConfigWidget(QWidget* parent) : QWidget(parent), m_ui(ne
     m_ui->setupUi(this);
 
     // Gather a list of all items in this widget which will trigger a modification to the current configuration
-    m_configItems = {m_ui->presets,           m_ui->ways,   m_ui->sets, m_ui->blocks,
-                     m_ui->replacementPolicy, m_ui->wrMiss, m_ui->wrHit, m_ui->skewed};
+    m_configItems = {m_ui->presets, m_ui->ways,   m_ui->sets,  m_ui->blocks, m_ui->sectors, m_ui->wordSize,
+                     m_ui->sampleSets, m_ui->replacementPolicy, m_ui->wrMiss, m_ui->wrHit, m_ui->skewed,
+                     m_ui->indexFunction, m_ui->wayPrediction};
 }
 
 void CacheConfigWidget::setCache(CacheSim* cache) {
@@ -30,14 +41,37 @@ void CacheConfigWidget::setCache(CacheSim* cache) {
     m_ui->cachePlot->setIcon(plotIcon);
     connect(m_ui->cachePlot, &QPushButton::clicked, this, &CacheConfigWidget::showCachePlot);
 
+    const QIcon attributionIcon = QIcon(":/icons/documents.svg");
+    m_ui->cacheAttribution->setIcon(attributionIcon);
+    connect(m_ui->cacheAttribution, &QPushButton::clicked, this, &CacheConfigWidget::showCacheAttribution);
+
+    const QIcon timingIcon = QIcon(":/icons/gear.svg");
+    m_ui->cacheTiming->setIcon(timingIcon);
+    connect(m_ui->cacheTiming, &QPushButton::clicked, this, &CacheConfigWidget::showCacheTiming);
+
+    // Shadow caches do not have shadows of their own
+    m_ui->cacheShadows->setVisible(!m_cache->isShadow());
+    connect(m_ui->cacheShadows, &QPushButton::clicked, this, &CacheConfigWidget::showCacheShadows);
+
+    const QIcon captureIcon = QIcon(":/icons/saveas.svg");
+    m_ui->captureTrace->setIcon(captureIcon);
+    // Shadow caches are not accessed by the processor
+    m_ui->captureTrace->setVisible(!m_cache->isShadow());
+    connect(m_ui->captureTrace, &QToolButton::toggled, this, &CacheConfigWidget::toggleCapture);
+
     setupEnumCombobox(m_ui->replacementPolicy, s_cacheReplPolicyStrings);
     setupEnumCombobox(m_ui->wrHit, s_cacheWritePolicyStrings);
     setupEnumCombobox(m_ui->wrMiss, s_cacheWriteAllocateStrings);
     setupEnumCombobox(m_ui->skewed, s_cacheSkewedAssocStrings);
+    setupEnumCombobox(m_ui->indexFunction, s_cacheIndexFunctionStrings);
+    setupEnumCombobox(m_ui->wayPrediction, s_cacheWayPredictionStrings);
+    m_ui->wordSize->addItem("32-bit", 2);
+    m_ui->wordSize->addItem("64-bit", 3);
 
     m_ui->ways->setValue(m_cache->getWaysBits());
     m_ui->sets->setValue(m_cache->getSetBits());
     m_ui->blocks->setValue(m_cache->getBlockBits());
+    m_ui->sectors->setValue(m_cache->getSectorBits());
 
     m_ui->indexingKey->setText(
         "<font color=\"gray\">█</font> = Tag &nbsp; <font color=\"red\">█</font> = Index &nbsp; <font "
@@ -46,6 +80,8 @@ void CacheConfigWidget::setCache(CacheSim* cache) {
     connect(m_ui->ways, QOverload<int>::of(&QSpinBox::valueChanged), m_cache, &CacheSim::setWays);
     connect(m_ui->blocks, QOverload<int>::of(&QSpinBox::valueChanged), m_cache, &CacheSim::setBlocks);
     connect(m_ui->sets, QOverload<int>::of(&QSpinBox::valueChanged), m_cache, &CacheSim::setSets);
+    connect(m_ui->sectors, QOverload<int>::of(&QSpinBox::valueChanged), m_cache, &CacheSim::setSectors);
+    connect(m_ui->sampleSets, QOverload<int>::of(&QSpinBox::valueChanged), m_cache, &CacheSim::setSampleBits);
     connect(m_ui->sizeBreakdownButton, &QPushButton::clicked, this, &CacheConfigWidget::showSizeBreakdown);
 
     connect(m_ui->replacementPolicy, QOverload<int>::of(&QComboBox::currentIndexChanged), [=](int index) {
@@ -60,6 +96,18 @@ void CacheConfigWidget::setCache(CacheSim* cache) {
     connect(m_ui->skewed, QOverload<int>::of(&QComboBox::currentIndexChanged), [=](int index) {
         m_cache->setSkewedAssocPolicy(qvariant_cast<CacheSim::SkewedAssocPolicy>(m_ui->skewed->itemData(index)));
     });
+    connect(m_ui->indexFunction, QOverload<int>::of(&QComboBox::currentIndexChanged), [=](int index) {
+        const auto function = qvariant_cast<CacheSim::IndexFunction>(m_ui->indexFunction->itemData(index));
+        if (function == CacheSim::IndexFunction::XorMatrix) {
+            editIndexMatrix();
+        }
+        m_cache->setIndexFunction(function);
+    });
+    connect(m_ui->wayPrediction, QOverload<int>::of(&QComboBox::currentIndexChanged), [=](int index) {
+        m_cache->setWayPrediction(qvariant_cast<CacheSim::WayPredictionPolicy>(m_ui->wayPrediction->itemData(index)));
+    });
+    connect(m_ui->wordSize, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            [=](int index) { m_cache->setWordBits(m_ui->wordSize->itemData(index).toUInt()); });
 
     connect(m_cache, &CacheSim::configurationChanged, this, &CacheConfigWidget::handleConfigurationChanged);
     connect(m_cache, &CacheSim::configurationChanged, [=] { emit configurationChanged(); });
@@ -74,6 +122,122 @@ void CacheConfigWidget::showCachePlot() {
     plotWidget.exec();
 }
 
+void CacheConfigWidget::showCacheAttribution() {
+    CacheAttributionWidget attributionWidget(*m_cache);
+    attributionWidget.exec();
+}
+
+void CacheConfigWidget::showCacheShadows() {
+    // The dialog is not modal, such that the comparison is updated as the processor is stepped. A single dialog manages
+    // the shadows of the cache.
+    if (m_shadowWidget.isNull()) {
+        m_shadowWidget = new CacheShadowWidget(*m_cache, this);
+        m_shadowWidget->setAttribute(Qt::WA_DeleteOnClose);
+    }
+    m_shadowWidget->show();
+    m_shadowWidget->raise();
+}
+
+void CacheConfigWidget::toggleCapture(bool enabled) {
+    if (!enabled) {
+        // The processor thread may be appending to the capture until it is stopped
+        if (!m_cache->stopCapture()) {
+            QMessageBox::warning(this, "Capture trace", QString::fromStdString(m_cache->getCapture().errorString()));
+        } else {
+            m_ui->captureTrace->setToolTip("Captured " + QString::number(m_cache->getCapture().getRecords()) +
+                                           " records");
+        }
+        return;
+    }
+
+    const QString filename =
+        QFileDialog::getSaveFileName(this, "Capture trace", "", "Cache access traces (*.rcat);;All files (*)");
+    if (filename.isEmpty() || !m_cache->startCapture(filename.toStdString())) {
+        if (!filename.isEmpty()) {
+            QMessageBox::warning(this, "Capture trace", QString::fromStdString(m_cache->getCapture().errorString()));
+        }
+        // Restore the unchecked state without re-entering this slot
+        const QSignalBlocker blocker(m_ui->captureTrace);
+        m_ui->captureTrace->setChecked(false);
+        return;
+    }
+    m_ui->captureTrace->setToolTip("Capturing to " + filename + "; click to stop");
+}
+
+void CacheConfigWidget::editIndexMatrix() {
+    QStringList rows;
+    for (const uint64_t row : m_cache->getIndexMatrix()) {
+        rows << "0x" + QString::number(row, 16);
+    }
+
+    bool ok = false;
+    const QString text = QInputDialog::getText(
+        this, "XOR index matrix",
+        "Block address bit masks, one per set index bit (least significant first), separated by commas:",
+        QLineEdit::Normal, rows.join(", "), &ok);
+    if (!ok) {
+        return;
+    }
+
+    std::vector<uint64_t> matrix;
+    for (const QString& row : text.split(',')) {
+        if (row.trimmed().isEmpty()) {
+            continue;
+        }
+        matrix.push_back(row.trimmed().toULongLong(&ok, 0));
+        if (!ok) {
+            QMessageBox::warning(this, "XOR index matrix", "Invalid row '" + row.trimmed() + "'");
+            return;
+        }
+    }
+    m_cache->setIndexMatrix(matrix);
+}
+
+void CacheConfigWidget::showCacheTiming() {
+    QDialog dialog(this);
+    dialog.setWindowTitle("Cache timing");
+    auto* layout = new QFormLayout(&dialog);
+
+    // MSHRs and write buffer entries are searched on each access, and are limited to a realistic number
+    CacheSim::TimingConfig timing = m_cache->getTiming();
+    const std::vector<std::tuple<QString, QString, unsigned*, int /*min*/, int /*max*/>> fields = {
+        {"Hit latency:", "Cycles to access the cache", &timing.hitLatency, 0, 10000},
+        {"Miss penalty:", "Cycles until the next level starts delivering a missed line", &timing.missPenalty, 0, 10000},
+        {"Writeback cost:", "Cycles until the next level starts accepting written data", &timing.writebackCost, 0,
+         10000},
+        {"Bandwidth (bytes/cycle):", "Bytes transferred per cycle to or from the next level", &timing.bytesPerCycle, 1,
+         10000},
+        {"MSHRs:", "Outstanding misses of a non-blocking cache; 0 for a blocking cache", &timing.mshrs, 0, 64},
+        {"Write buffer entries:", "Entries of the coalescing write buffer for written through words; 0 for none",
+         &timing.writeBufferEntries, 0, 64},
+        {"Write buffer drain (cycles):", "Cycles to drain an entry of the write buffer to the next level",
+         &timing.writeBufferDrainCycles, 1, 10000},
+        {"Second probe latency:", "Extra cycles of a lookup which does not find the line in the predicted way",
+         &timing.secondProbeLatency, 0, 10000}};
+
+    std::vector<QSpinBox*> spinBoxes;
+    for (const auto& [label, toolTip, value, min, max] : fields) {
+        auto* spinBox = new QSpinBox(&dialog);
+        spinBox->setRange(min, max);
+        spinBox->setValue(*value);
+        spinBox->setToolTip(toolTip);
+        layout->addRow(label, spinBox);
+        spinBoxes.push_back(spinBox);
+    }
+
+    auto* buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    layout->addRow(buttons);
+
+    if (dialog.exec() == QDialog::Accepted) {
+        for (size_t i = 0; i < fields.size(); i++) {
+            *std::get<2>(fields[i]) = spinBoxes[i]->value();
+        }
+        m_cache->setTiming(timing);
+    }
+}
+
 void CacheConfigWidget::setupPresets() {
     std::vector<std::pair<QString, CacheSim::CachePreset>> presets;
 
@@ -116,10 +280,19 @@ void CacheConfigWidget::handleConfigurationChanged() {
     m_ui->ways->setValue(m_cache->getWaysBits());
     m_ui->sets->setValue(m_cache->getSetBits());
     m_ui->blocks->setValue(m_cache->getBlockBits());
+    // The number of sectors is bounded by the number of blocks
+    m_ui->sectors->setMaximum(std::min(m_cache->getBlockBits(), 5));
+    m_ui->sectors->setValue(m_cache->getSectorBits());
+    // At least one set is sampled
+    m_ui->sampleSets->setMaximum(m_cache->getSetBits());
+    m_ui->sampleSets->setValue(m_cache->getSampleBits());
     setEnumIndex(m_ui->wrHit, m_cache->getWritePolicy());
     setEnumIndex(m_ui->wrMiss, m_cache->getWriteAllocPolicy());
     setEnumIndex(m_ui->replacementPolicy, m_cache->getReplacementPolicy());
     setEnumIndex(m_ui->skewed, m_cache->getSkewedPolicy());
+    setEnumIndex(m_ui->indexFunction, m_cache->getIndexFunction());
+    setEnumIndex(m_ui->wayPrediction, m_cache->getWayPrediction());
+    m_ui->wordSize->setCurrentIndex(m_ui->wordSize->findData(m_cache->getByteOffsetBits()));
 
     if (!m_justSetPreset) {
         m_ui->presets->setCurrentIndex(-1);
@@ -134,10 +307,27 @@ void CacheConfigWidget::handleConfigurationChanged() {
 }
 
 void CacheConfigWidget::updateHitrate() {
-    m_ui->hitrate->setText(QString::number(m_cache->getHitRate(), 'G', 4));
+    const auto estimate = m_cache->getHitRateEstimate();
+    if (estimate.sampled) {
+        // Counters cover the sampled sets only; the hit rate is extrapolated to the full cache
+        m_ui->hitrate->setText("~" + QString::number(estimate.hitRate, 'G', 4) + " ± " +
+                               QString::number(estimate.halfWidth, 'G', 2) + " (sampled)");
+    } else {
+        m_ui->hitrate->setText(QString::number(estimate.hitRate, 'G', 4));
+    }
     m_ui->hits->setText(QString::number(m_cache->getHits()));
     m_ui->misses->setText(QString::number(m_cache->getMisses()));
     m_ui->writebacks->setText(QString::number(m_cache->getWritebacks()));
+    m_ui->amat->setText(QString::number(m_cache->getAMAT(), 'G', 4));
+    m_ui->stallCycles->setText(QString::number(m_cache->getStallCycles()));
+    if (m_cache->getWayPrediction() != CacheSim::WayPredictionPolicy::None) {
+        const auto wayPrediction = m_cache->getWayPredictionStats();
+        m_ui->firstProbeHits->setText(QString::number(wayPrediction.firstProbeHitRate, 'G', 4));
+        m_ui->wayReadsSaved->setText(QString::number(wayPrediction.wayReadsSaved, 'G', 4));
+    } else {
+        m_ui->firstProbeHits->setText("-");
+        m_ui->wayReadsSaved->setText("-");
+    }
 }
 
 void CacheConfigWidget::showSizeBreakdown() {
@@ -162,7 +352,11 @@ void CacheConfigWidget::updateIndexingText() {
     QString indexingText = " 0";
 
     // Byte offset bits
-    indexingText = "<font color=\"black\">▊▊</font>" + indexingText;
+    QString bytes = "";
+    for (int i = 0; i < m_cache->getByteOffsetBits(); i++) {
+        bytes += "▊";
+    }
+    indexingText = "<font color=\"black\">" + bytes + "</font>" + indexingText;
 
     // Block offset bits
     QString blocks = "";
@@ -187,7 +381,7 @@ void CacheConfigWidget::updateIndexingText() {
 
     indexingText = "<font color=\"gray\">" + tag + "</font>" + indexingText;
 
-    indexingText = "31 " + indexingText;
+    indexingText = QString::number(m_cache->getAddressBits() - 1) + " " + indexingText;
 
     m_ui->indexingText->setText(indexingText);
 }
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <QPointer>
 #include <QWidget>
 #include "cachesim.h"
 
 namespace Ripes {
 
+class CacheShadowWidget;
+
 namespace Ui {
 class CacheConfigWidget;
 }
@@ -25,15 +28,21 @@ public slots:
     void updateHitrate();
     void handleConfigurationChanged();
     void showCachePlot();
+    void showCacheAttribution();
+    void showCacheTiming();
+    void showCacheShadows();
+    void toggleCapture(bool enabled);
 
 private:
     void updateCacheSize();
     void updateIndexingText();
     void setupPresets();
     void showSizeBreakdown();
+    void editIndexMatrix();
     CacheSim* m_cache;
     Ui::CacheConfigWidget* m_ui = nullptr;
     std::vector<QObject*> m_configItems;
+    QPointer<CacheShadowWidget> m_shadowWidget;
 
     /**
      * @brief m_justSetPreset
@@ -52,3 +61,5 @@ Q_DECLARE_METATYPE(Ripes::CacheSim::WriteAllocPolicy);
 Q_DECLARE_METATYPE(Ripes::CacheSim::ReplPolicy);
 Q_DECLARE_METATYPE(Ripes::CacheSim::CachePreset);
 Q_DECLARE_METATYPE(Ripes::CacheSim::SkewedAssocPolicy);
+Q_DECLARE_METATYPE(Ripes::CacheSim::IndexFunction);
+Q_DECLARE_METATYPE(Ripes::CacheSim::WayPredictionPolicy);
@@ -1,30 +1,36 @@
 #include "cachegraphic.h"
 
-#include <QGraphicsLineItem>
-#include <QGraphicsRectItem>
-#include <QGraphicsScene>
-#include <QGraphicsSimpleTextItem>
+#include <QGraphicsSceneHoverEvent>
+#include <QPainter>
 #include <QPen>
+#include <QStyleOptionGraphicsItem>
 
 #include "processorhandler.h"
 #include "radix.h"
 
 namespace {
 
-// Return a set of all keys in a map
-template <typename TK, typename TV>
-std::set<TK> keys(std::map<TK, TV> const& input_map) {
-    std::set<TK> keyset;
-    for (auto const& element : input_map) {
-        keyset.insert(element.first);
+// Upper bound on the number of cached way glyphs. Reached when scrolling through a large cache, after which the glyph
+// cache is flushed and lazily rebuilt for the ways on screen.
+constexpr unsigned s_maxCachedGlyphs = 8192;
+
+// Formats a value of @p bytes bytes as a zero-padded hexadecimal string
+QString encodeHex(uint64_t value, unsigned bytes) {
+    if (bytes <= 4) {
+        return Ripes::encodeRadixValue(static_cast<uint32_t>(value), Ripes::Radix::Hex);
     }
-    return keyset;
+    return "0x" + QString::number(value, 16).rightJustified(2 * bytes, '0');
 }
+
 }  // namespace
 
 namespace Ripes {
 
 CacheGraphic::CacheGraphic(CacheSim& cache) : QGraphicsObject(nullptr), m_cache(cache), m_fm(m_font) {
+    // Required for the exposed rect to be provided to paint()
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    setAcceptHoverEvents(true);
+
     connect(&cache, &CacheSim::configurationChanged, this, &CacheGraphic::cacheParametersChanged);
     connect(&cache, &CacheSim::dataChanged, this, &CacheGraphic::dataChanged);
     connect(&cache, &CacheSim::wayInvalidated, this, &CacheGraphic::wayInvalidated);
@@ -33,355 +39,390 @@ CacheGraphic::CacheGraphic(CacheSim& cache) : QGraphicsObject(nullptr), m_cache(
     cacheParametersChanged();
 }
 
-void CacheGraphic::updateSetReplFields(unsigned setIdx) {
-    auto* cacheSet = m_cache.getSet(setIdx);
-
-    if (cacheSet == nullptr) {
-        // Nothing to do
-        return;
-    }
+QRectF CacheGraphic::setRect(unsigned setIdx) const {
+    return QRectF(0, setIdx * m_setHeight, m_cacheWidth, m_setHeight);
+}
 
-    if (m_cacheTextItems.at(0).at(0).counter == nullptr) {
-        // The current cache configuration does not have any replacement field
-        return;
-    }
+QRectF CacheGraphic::blockRect(unsigned setIdx, unsigned wayIdx, unsigned blockIdx) const {
+    return QRectF(m_widthBeforeBlocks + blockIdx * m_blockWidth, setIdx * m_setHeight + wayIdx * m_wayHeight,
+                  m_blockWidth, m_wayHeight);
+}
 
-    for (const auto& way : m_cacheTextItems[setIdx]) {
-        // If counter was just initialized, the actual (software) counter value may be very large. Mask to the
-        // number of actual counter bits.
-        unsigned counterVal = cacheSet->at(way.first).counter;
-        counterVal &= generateBitmask(m_cache.getWaysBits());
-        const QString counterText = QString::number(counterVal);
-        way.second.counter->setText(counterText);
+void CacheGraphic::drawCentered(QPainter* painter, const QStaticText& text, qreal columnX, qreal columnWidth,
+                                qreal y) const {
+    painter->drawStaticText(QPointF(columnX + columnWidth / 2 - text.size().width() / 2, y), text);
+}
 
-        // Counter text might have changed; update counter field position to center in column
-        const qreal y = setIdx * m_setHeight + way.first * m_wayHeight;
-        const qreal x = m_widthBeforeCounter + m_counterWidth / 2 - m_fm.width(counterText) / 2;
+void CacheGraphic::rebuildWayGlyphs(WayGlyphs& glyphs, unsigned setIdx, unsigned wayIdx) const {
+    // Ways which have not yet been touched by the simulator are drawn in their reset state
+    CacheWay simWay;
+    if (const auto* cacheSet = m_cache.getSet(setIdx)) {
+        const auto it = cacheSet->find(wayIdx);
+        if (it != cacheSet->end()) {
+            simWay = it->second;
+        }
+    }
 
-        way.second.counter->setPos(x, y);
+    if (m_cache.getSectors() > 1) {
+        // Sector valid bits, with sector 0 leftmost such that the bits line up with the blocks of the line
+        QString validText;
+        for (int i = 0; i < m_cache.getSectors(); i++) {
+            validText += simWay.valid && (simWay.validSectors >> i & 1) ? '1' : '0';
+        }
+        glyphs.valid.setText(validText);
+    } else {
+        glyphs.valid.setText(QString::number(simWay.valid));
     }
-}
+    glyphs.dirtyBit.setText(QString::number(simWay.dirty));
+
+    // If counter was just initialized, the actual (software) counter value may be very large. Mask to the number of
+    // actual counter bits.
+    glyphs.counter.setText(QString::number(simWay.counter & generateBitmask(m_cache.getWaysBits())));
 
-void CacheGraphic::updateWay(unsigned setIdx, unsigned wayIdx) {
-    CacheWay& way = m_cacheTextItems.at(setIdx).at(wayIdx);
-    const auto& simWay = m_cache.getSet(setIdx)->at(wayIdx);
-    // ======================== Update block text fields ======================
+    glyphs.blocks.clear();
     if (simWay.valid) {
+        glyphs.tag.setText(encodeHex(simWay.tag, m_cache.getAddressBits() / 8));
         for (int i = 0; i < m_cache.getBlocks(); i++) {
-            QGraphicsSimpleTextItem* blockTextItem = nullptr;
-            if (way.blocks.count(i) == 0) {
-                // Block text item has not yet been created
-                const qreal x =
-                    m_widthBeforeBlocks + i * m_blockWidth + (m_blockWidth / 2 - m_fm.width("0x00000000") / 2);
-                const qreal y = setIdx * m_setHeight + wayIdx * m_wayHeight;
-
-                way.blocks[i] = createGraphicsTextItemSP(x, y);
-                blockTextItem = way.blocks[i].get();
-            } else {
-                blockTextItem = way.blocks.at(i).get();
+            if ((simWay.validSectors >> (i / m_cache.getSectorBlocks()) & 1) == 0) {
+                // Blocks of unfilled sectors hold no data
+                glyphs.blocks.emplace_back();
+                continue;
             }
-
-            // Update block text
-            const uint32_t addressForBlock = m_cache.buildAddress(simWay.tag, setIdx, i);
-            const auto data = ProcessorHandler::get()->getMemory().readMemConst(addressForBlock);
-            const QString text = encodeRadixValue(data, Radix::Hex);
-            blockTextItem->setText(text);
-            blockTextItem->setToolTip("Address: " + encodeRadixValue(addressForBlock, Radix::Hex));
-            // Store the address within the userrole of the block text. Doing this, we are able to easily retrieve the
-            // address for the block if the block is clicked.
-            blockTextItem->setData(Qt::UserRole, addressForBlock);
+            // The memory of the processor has a 32-bit address space
+            const uint32_t addressForBlock = static_cast<uint32_t>(m_cache.buildAddress(simWay.tag, setIdx, i));
+            const auto& memory = ProcessorHandler::get()->getMemory();
+            uint64_t data = memory.readMemConst(addressForBlock);
+            if (m_cache.getWordBytes() == 8) {
+                // Memory is read in 32-bit words; 64-bit words are stored in little-endian order
+                data |= static_cast<uint64_t>(memory.readMemConst(addressForBlock + 4)) << 32;
+            }
+            glyphs.blocks.emplace_back(encodeHex(data, m_cache.getWordBytes()));
         }
     } else {
-        // The way is invalid so no block text should be present
-        way.blocks.clear();
+        glyphs.tag.setText(QString());
     }
 
-    // =========================== Update dirty field =========================
-    if (way.dirty) {
-        way.dirty->setText(QString::number(simWay.dirty));
+    for (auto* text : {&glyphs.valid, &glyphs.dirtyBit, &glyphs.counter, &glyphs.tag}) {
+        text->prepare(QTransform(), m_font);
+    }
+    for (auto& block : glyphs.blocks) {
+        block.prepare(QTransform(), m_font);
     }
+    glyphs.dirty = false;
+}
 
-    // =========================== Update valid field =========================
-    if (way.valid) {
-        way.valid->setText(QString::number(simWay.valid));
+const CacheGraphic::WayGlyphs& CacheGraphic::wayGlyphs(unsigned setIdx, unsigned wayIdx) {
+    if (m_glyphs.size() >= s_maxCachedGlyphs) {
+        m_glyphs.clear();
+    }
+    WayGlyphs& glyphs = m_glyphs[setIdx * m_cache.getWays() + wayIdx];
+    if (glyphs.dirty) {
+        rebuildWayGlyphs(glyphs, setIdx, wayIdx);
     }
+    return glyphs;
+}
 
-    // ============================ Update tag field ==========================
-    if (simWay.valid) {
-        QGraphicsSimpleTextItem* tagTextItem = way.tag.get();
-        if (tagTextItem == nullptr) {
-            const qreal x = m_widthBeforeTag + (m_tagWidth / 2 - m_fm.width("0x00000000") / 2);
-            const qreal y = setIdx * m_setHeight + wayIdx * m_wayHeight;
-            way.tag = createGraphicsTextItemSP(x, y);
-            tagTextItem = way.tag.get();
-        }
-        const QString tagText = encodeRadixValue(simWay.tag, Radix::Hex);
-        tagTextItem->setText(tagText);
-    } else {
-        // The way is invalid so no tag text should be present
-        if (way.tag) {
-            way.tag.reset();
-        }
+void CacheGraphic::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget*) {
+    painter->setFont(m_font);
+
+    if (option->exposedRect.top() < 0) {
+        paintHeader(painter);
     }
 
-    // ==================== Update dirty blocks highlighting ==================
-    const std::set<unsigned> graphicDirtyBlocks = keys(way.dirtyBlocks);
-    std::set<unsigned> newDirtyBlocks;
-    std::set<unsigned> dirtyBlocksToDelete;
-    std::set_difference(graphicDirtyBlocks.begin(), graphicDirtyBlocks.end(), simWay.dirtyBlocks.begin(),
-                        simWay.dirtyBlocks.end(), std::inserter(dirtyBlocksToDelete, dirtyBlocksToDelete.begin()));
-    std::set_difference(simWay.dirtyBlocks.begin(), simWay.dirtyBlocks.end(), graphicDirtyBlocks.begin(),
-                        graphicDirtyBlocks.end(), std::inserter(newDirtyBlocks, newDirtyBlocks.begin()));
+    if (m_setHeight == 0) {
+        return;
+    }
 
-    // Delete blocks which are not in sync with the current dirty status of the way
-    for (const unsigned& blockToDelete : dirtyBlocksToDelete) {
-        way.dirtyBlocks.erase(blockToDelete);
+    // Only the sets which are currently exposed are painted
+    const int firstSet = std::max(0, static_cast<int>(option->exposedRect.top() / m_setHeight));
+    const int lastSet =
+        std::min(m_cache.getSets() - 1, static_cast<int>(option->exposedRect.bottom() / m_setHeight));
+    if (firstSet > lastSet) {
+        return;
     }
-    // Create all required new blocks
-    for (const auto& blockIdx : newDirtyBlocks) {
-        const auto topLeft =
-            QPointF(blockIdx * m_blockWidth + m_widthBeforeBlocks, setIdx * m_setHeight + wayIdx * m_wayHeight);
-        const auto bottomRight = QPointF((blockIdx + 1) * m_blockWidth + m_widthBeforeBlocks,
-                                         setIdx * m_setHeight + (wayIdx + 1) * m_wayHeight);
-        way.dirtyBlocks[blockIdx] = std::make_unique<QGraphicsRectItem>(QRectF(topLeft, bottomRight), this);
 
-        const auto& dirtyRectItem = way.dirtyBlocks[blockIdx];
-        dirtyRectItem->setZValue(-1);
-        dirtyRectItem->setOpacity(0.4);
-        dirtyRectItem->setBrush(Qt::darkCyan);
+    paintSetShading(painter, firstSet, lastSet);
+    paintHighlighting(painter);
+    for (int setIdx = firstSet; setIdx <= lastSet; setIdx++) {
+        paintSet(painter, setIdx);
     }
+    paintGrid(painter, firstSet, lastSet);
+}
+
+void CacheGraphic::paintHeader(QPainter* painter) const {
+    const qreal y = -m_fm.height();
+    const auto drawHeaderText = [&](const QString& text, qreal x, qreal width) {
+        painter->drawText(QPointF(x + width / 2 - m_fm.width(text) / 2, y + m_fm.ascent()), text);
+    };
 
+    drawHeaderText("Index", -m_indexWidth, m_indexWidth);
+    drawHeaderText("V", 0, m_validWidth);
+    if (m_hasDirtyColumn) {
+        drawHeaderText("D", m_widthBeforeDirty, m_bitWidth);
+    }
+    if (m_hasCounterColumn) {
+        drawHeaderText("Cnt", m_widthBeforeCounter, m_counterWidth);
+    }
+    drawHeaderText("Tag", m_widthBeforeTag, m_tagWidth);
+    for (int i = 0; i < m_cache.getBlocks(); i++) {
+        drawHeaderText("Block " + QString::number(i), m_widthBeforeBlocks + i * m_blockWidth, m_blockWidth);
+    }
 }
 
-QGraphicsSimpleTextItem* CacheGraphic::tryCreateGraphicsTextItem(QGraphicsSimpleTextItem** item, qreal x, qreal y) {
-    if (*item == nullptr) {
-        *item = new QGraphicsSimpleTextItem(this);
-        (*item)->setFont(m_font);
-        (*item)->setPos(x, y);
+void CacheGraphic::paintSetShading(QPainter* painter, int firstSet, int lastSet) const {
+    // Shade each set by its number of misses relative to the set with the most misses
+    const auto& setMisses = m_cache.getSetHeatMap().getMisses();
+    const unsigned maxMisses = m_cache.getSetHeatMap().getMaxMisses();
+    if (maxMisses == 0) {
+        return;
+    }
+
+    lastSet = std::min(lastSet, static_cast<int>(setMisses.size()) - 1);
+    for (int setIdx = firstSet; setIdx <= lastSet; setIdx++) {
+        if (setMisses[setIdx] == 0) {
+            continue;
+        }
+        QColor color(Qt::red);
+        color.setAlphaF(0.35 * setMisses[setIdx] / maxMisses);
+        painter->fillRect(setRect(setIdx), color);
     }
-    return *item;
 }
 
-std::unique_ptr<QGraphicsSimpleTextItem> CacheGraphic::createGraphicsTextItemSP(qreal x, qreal y) {
-    std::unique_ptr<QGraphicsSimpleTextItem> ptr = std::make_unique<QGraphicsSimpleTextItem>(this);
-    ptr->setFont(m_font);
-    ptr->setPos(x, y);
-    return ptr;
+void CacheGraphic::paintHighlighting(QPainter* painter) const {
+    if (!m_highlightActive) {
+        return;
+    }
+
+    QColor yellow(Qt::yellow);
+    yellow.setAlphaF(0.25);
+
+    // Cache set highlighting
+    painter->fillRect(setRect(m_highlightIndex.set), yellow);
+
+    // Cache block column highlighting
+    painter->fillRect(
+        QRectF(m_widthBeforeBlocks + m_highlightIndex.block * m_blockWidth, 0, m_blockWidth, m_cacheHeight), yellow);
+
+    // Currently accessed block
+    QColor hitColor = m_highlightIsHit ? QColor(Qt::green) : QColor(Qt::red);
+    hitColor.setAlphaF(m_highlightIsHit ? 0.4 : 0.8);
+    painter->fillRect(blockRect(m_highlightIndex.set, m_highlightIndex.way, m_highlightIndex.block), hitColor);
 }
 
-void CacheGraphic::cacheInvalidated() {
-    for (int setIdx = 0; setIdx < m_cache.getSets(); setIdx++) {
-        if (const auto* set = m_cache.getSet(setIdx)) {
-            for (const auto& way : *set) {
-                updateWay(setIdx, way.first);
+void CacheGraphic::paintSet(QPainter* painter, unsigned setIdx) {
+    const auto* cacheSet = m_cache.getSet(setIdx);
+
+    // Set index text
+    const QString indexText = QString::number(setIdx);
+    painter->drawText(QPointF(-m_fm.width(indexText) * 1.2,
+                              setIdx * m_setHeight + m_setHeight / 2 - m_wayHeight / 2 + m_fm.ascent()),
+                      indexText);
+
+    QColor dirtyColor(Qt::darkCyan);
+    dirtyColor.setAlphaF(0.4);
+    QColor unfilledColor(Qt::gray);
+    unfilledColor.setAlphaF(0.25);
+
+    for (int wayIdx = 0; wayIdx < m_cache.getWays(); wayIdx++) {
+        const qreal y = setIdx * m_setHeight + wayIdx * m_wayHeight;
+
+        // Dirty block and unfilled sector highlighting is drawn beneath the text
+        if (cacheSet) {
+            const auto it = cacheSet->find(wayIdx);
+            if (it != cacheSet->end()) {
+                for (const unsigned blockIdx : it->second.dirtyBlocks) {
+                    painter->fillRect(blockRect(setIdx, wayIdx, blockIdx), dirtyColor);
+                }
+                if (it->second.valid && m_cache.getSectors() > 1) {
+                    for (int blockIdx = 0; blockIdx < m_cache.getBlocks(); blockIdx++) {
+                        if ((it->second.validSectors >> (blockIdx / m_cache.getSectorBlocks()) & 1) == 0) {
+                            painter->fillRect(blockRect(setIdx, wayIdx, blockIdx), unfilledColor);
+                        }
+                    }
+                }
             }
-            updateSetReplFields(setIdx);
+        }
+
+        const WayGlyphs& glyphs = wayGlyphs(setIdx, wayIdx);
+        drawCentered(painter, glyphs.valid, 0, m_validWidth, y);
+        if (m_hasDirtyColumn) {
+            drawCentered(painter, glyphs.dirtyBit, m_widthBeforeDirty, m_bitWidth, y);
+        }
+        if (m_hasCounterColumn) {
+            drawCentered(painter, glyphs.counter, m_widthBeforeCounter, m_counterWidth, y);
+        }
+        drawCentered(painter, glyphs.tag, m_widthBeforeTag, m_tagWidth, y);
+        for (unsigned i = 0; i < glyphs.blocks.size(); i++) {
+            drawCentered(painter, glyphs.blocks[i], m_widthBeforeBlocks + i * m_blockWidth, m_blockWidth, y);
         }
     }
 }
 
-void CacheGraphic::wayInvalidated(unsigned setIdx, unsigned wayIdx) {
-    updateWay(setIdx, wayIdx);
-    updateSetReplFields(setIdx);
-}
+void CacheGraphic::paintGrid(QPainter* painter, int firstSet, int lastSet) const {
+    const qreal top = firstSet * m_setHeight;
+    const qreal bottom = (lastSet + 1) * m_setHeight;
 
-void CacheGraphic::dataChanged(const CacheSim::CacheTransaction* transaction) {
-    if (transaction != nullptr) {
-        if (this->m_cache.getCacheType() == CacheSim::CacheType::DataCache) {
-            std::cerr << "---------------------------------\n";
-            std::cerr << "graphpic transaction address: " << transaction->address << " setIdx: " << transaction->index.set << "\n";
+    // Column lines
+    std::vector<qreal> columns = {0, m_validWidth};
+    if (m_hasDirtyColumn) {
+        columns.push_back(m_widthBeforeDirty + m_bitWidth);
+    }
+    if (m_hasCounterColumn) {
+        columns.push_back(m_widthBeforeCounter + m_counterWidth);
+    }
+    columns.push_back(m_widthBeforeTag + m_tagWidth);
+    for (int i = 1; i <= m_cache.getBlocks(); i++) {
+        columns.push_back(m_widthBeforeBlocks + i * m_blockWidth);
+    }
+    for (const qreal x : columns) {
+        painter->drawLine(QLineF(x, top, x, bottom));
+    }
+
+    // Set and way rows
+    QPen wayPen = painter->pen();
+    wayPen.setStyle(Qt::DashLine);
+    const QPen setPen = painter->pen();
+    for (int setIdx = firstSet; setIdx <= lastSet + 1; setIdx++) {
+        const qreal y = setIdx * m_setHeight;
+        painter->setPen(setPen);
+        painter->drawLine(QLineF(0, y, m_cacheWidth, y));
+
+        if (setIdx <= lastSet) {
+            painter->setPen(wayPen);
+            for (int wayIdx = 1; wayIdx < m_cache.getWays(); wayIdx++) {
+                const qreal wayY = y + wayIdx * m_wayHeight;
+                painter->drawLine(QLineF(0, wayY, m_cacheWidth, wayY));
+            }
         }
-        wayInvalidated(transaction->index.set, transaction->index.way);
-        updateHighlighting(true, transaction);
+    }
+    painter->setPen(setPen);
+}
+
+bool CacheGraphic::addressAt(const QPointF& pos, uint64_t& address) const {
+    if (pos.x() < m_widthBeforeBlocks || pos.x() >= m_cacheWidth || pos.y() < 0 || pos.y() >= m_cacheHeight) {
+        return false;
+    }
+
+    const unsigned setIdx = pos.y() / m_setHeight;
+    const unsigned wayIdx = (pos.y() - setIdx * m_setHeight) / m_wayHeight;
+    const unsigned blockIdx = (pos.x() - m_widthBeforeBlocks) / m_blockWidth;
+
+    const auto* cacheSet = m_cache.getSet(setIdx);
+    if (cacheSet == nullptr) {
+        return false;
+    }
+    const auto it = cacheSet->find(wayIdx);
+    if (it == cacheSet->end() || !it->second.valid) {
+        return false;
+    }
+    address = m_cache.buildAddress(it->second.tag, setIdx, blockIdx);
+    return true;
+}
+
+void CacheGraphic::hoverMoveEvent(QGraphicsSceneHoverEvent* event) {
+    uint64_t address;
+    if (addressAt(event->pos(), address)) {
+        setToolTip("Address: " + encodeHex(address, m_cache.getAddressBits() / 8));
     } else {
-        updateHighlighting(false, nullptr);
+        setToolTip(QString());
     }
+    QGraphicsObject::hoverMoveEvent(event);
 }
 
-QGraphicsSimpleTextItem* CacheGraphic::drawText(const QString& text, qreal x, qreal y) {
-    auto* textItem = new QGraphicsSimpleTextItem(text, this);
-    textItem->setFont(m_font);
-    textItem->setPos(x, y);
-    return textItem;
+void CacheGraphic::cacheInvalidated() {
+    // All cached glyphs are stale; they are rebuilt for the ways which are on screen once repainted
+    m_glyphs.clear();
+    update();
 }
 
-void CacheGraphic::updateHighlighting(bool active, const CacheSim::CacheTransaction* transaction) {
-    m_highlightingItems.clear();
-
-    if (active) {
-        // Redraw highlighting rectangles indicating the current indexing
-
-        // Draw cache set highlighting rectangle
-        QPointF topLeft = QPointF(0, transaction->index.set * m_setHeight);
-        QPointF bottomRight = QPointF(m_cacheWidth, (transaction->index.set + 1) * m_setHeight);
-        m_highlightingItems.emplace_back(std::make_unique<QGraphicsRectItem>(QRectF(topLeft, bottomRight), this));
-        auto* setRectItem = m_highlightingItems.rbegin()->get();
-        setRectItem->setZValue(-2);
-        setRectItem->setOpacity(0.25);
-        setRectItem->setBrush(Qt::yellow);
-
-        // Draw cache block highlighting rectangle
-        topLeft = QPointF(transaction->index.block * m_blockWidth + m_widthBeforeBlocks, 0);
-        bottomRight = QPointF((transaction->index.block + 1) * m_blockWidth + m_widthBeforeBlocks, m_cacheHeight);
-        m_highlightingItems.emplace_back(std::make_unique<QGraphicsRectItem>(QRectF(topLeft, bottomRight), this));
-        auto* blockRectItem = m_highlightingItems.rbegin()->get();
-        blockRectItem->setZValue(-2);
-        blockRectItem->setOpacity(0.25);
-        blockRectItem->setBrush(Qt::yellow);
-
-        // Draw highlighting on the currently accessed block
-        topLeft = QPointF(transaction->index.block * m_blockWidth + m_widthBeforeBlocks,
-                          transaction->index.set * m_setHeight + transaction->index.way * m_wayHeight);
-        bottomRight = QPointF((transaction->index.block + 1) * m_blockWidth + m_widthBeforeBlocks,
-                              transaction->index.set * m_setHeight + (transaction->index.way + 1) * m_wayHeight);
-        m_highlightingItems.emplace_back(std::make_unique<QGraphicsRectItem>(QRectF(topLeft, bottomRight), this));
-        auto* hitRectItem = m_highlightingItems.rbegin()->get();
-        hitRectItem->setZValue(-1);
-        if (transaction->isHit) {
-            hitRectItem->setOpacity(0.4);
-            hitRectItem->setBrush(Qt::green);
-        } else {
-            hitRectItem->setOpacity(0.8);
-            hitRectItem->setBrush(Qt::red);
+void CacheGraphic::wayInvalidated(unsigned setIdx, unsigned wayIdx) {
+    // Replacement fields of all ways in the set may have changed
+    for (int i = 0; i < m_cache.getWays(); i++) {
+        const auto it = m_glyphs.find(setIdx * m_cache.getWays() + i);
+        if (it != m_glyphs.end()) {
+            it->second.dirty = true;
         }
     }
+
+    if (m_cache.getSetHeatMap().getMaxMisses() != m_heatMaxMisses) {
+        // The shading of all sets is relative to the maximum miss count; redraw everything
+        m_heatMaxMisses = m_cache.getSetHeatMap().getMaxMisses();
+        update();
+    } else {
+        update(setRect(setIdx));
+    }
 }
 
-void CacheGraphic::initializeControlBits() {
-    for (int setIdx = 0; setIdx < m_cache.getSets(); setIdx++) {
-        auto& set = m_cacheTextItems[setIdx];
-        auto* cacheSet = m_cache.getSet(setIdx);
-        for (int wayIdx = 0; wayIdx < m_cache.getWays(); wayIdx++) {
-            const qreal y = setIdx * m_setHeight + wayIdx * m_wayHeight;
-            qreal x;
-
-            // Create valid field
-            x = m_bitWidth / 2 - m_fm.width("0") / 2;
-            set[wayIdx].valid = drawText("0", x, y);
-
-            if (m_cache.getWritePolicy() == CacheSim::WritePolicy::WriteBack) {
-                // Create dirty bit field
-                x = m_widthBeforeDirty + m_bitWidth / 2 - m_fm.width("0") / 2;
-                set[wayIdx].dirty = drawText("0", x, y);
-            }
+void CacheGraphic::dataChanged(const CacheSim::CacheTransaction* transaction) {
+    if (m_highlightActive) {
+        // Clear the previous highlighting
+        update(setRect(m_highlightIndex.set));
+        update(QRectF(m_widthBeforeBlocks + m_highlightIndex.block * m_blockWidth, 0, m_blockWidth, m_cacheHeight));
+    }
 
-            if (m_cache.getReplacementPolicy() != CacheSim::ReplPolicy::Random && m_cache.getWays() > 1) {
-                // Create LRU field
-                const QString counterText = QString::number(m_cache.getWays() - 1);
-                x = m_widthBeforeCounter + m_counterWidth / 2 - m_fm.width(counterText) / 2;
-                set[wayIdx].counter = drawText(counterText, x, y);
-            }
-        }
+    if (transaction != nullptr) {
+        wayInvalidated(transaction->index.set, transaction->index.way);
+        m_highlightActive = true;
+        m_highlightIsHit = transaction->isHit;
+        m_highlightIndex = transaction->index;
+        update(setRect(m_highlightIndex.set));
+        update(QRectF(m_widthBeforeBlocks + m_highlightIndex.block * m_blockWidth, 0, m_blockWidth, m_cacheHeight));
+    } else {
+        m_highlightActive = false;
     }
 }
 
+void CacheGraphic::reset() {
+    m_highlightActive = false;
+    cacheInvalidated();
+}
+
 QRectF CacheGraphic::boundingRect() const {
-    // We do not paint anything in Cachegraphic; only instantiate other QGraphicsItem-derived objects. So just return
-    // the bounding rect of child items
-    return childrenBoundingRect();
+    return QRectF(-m_indexWidth, -m_fm.height(), m_indexWidth + m_cacheWidth, m_fm.height() + m_cacheHeight);
 }
 
 void CacheGraphic::cacheParametersChanged() {
-    // Remove all items
-    m_highlightingItems.clear();
-    m_cacheTextItems.clear();
-    for (const auto& item : childItems())
-        delete item;
+    prepareGeometryChange();
+    m_highlightActive = false;
+    m_heatMaxMisses = 0;
+    m_glyphs.clear();
 
     // Determine cell dimensions
     m_wayHeight = m_fm.height();
     m_setHeight = m_wayHeight * m_cache.getWays();
-    m_blockWidth = m_fm.width(" 0x00000000 ");
+    m_blockWidth = m_fm.width(" 0x" + QString(2 * m_cache.getWordBytes(), '0') + " ");
     m_bitWidth = m_fm.width("00");
+    // Sectored lines have a valid bit per sector
+    m_validWidth = m_cache.getSectors() > 1 ? m_fm.width(QString(m_cache.getSectors() + 1, '0')) : m_bitWidth;
     m_counterWidth = m_fm.width(QString::number(m_cache.getWays()) + "   ");
     m_cacheHeight = m_setHeight * m_cache.getSets();
-    m_tagWidth = m_blockWidth;
-
-    // Draw cache:
-    new QGraphicsLineItem(0, 0, 0, m_cacheHeight, this);
-
-    qreal width = 0;
-    // Draw valid bit column
-    new QGraphicsLineItem(m_bitWidth, 0, m_bitWidth, m_cacheHeight, this);
-    const QString validBitText = "V";
-    auto* validItem = drawText(validBitText, 0, -m_fm.height());
-    validItem->setToolTip("Valid bit");
-    width += m_bitWidth;
-
-    if (m_cache.getWritePolicy() == CacheSim::WritePolicy::WriteBack) {
-        m_widthBeforeDirty = width;
-
-        // Draw dirty bit column
-        new QGraphicsLineItem(width + m_bitWidth, 0, width + m_bitWidth, m_cacheHeight, this);
-        const QString dirtyBitText = "D";
-        auto* dirtyItem = drawText(dirtyBitText, m_widthBeforeDirty, -m_fm.height());
-        dirtyItem->setToolTip("Dirty bit");
+    m_tagWidth = m_fm.width(" 0x" + QString(m_cache.getAddressBits() / 4, '0') + " ");
+    m_indexWidth = std::max(m_fm.width("Index"), m_fm.width(QString::number(m_cache.getSets() - 1))) * 1.2;
+
+    // Determine column layout
+    qreal width = m_validWidth;  // Valid bit column
+
+    m_hasDirtyColumn = m_cache.getWritePolicy() == CacheSim::WritePolicy::WriteBack;
+    m_widthBeforeDirty = width;
+    if (m_hasDirtyColumn) {
         width += m_bitWidth;
     }
 
+    m_hasCounterColumn = m_cache.getReplacementPolicy() != CacheSim::ReplPolicy::Random && m_cache.getWays() > 1;
     m_widthBeforeCounter = width;
-
-    if (m_cache.getReplacementPolicy() != CacheSim::ReplPolicy::Random && m_cache.getWays() > 1) {
-        // Draw counter bit column
-        new QGraphicsLineItem(width + m_counterWidth, 0, width + m_counterWidth, m_cacheHeight, this);
-        const QString CounterBitText = "Cnt";
-        auto* textItem = drawText(CounterBitText, width + m_counterWidth / 2 - m_fm.width(CounterBitText) / 2, -m_fm.height());
-        textItem->setToolTip("Least Recently Used bits");
+    if (m_hasCounterColumn) {
         width += m_counterWidth;
     }
 
     m_widthBeforeTag = width;
-
-    // Draw tag column
-    new QGraphicsLineItem(m_tagWidth + width, 0, m_tagWidth + width, m_cacheHeight, this);
-    const QString tagText = "Tag";
-    drawText(tagText, width + m_tagWidth / 2 - m_fm.width(tagText) / 2, -m_fm.height());
     width += m_tagWidth;
 
     m_widthBeforeBlocks = width;
-
-    // Draw horizontal lines between cache blocks
-    for (int i = 0; i < m_cache.getBlocks(); i++) {
-        const QString blockText = "Block " + QString::number(i);
-        drawText(blockText, width + m_tagWidth / 2 - m_fm.width(blockText) / 2, -m_fm.height());
-        width += m_blockWidth;
-        new QGraphicsLineItem(width, 0, width, m_cacheHeight, this);
-    }
+    width += m_blockWidth * m_cache.getBlocks();
 
     m_cacheWidth = width;
 
-    // Draw cache line rows
-    for (int i = 0; i <= m_cache.getSets(); i++) {
-        qreal verticalAdvance = i * m_setHeight;
-        new QGraphicsLineItem(0, verticalAdvance, m_cacheWidth, verticalAdvance, this);
-
-        if (i < m_cache.getSets()) {
-            // Draw cache set rows
-            for (int j = 1; j < m_cache.getWays(); j++) {
-                verticalAdvance += m_wayHeight;
-                auto* setLine = new QGraphicsLineItem(0, verticalAdvance, m_cacheWidth, verticalAdvance, this);
-                auto pen = setLine->pen();
-                pen.setStyle(Qt::DashLine);
-                setLine->setPen(pen);
-            }
-        }
-    }
-
-    // Draw line index numbers
-    for (int i = 0; i < m_cache.getSets(); i++) {
-        const QString text = QString::number(i);
-
-        const qreal y = i * m_setHeight + m_setHeight / 2 - m_wayHeight / 2;
-        const qreal x = -m_fm.width(text) * 1.2;
-        drawText(text, x, y);
-    }
-
-    // Draw index column text
-    const QString indexText = "Index";
-    const qreal x = -m_fm.width(indexText) * 1.2;
-    drawText(indexText, x, -m_fm.height());
-
-    initializeControlBits();
+    update();
 }
 
 }  // namespace Ripes
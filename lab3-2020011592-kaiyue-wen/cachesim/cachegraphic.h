@@ -4,31 +4,45 @@
 #include <QFontMetrics>
 #include <QGraphicsItem>
 #include <QObject>
-#include <memory>
+#include <QStaticText>
+#include <unordered_map>
 #include "cachesim.h"
 
 namespace Ripes {
 
+/**
+ * @brief The CacheGraphic class
+ * Graphical representation of the cache simulator. The entire cache is drawn by this single item, which paints only
+ * the cache sets intersecting the exposed area directly from the state of the cache simulator. As such, the cost of
+ * rendering the cache is proportional to the number of cache ways on screen, and not the size of the cache.
+ */
 class CacheGraphic : public QGraphicsObject {
 public:
     CacheGraphic(CacheSim& cache);
 
     QRectF boundingRect() const override;
 
-    void paint(QPainter*, const QStyleOptionGraphicsItem*, QWidget* = nullptr) override {}
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* = nullptr) override;
+
+    /**
+     * @brief addressAt
+     * If the item-local position @p pos is within a valid cache block, @returns true and sets @p address to the
+     * address of the data in the block.
+     */
+    bool addressAt(const QPointF& pos, uint64_t& address) const;
 
 public slots:
     /**
      * @brief dataChanged
      * The cache simulator indicates that some entries in the cache has changed. CacheGraphic will, using @p
-     * transaction, lazily initialize and update all required values to reflect the new state of the cache.
+     * transaction, invalidate the affected way and update the highlighting of the current access.
      */
     void dataChanged(const CacheSim::CacheTransaction* transaction);
 
     /**
      * @brief wayInvalidated
-     * The cache simulator has signalled that all graphics in the given cache way shall be reinitialized to reflect a
-     * changed state in the cache simulator.
+     * The cache simulator has signalled that the given cache way shall be redrawn to reflect a changed state in the
+     * cache simulator.
      */
     void wayInvalidated(unsigned setIdx, unsigned wayIdx);
 
@@ -46,40 +60,44 @@ public slots:
 
     void reset();
 
+protected:
+    void hoverMoveEvent(QGraphicsSceneHoverEvent* event) override;
+
 private:
-    // Data structure modelling the cache; keeping graphics text items for each entry
-    // All text items which are not always present are stored as unqiue_ptr's to facilitate easy deletion when undoing
-    // changes to the cache
-    struct CacheWay {
-        std::map<unsigned, std::unique_ptr<QGraphicsSimpleTextItem>> blocks;
-        std::unique_ptr<QGraphicsSimpleTextItem> tag = nullptr;
-        QGraphicsSimpleTextItem* counter = nullptr;
-        QGraphicsSimpleTextItem* valid = nullptr;
-        QGraphicsSimpleTextItem* dirty = nullptr;
-        std::map<unsigned, std::unique_ptr<QGraphicsRectItem>> dirtyBlocks;
+    /**
+     * @brief The WayGlyphs struct
+     * Laid out text of a single cache way. Text layout is comparatively expensive, so the glyphs of a way are only
+     * rebuilt when the way has been invalidated.
+     */
+    struct WayGlyphs {
+        bool dirty = true;
+        QStaticText valid;
+        QStaticText dirtyBit;
+        QStaticText counter;
+        QStaticText tag;
+        std::vector<QStaticText> blocks;
     };
 
-    using CacheSet = std::map<unsigned, CacheWay>;
-
     /**
-     * @brief initializeControlBits
-     * Constructs all of the "Valid" and "Counter" text items within the cache
+     * @brief wayGlyphs
+     * @returns the (lazily rebuilt) glyphs for the way @p wayIdx of set @p setIdx.
      */
-    void initializeControlBits();
-    void updateHighlighting(bool active, const CacheSim::CacheTransaction* transaction);
-    QGraphicsSimpleTextItem* drawText(const QString& text, qreal x, qreal y);
-    QGraphicsSimpleTextItem* tryCreateGraphicsTextItem(QGraphicsSimpleTextItem** item, qreal x, qreal y);
-    std::unique_ptr<QGraphicsSimpleTextItem> createGraphicsTextItemSP(qreal x, qreal y);
+    const WayGlyphs& wayGlyphs(unsigned setIdx, unsigned wayIdx);
+    void rebuildWayGlyphs(WayGlyphs& glyphs, unsigned setIdx, unsigned wayIdx) const;
+
+    QRectF setRect(unsigned setIdx) const;
+    QRectF blockRect(unsigned setIdx, unsigned wayIdx, unsigned blockIdx) const;
+    void drawCentered(QPainter* painter, const QStaticText& text, qreal columnX, qreal columnWidth, qreal y) const;
 
-    // Graphical update functions
-    void updateSetReplFields(unsigned setIdx);
-    void updateWay(unsigned setIdx, unsigned wayIdx);
+    void paintHeader(QPainter* painter) const;
+    void paintSetShading(QPainter* painter, int firstSet, int lastSet) const;
+    void paintHighlighting(QPainter* painter) const;
+    void paintGrid(QPainter* painter, int firstSet, int lastSet) const;
+    void paintSet(QPainter* painter, unsigned setIdx);
 
     QFont m_font = QFont("Inconsolata", 12);
     CacheSim& m_cache;
 
-    std::vector<std::unique_ptr<QGraphicsRectItem>> m_highlightingItems;
-
     QFontMetricsF m_fm;
 
     // Drawing dimensions
@@ -87,25 +105,34 @@ private:
     qreal m_setHeight = 0;
     qreal m_blockWidth = 0;
     qreal m_bitWidth = 0;
+    qreal m_validWidth = 0;
     qreal m_cacheHeight = 0;
     qreal m_tagWidth = 0;
     qreal m_cacheWidth = 0;
+    qreal m_indexWidth = 0;
     qreal m_widthBeforeBlocks = 0;
     qreal m_widthBeforeTag = 0;
     qreal m_widthBeforeCounter = 0;
     qreal m_widthBeforeDirty = 0;
     qreal m_counterWidth = 0;
+    bool m_hasDirtyColumn = false;
+    bool m_hasCounterColumn = false;
+
+    // Maximum per-set miss count at the time of the last repaint of the set heat shading
+    unsigned m_heatMaxMisses = 0;
+
+    // Index of the most recent cache access, which is highlighted
+    bool m_highlightActive = false;
+    bool m_highlightIsHit = false;
+    CacheSim::CacheIndex m_highlightIndex;
 
     /**
-     * @brief m_cacheTextItems
-     * All text items in the cache are managed in @var m_cacheTextItems.
-     * This object models the hierarchy of the cache, and stores all currently initialized text items for the cache.
-     * The object is indexed similarly to how the cache simulator is indexed. As such, a cache transaction is used to
-     * traverse the object.
-     * All items are lazily initialized in calls to dataChanged(). This prevents initializing a ton of items if a user
-     * has created a very large cache.
+     * @brief m_glyphs
+     * Cached glyphs for the cache ways which have been painted, indexed by set index * ways + way index. Entries are
+     * only created for painted ways, and the cache is bounded in size; memory usage is thus proportional to what has
+     * been on screen rather than to the size of the cache.
      */
-    std::map<unsigned, CacheSet> m_cacheTextItems;
+    std::unordered_map<unsigned, WayGlyphs> m_glyphs;
 };
 
 }  // namespace Ripes
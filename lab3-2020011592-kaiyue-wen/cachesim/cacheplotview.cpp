@@ -17,6 +17,10 @@ void constrainInPlotRange(QPointF& pos, QChart* chart) {
 
     const QValueAxis* axisY = qobject_cast<QValueAxis*>(chart->axes(Qt::Vertical).first());
     const QValueAxis* axisX = qobject_cast<QValueAxis*>(chart->axes(Qt::Horizontal).first());
+    if (!axisX || !axisY) {
+        // Non-numeric axes (ie. histogram categories); nothing to constrain against
+        return;
+    }
     const QPointF chartBottomLeft = chart->mapToPosition({axisX->min(), axisY->min()});
     const QPointF chartTopRight = chart->mapToPosition({axisX->max(), axisY->max()});
 
@@ -3,17 +3,25 @@
 
 #include <QClipboard>
 #include <QFileDialog>
+#include <QMessageBox>
 #include <QToolBar>
 #include <QtCharts/QAreaSeries>
+#include <QtCharts/QBarCategoryAxis>
+#include <QtCharts/QBarSeries>
+#include <QtCharts/QBarSet>
 #include <QtCharts/QChartView>
+#include <QtCharts/QLegendMarker>
 #include <QtCharts/QLineSeries>
 #include <QtCharts/QValueAxis>
 
+#include "cache_stats_exporter.h"
 #include "enumcombobox.h"
 #include "processorhandler.h"
 
 #include "limits.h"
 
+#include <algorithm>
+
 namespace {
 
 /**
@@ -61,10 +69,85 @@ void finishSeries(QLineSeries& series, const unsigned max) {
 
 namespace Ripes {
 
+namespace {
+
+/// Minimum difference in miss rate between a window and the current phase for a phase change to be detected
+constexpr double s_phaseThreshold = 0.15;
+/// Upper bound on the number of phase markers drawn in a plot
+constexpr size_t s_maxPhaseMarkers = 100;
+/// Upper bound on the number of rows copied to the clipboard
+constexpr size_t s_maxClipboardRows = 100000;
+
+/**
+ * @brief cumulativeVariable
+ * @returns the cumulative variable from which the windowed variable @p variable is derived.
+ */
+CachePlotWidget::Variable cumulativeVariable(CachePlotWidget::Variable variable) {
+    switch (variable) {
+    case CachePlotWidget::Variable::WindowHits: return CachePlotWidget::Variable::Hits;
+    case CachePlotWidget::Variable::WindowMisses: return CachePlotWidget::Variable::Misses;
+    case CachePlotWidget::Variable::WindowWritebacks: return CachePlotWidget::Variable::Writebacks;
+    case CachePlotWidget::Variable::WindowAccesses: return CachePlotWidget::Variable::Accesses;
+    default: return variable;
+    }
+}
+
+/**
+ * @brief isAccessCount
+ * @returns true if @p variable counts a subset of the cache accesses. Ratios of such variables are fractions of the
+ * accesses and are plotted as percentages.
+ */
+bool isAccessCount(CachePlotWidget::Variable variable) {
+    return variable < CachePlotWidget::Variable::Latency;
+}
+
+double variableValue(CachePlotWidget::Variable variable, unsigned cycle, const CacheSim::CacheAccessTrace& entry) {
+    const unsigned accesses = entry.hits + entry.misses;
+    switch (variable) {
+    case CachePlotWidget::Variable::Writes: return entry.writes;
+    case CachePlotWidget::Variable::Reads: return entry.reads;
+    case CachePlotWidget::Variable::Hits: return entry.hits;
+    case CachePlotWidget::Variable::Misses: return entry.misses;
+    case CachePlotWidget::Variable::Writebacks: return entry.writebacks;
+    case CachePlotWidget::Variable::CompulsoryMisses: return entry.compulsoryMisses;
+    case CachePlotWidget::Variable::CapacityMisses: return entry.capacityMisses;
+    case CachePlotWidget::Variable::ConflictMisses: return entry.conflictMisses;
+    case CachePlotWidget::Variable::SectorMisses: return entry.sectorMisses;
+    case CachePlotWidget::Variable::FirstProbeHits: return entry.firstProbeHits;
+    case CachePlotWidget::Variable::Accesses: return accesses;
+    case CachePlotWidget::Variable::Latency: return entry.latency;
+    case CachePlotWidget::Variable::StallCycles: return entry.stallCycles;
+    case CachePlotWidget::Variable::AMAT: return accesses == 0 ? 0 : static_cast<double>(entry.latency) / accesses;
+    // Stall cycles per executed cycle; approximates the increase in CPI of a single-issue processor
+    case CachePlotWidget::Variable::CPIImpact: return static_cast<double>(entry.stallCycles) / (cycle + 1);
+    // Average number of occupied MSHRs per cycle, and the fraction of misses which merged into an occupied MSHR
+    case CachePlotWidget::Variable::MshrOccupancy: return static_cast<double>(entry.mshrBusyCycles) / (cycle + 1);
+    case CachePlotWidget::Variable::MshrMergeRate: {
+        const int misses = entry.mshrAllocations + entry.mshrMerges;
+        return misses == 0 ? 0 : static_cast<double>(entry.mshrMerges) / misses;
+    }
+    case CachePlotWidget::Variable::WriteBufferTransactions: return entry.writeBufferTransactions;
+    // Buffered writes per write issued to the next level
+    case CachePlotWidget::Variable::WriteBufferCoalescing:
+        return entry.writeBufferTransactions == 0
+                   ? 0
+                   : static_cast<double>(entry.writeBufferWrites) / entry.writeBufferTransactions;
+    case CachePlotWidget::Variable::WriteBufferStallCycles: return entry.writeBufferStallCycles;
+    case CachePlotWidget::Variable::WayReads: return entry.wayReads;
+    case CachePlotWidget::Variable::WayReadsSaved: return entry.wayReadsSaved;
+    case CachePlotWidget::Variable::FillBytes: return entry.fillBytes;
+    case CachePlotWidget::Variable::WritebackBytes: return entry.writebackBytes;
+    default: Q_ASSERT(false); return 0;
+    }
+}
+
+}  // namespace
+
 CachePlotWidget::CachePlotWidget(const CacheSim& sim, QWidget* parent)
     : QDialog(parent), m_ui(new Ui::CachePlotWidget), m_cache(sim) {
     m_ui->setupUi(this);
-    setWindowTitle("Cache Access Statistics");
+    setWindowTitle("Cache Access Statistics" +
+                   (sim.isSampling() ? QString(" (sampled: 1 in %1 sets)").arg(1 << sim.getSampleBits()) : QString()));
 
     m_toolbar = new QToolBar(this);
     m_ui->toolbarLayout->addWidget(m_toolbar);
@@ -73,6 +156,8 @@ CachePlotWidget::CachePlotWidget(const CacheSim& sim, QWidget* parent)
     setupEnumCombobox(m_ui->num, s_cacheVariableStrings);
     setupEnumCombobox(m_ui->den, s_cacheVariableStrings);
     setupEnumCombobox(m_ui->plotType, s_cachePlotTypeStrings);
+    setupEnumCombobox(m_ui->windowMode, s_windowModeStrings);
+    setupEnumCombobox(m_ui->windowUnit, s_windowUnitStrings);
 
     setupStackedVariablesList();
 
@@ -83,10 +168,16 @@ CachePlotWidget::CachePlotWidget(const CacheSim& sim, QWidget* parent)
     connect(m_ui->num, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &CachePlotWidget::variablesChanged);
     connect(m_ui->den, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &CachePlotWidget::variablesChanged);
     connect(m_ui->stackedVariables, &QListWidget::itemChanged, this, &CachePlotWidget::variablesChanged);
+    connect(m_ui->windowMode, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+            &CachePlotWidget::variablesChanged);
+    connect(m_ui->windowUnit, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+            &CachePlotWidget::variablesChanged);
+    connect(m_ui->windowSize, QOverload<int>::of(&QSpinBox::valueChanged), this, &CachePlotWidget::variablesChanged);
+    connect(m_ui->phaseMarkers, &QCheckBox::toggled, this, &CachePlotWidget::variablesChanged);
 
     const auto& accessTrace = m_cache.getAccessTrace();
     m_ui->rangeMin->setValue(0);
-    m_ui->rangeMax->setValue(ProcessorHandler::get()->getProcessor()->getCycleCount());
+    m_ui->rangeMax->setValue(lastCycle());
 
     connect(m_ui->rangeMin, QOverload<int>::of(&QSpinBox::valueChanged), this, &CachePlotWidget::rangeChanged);
     connect(m_ui->rangeMax, QOverload<int>::of(&QSpinBox::valueChanged), this, &CachePlotWidget::rangeChanged);
@@ -135,6 +226,11 @@ void CachePlotWidget::setupToolbar() {
     m_savePlotAction->setIcon(saveIcon);
     m_toolbar->addAction(m_savePlotAction);
     connect(m_savePlotAction, &QAction::triggered, this, &CachePlotWidget::savePlot);
+
+    m_exportAction = new QAction("Export statistics to file", this);
+    m_exportAction->setIcon(saveIcon);
+    m_toolbar->addAction(m_exportAction);
+    connect(m_exportAction, &QAction::triggered, this, &CachePlotWidget::exportStatistics);
 }
 
 void CachePlotWidget::plotTypeChanged() {
@@ -144,6 +240,8 @@ void CachePlotWidget::plotTypeChanged() {
         m_ui->configWidget->setCurrentWidget(m_ui->ratioConfigPage);
     } else if (m_plotType == PlotType::Stacked) {
         m_ui->configWidget->setCurrentWidget(m_ui->stackedConfigPage);
+    } else if (m_plotType == PlotType::ReuseDistance) {
+        m_ui->configWidget->setCurrentWidget(m_ui->histogramConfigPage);
     } else {
         Q_ASSERT(false);
     }
@@ -159,49 +257,52 @@ void CachePlotWidget::savePlot() {
     }
 }
 
-void CachePlotWidget::copyPlotDataToClipboard() const {
-    std::vector<Variable> allVariables;
-    for (int i = 0; i < N_Variables; i++) {
-        allVariables.push_back(static_cast<Variable>(i));
-    }
-    const auto& allData = gatherData(allVariables);
-
-    std::map<unsigned /*cycle*/, QStringList> dataStrings;
-    QStringList header;
-
-    // Write cycles
-    header << "cycle";
-    for (const auto& dataPoint : allData.begin()->second) {
-        dataStrings[dataPoint.x()] << QString::number(dataPoint.x());
+void CachePlotWidget::exportStatistics() {
+    const QString csvFilter = "CSV (*.csv)";
+    const QString binaryFilter = "Binary columnar (*.rcst)";
+    QString selectedFilter;
+    const QString filename = QFileDialog::getSaveFileName(this, "Export statistics", "",
+                                                          csvFilter + ";;" + binaryFilter, &selectedFilter);
+    if (filename.isEmpty()) {
+        return;
     }
 
-    // Write variables
-    for (const auto& variableData : allData) {
-        header << s_cacheVariableStrings.at(variableData.first);
-        for (const auto& dataPoint : variableData.second) {
-            dataStrings[dataPoint.x()] << QString::number(dataPoint.y());
-        }
+    // The moving window of the export follows the window size of the plot
+    CacheStatsExporter exporter(
+        selectedFilter == binaryFilter ? CacheStatsExporter::Format::Binary : CacheStatsExporter::Format::CSV,
+        m_ui->windowSize->value());
+    exporter.setSampleBits(m_cache.getSampleBits());
+    if (!exporter.write(m_cache.getAccessTrace(), filename.toStdString())) {
+        QMessageBox::warning(this, "Export statistics", QString::fromStdString(exporter.errorString()));
     }
+}
 
-    // Assemble string
-    QString outString;
-    outString += header.join('\t') + '\n';
-
-    for (const auto& dataString : dataStrings) {
-        outString += dataString.second.join('\t') + '\n';
+void CachePlotWidget::copyPlotDataToClipboard() {
+    // The statistics of the plotted range are copied in the format of the exporter. The clipboard is bounded; longer
+    // ranges are to be exported to a file.
+    CacheStatsExporter exporter(CacheStatsExporter::Format::CSV, m_ui->windowSize->value());
+    std::string text;
+    const bool complete = exporter.writeText(m_cache.getAccessTrace(), m_ui->rangeMin->value(), m_ui->rangeMax->value(),
+                                             s_maxClipboardRows, '\t', text);
+    QApplication::clipboard()->setText(QString::fromStdString(text));
+    if (!complete) {
+        QMessageBox::information(this, "Copy data to clipboard",
+                                 QString("Only the first %1 rows of the plotted range were copied. Use \"Export "
+                                         "statistics to file\" to save the entire timeline.")
+                                     .arg(s_maxClipboardRows));
     }
-
-    QApplication::clipboard()->setText(outString);
 }
 
 void CachePlotWidget::rangeChanged() {
-    if (m_currentPlot) {
+    if (m_currentPlot && m_plotType != PlotType::ReuseDistance) {
         m_currentPlot->axes(Qt::Horizontal).first()->setRange(m_ui->rangeMin->value(), m_ui->rangeMax->value());
+        // Resample the plotted lines at the resolution of the new range
+        updateLevelOfDetail();
     }
 
     // Update allowed ranges
     const auto& accessTrace = m_cache.getAccessTrace();
-    const unsigned cycles = ProcessorHandler::get()->getProcessor()->getCycleCount();
+    const unsigned cycles = lastCycle();
     m_ui->rangeMin->setMinimum(0);
     m_ui->rangeMin->setMaximum(m_ui->rangeMax->value());
     m_ui->rangeMax->setMinimum(m_ui->rangeMin->value());
@@ -221,6 +322,8 @@ std::vector<CachePlotWidget::Variable> CachePlotWidget::gatherVariables() const
                 variables.push_back(qvariant_cast<Variable>(item->data(Qt::UserRole)));
             }
         }
+    } else if (m_plotType == PlotType::ReuseDistance) {
+        // The reuse distance histogram is not based on access trace variables
     } else {
         Q_ASSERT(false);
     }
@@ -228,68 +331,138 @@ std::vector<CachePlotWidget::Variable> CachePlotWidget::gatherVariables() const
 }
 
 void CachePlotWidget::variablesChanged() {
+    // The cursor line is owned by the current plot, which is replaced
+    m_cycleCursorLine = nullptr;
+    updateWindowedMetrics();
     const auto vars = gatherVariables();
     if (m_plotType == PlotType::Ratio) {
         Q_ASSERT(vars.size() == 2);
         setPlot(createRatioPlot(vars[0], vars[1]));
     } else if (m_plotType == PlotType::Stacked) {
         setPlot(createStackedPlot(vars));
+    } else if (m_plotType == PlotType::ReuseDistance) {
+        m_lodLines.clear();
+        setPlot(createReuseDistancePlot());
     } else {
         Q_ASSERT(false);
     }
 }
 
-std::map<CachePlotWidget::Variable, QList<QPoint>>
-CachePlotWidget::gatherData(const std::vector<Variable>& types) const {
+void CachePlotWidget::gatherSeries(Variable variable, std::vector<double>& x, std::vector<double>& y) const {
     const auto& trace = m_cache.getAccessTrace();
+    const Variable cumulative = cumulativeVariable(variable);
+    x.resize(trace.size());
+    y.resize(trace.size());
+    for (size_t i = 0; i < trace.size(); i++) {
+        x[i] = trace[i].first;
+        y[i] = variableValue(cumulative, trace[i].first, trace[i].second);
+    }
 
-    std::map<Variable, QList<QPoint>> data;
-
-    // Transform variable vector to set (avoid duplicates)
-    std::set<Variable> varSet;
-    for (const auto& type : types) {
-        varSet.insert(type);
+    if (cumulative != variable) {
+        std::vector<double> windowed;
+        m_windowedMetrics.apply(y, windowed);
+        y.swap(windowed);
     }
+}
 
-    for (const auto& type : types) {
-        // Initialize all data types
-        data[type];
+void CachePlotWidget::updateWindowedMetrics() {
+    WindowConfig config;
+    config.mode = getEnumValue<WindowConfig::Mode>(m_ui->windowMode);
+    config.unit = getEnumValue<WindowConfig::Unit>(m_ui->windowUnit);
+    config.size = m_ui->windowSize->value();
+
+    std::vector<double> cycles, accesses;
+    gatherSeries(Variable::Accesses, cycles, accesses);
+    m_windowedMetrics.setTimeline(cycles, accesses, config);
+}
+
+void CachePlotWidget::addPhaseMarkers(QChart* chart, double maxY) const {
+    if (!m_ui->phaseMarkers->isChecked()) {
+        return;
     }
 
-    // Gather data
-    for (const auto& entry : trace) {
-        if (varSet.count(Variable::Writes)) {
-            data[Variable::Writes].append(QPoint(entry.first, entry.second.writes));
-        }
-        if (varSet.count(Variable::Reads)) {
-            data[Variable::Reads].append(QPoint(entry.first, entry.second.reads));
-        }
-        if (varSet.count(Variable::Hits)) {
-            data[Variable::Hits].append(QPoint(entry.first, entry.second.hits));
-        }
-        if (varSet.count(Variable::Misses)) {
-            data[Variable::Misses].append(QPoint(entry.first, entry.second.misses));
-        }
-        if (varSet.count(Variable::Writebacks)) {
-            data[Variable::Writebacks].append(QPoint(entry.first, entry.second.writebacks));
-        }
-        if (varSet.count(Variable::Accesses)) {
-            data[Variable::Accesses].append(QPoint(entry.first, entry.second.hits + entry.second.misses));
+    std::vector<double> x, misses, accesses;
+    gatherSeries(Variable::Misses, x, misses);
+    gatherSeries(Variable::Accesses, x, accesses);
+    const auto boundaries = m_windowedMetrics.detectPhases(misses, accesses, s_phaseThreshold);
+
+    QPen pen(Qt::darkGray);
+    pen.setStyle(Qt::DashLine);
+    for (size_t i = 0; i < std::min(boundaries.size(), s_maxPhaseMarkers); i++) {
+        auto* marker = new QLineSeries(chart);
+        marker->append(x[boundaries[i]], 0);
+        marker->append(x[boundaries[i]], maxY);
+        marker->setPen(pen);
+        chart->addSeries(marker);
+        for (auto* legendMarker : chart->legend()->markers(marker)) {
+            legendMarker->setVisible(false);
         }
     }
+}
+
+void CachePlotWidget::addCycleCursor(QChart* chart, double maxY) {
+    m_cycleCursorHeight = maxY;
+    if (!m_hasCycleCursor) {
+        return;
+    }
 
-    return data;
+    m_cycleCursorLine = new QLineSeries(chart);
+    m_cycleCursorLine->append(m_cycleCursor, 0);
+    m_cycleCursorLine->append(m_cycleCursor, maxY);
+    QPen pen(Qt::red);
+    pen.setWidth(2);
+    m_cycleCursorLine->setPen(pen);
+    chart->addSeries(m_cycleCursorLine);
+    for (auto* legendMarker : chart->legend()->markers(m_cycleCursorLine)) {
+        legendMarker->setVisible(false);
+    }
 }
 
-QChart* CachePlotWidget::createRatioPlot(const Variable num, const Variable den) const {
-    const auto data = gatherData({num, den});
+void CachePlotWidget::setCycleCursor(unsigned cycle) {
+    m_cycleCursor = cycle;
+    if (!m_hasCycleCursor) {
+        // The current plot was created without a cursor
+        m_hasCycleCursor = true;
+        variablesChanged();
+    } else if (m_cycleCursorLine != nullptr) {
+        m_cycleCursorLine->replace(QList<QPointF>{QPointF(cycle, 0), QPointF(cycle, m_cycleCursorHeight)});
+    }
+}
 
-    const QList<QPoint>& numerator = data.at(num);
-    const QList<QPoint>& denominator = data.at(den);
+unsigned CachePlotWidget::lastCycle() const {
+    const auto& trace = m_cache.getAccessTrace();
+    const unsigned cycles = ProcessorHandler::get()->getProcessor()->getCycleCount();
+    return trace.empty() ? cycles : std::max(cycles, trace.back().first);
+}
 
-    Q_ASSERT(numerator.size() == denominator.size());
+void CachePlotWidget::addLevelOfDetailLine(QLineSeries* series, std::vector<double> x, std::vector<double> y) {
+    m_lodLines.emplace_back(series, SeriesPyramid());
+    m_lodLines.back().second.build(std::move(x), std::move(y));
+}
+
+void CachePlotWidget::updateLevelOfDetail() {
+    const unsigned maxX = lastCycle();
+    // Each bucket contributes at most two points; sample the lines at roughly the pixel resolution of the plot
+    const unsigned buckets = std::max(m_ui->plotView->width() / 2, 128);
+
+    std::vector<uint32_t> indices;
+    for (auto& [series, pyramid] : m_lodLines) {
+        pyramid.query(m_ui->rangeMin->value(), m_ui->rangeMax->value(), buckets, indices);
+        QVector<QPointF> points;
+        points.reserve(indices.size());
+        for (const uint32_t idx : indices) {
+            points << QPointF(pyramid.x(idx), pyramid.y(idx));
+        }
+        series->replace(points);
+        stepifySeries(*series);
+        finishSeries(*series, maxX);
+    }
+}
 
-    const unsigned points = numerator.size();
+QChart* CachePlotWidget::createRatioPlot(const Variable num, const Variable den) {
+    std::vector<double> x, numerator, denominator;
+    gatherSeries(num, x, numerator);
+    gatherSeries(den, x, denominator);
 
     QChart* chart = new QChart();
     chart->setTitle(s_cacheVariableStrings.at(num) + "/" + s_cacheVariableStrings.at(den));
@@ -297,26 +470,26 @@ QChart* CachePlotWidget::createRatioPlot(const Variable num, const Variable den)
     font.setPointSize(16);
     chart->setTitleFont(font);
 
-    QLineSeries* series = new QLineSeries(chart);
+    // Only ratios between counts of accesses are percentages; e.g. latency / accesses is a number of cycles
+    const bool isPercentage = isAccessCount(num) && isAccessCount(den);
+    std::vector<double> ratios(x.size(), 0);
     double maxY = 0;
-    for (int i = 0; i < points; i++) {
-        const auto& p1 = numerator[i];
-        const auto& p2 = denominator[i];
-        Q_ASSERT(p1.x() == p2.x() && "Data inconsistency");
-        double ratio = 0;
-        if (p2.y() != 0) {
-            ratio = static_cast<double>(p1.y()) / p2.y();
-            ratio *= 100;
+    for (size_t i = 0; i < x.size(); i++) {
+        if (denominator[i] != 0) {
+            ratios[i] = numerator[i] / denominator[i] * (isPercentage ? 100 : 1);
         }
-        series->append(p1.x(), ratio);
-        maxY = ratio > maxY ? ratio : maxY;
+        maxY = ratios[i] > maxY ? ratios[i] : maxY;
     }
-    const unsigned maxX = ProcessorHandler::get()->getProcessor()->getCycleCount();
+    const unsigned maxX = lastCycle();
 
-    stepifySeries(*series);
-    finishSeries(*series, maxX);
+    QLineSeries* series = new QLineSeries(chart);
+    m_lodLines.clear();
+    addLevelOfDetailLine(series, std::move(x), std::move(ratios));
+    updateLevelOfDetail();
 
     chart->addSeries(series);
+    addPhaseMarkers(chart, maxY * 1.1);
+    addCycleCursor(chart, maxY * 1.1);
 
     chart->createDefaultAxes();
     chart->axes(Qt::Horizontal).first()->setRange(0, maxX);
@@ -328,8 +501,8 @@ QChart* CachePlotWidget::createRatioPlot(const Variable num, const Variable den)
     QValueAxis* axisY = qobject_cast<QValueAxis*>(chart->axes(Qt::Vertical).first());
     QValueAxis* axisX = qobject_cast<QValueAxis*>(chart->axes(Qt::Horizontal).first());
     Q_ASSERT(axisY);
-    axisY->setLabelFormat("%.1f  ");
-    axisY->setTitleText("%");
+    axisY->setLabelFormat(isPercentage ? "%.1f  " : "%.3g  ");
+    axisY->setTitleText(isPercentage ? "%" : "");
 
     axisX->setLabelFormat("%d  ");
     axisX->setTitleText("Cycle");
@@ -339,16 +512,14 @@ QChart* CachePlotWidget::createRatioPlot(const Variable num, const Variable den)
     return chart;
 }
 
-QChart* CachePlotWidget::createStackedPlot(const std::vector<Variable>& variables) const {
+QChart* CachePlotWidget::createStackedPlot(const std::vector<Variable>& variables) {
+    m_lodLines.clear();
     if (variables.size() == 0) {
         return nullptr;
     }
 
-    const auto data = gatherData(variables);
-    const unsigned len = data.at(*variables.begin()).size();
-    for (const auto& iter : data) {
-        Q_ASSERT(len == iter.second.size());
-    }
+    // Transform variable vector to set (avoid duplicates)
+    const std::set<Variable> varSet(variables.begin(), variables.end());
 
     QChart* chart = new QChart();
     chart->setTitle("Access type count");
@@ -356,43 +527,33 @@ QChart* CachePlotWidget::createStackedPlot(const std::vector<Variable>& variable
     font.setPointSize(16);
     chart->setTitleFont(font);
 
-    // The lower series initialized to zero values
-
     // We create a stacked chart by repeatedly creating line series with y values equal to the variable set's y value +
     // the preceding linesets envelope values.
     std::vector<std::pair<Variable, QLineSeries*>> lineSeries;
     QLineSeries* lowerSeries = nullptr;
     QLineSeries* upperSeries = nullptr;
-    const unsigned maxX = ProcessorHandler::get()->getProcessor()->getCycleCount();
-    unsigned maxY = 0;
-    for (const auto& variableData : data) {
-        upperSeries = new QLineSeries(chart);
-        for (unsigned i = 0; i < len; i++) {
-            const auto& dataPoint = variableData.second.at(i);
-            unsigned x = dataPoint.x();
-            unsigned y = dataPoint.y();
-            if (lowerSeries) {
-                // Stack on top of the preceding line
-                const auto& lowerPoints = lowerSeries->pointsVector();
-                y = lowerPoints[i].y() + dataPoint.y();
+    const unsigned maxX = lastCycle();
+    double maxY = 0;
+    std::vector<double> x, y, envelope;
+    for (const auto& variable : varSet) {
+        gatherSeries(variable, x, y);
+        if (envelope.empty()) {
+            envelope = y;
+        } else {
+            // Stack on top of the preceding line
+            for (size_t i = 0; i < y.size(); i++) {
+                envelope[i] += y[i];
             }
-            maxY = y > maxY ? y : maxY;
-            upperSeries->append(QPoint(x, y));
         }
-        lineSeries.push_back({variableData.first, upperSeries});
-        lowerSeries = upperSeries;
-    }
-
-    // Stepify created lineseries
-    std::map<Variable, QVector<QPointF>> debug;
-    for (const auto& line : lineSeries) {
-        debug[line.first] = line.second->pointsVector();
+        upperSeries = new QLineSeries(chart);
+        addLevelOfDetailLine(upperSeries, x, envelope);
+        lineSeries.push_back({variable, upperSeries});
     }
-    for (const auto& line : lineSeries) {
-        stepifySeries(*line.second);
-        finishSeries(*line.second, maxX);
-        debug[line.first] = line.second->pointsVector();
+    // All variables are non-negative, so the top-most line bounds the plot
+    for (const double value : envelope) {
+        maxY = value > maxY ? value : maxY;
     }
+    updateLevelOfDetail();
 
     // Create area series
     lowerSeries = nullptr;
@@ -403,6 +564,8 @@ QChart* CachePlotWidget::createStackedPlot(const std::vector<Variable>& variable
         chart->addSeries(area);
         lowerSeries = upperSeries;
     }
+    addPhaseMarkers(chart, maxY);
+    addCycleCursor(chart, maxY);
 
     chart->createDefaultAxes();
 
@@ -410,7 +573,7 @@ QChart* CachePlotWidget::createStackedPlot(const std::vector<Variable>& variable
     QValueAxis* axisY = qobject_cast<QValueAxis*>(chart->axes(Qt::Vertical).first());
     QValueAxis* axisX = qobject_cast<QValueAxis*>(chart->axes(Qt::Horizontal).first());
     axisX->setRange(0, maxX);
-    axisY->setRange(0, axisY->max());
+    axisY->setRange(0, maxY);
 
     Q_ASSERT(axisY);
     axisY->setTitleText("#");
@@ -420,6 +583,52 @@ QChart* CachePlotWidget::createStackedPlot(const std::vector<Variable>& variable
     return chart;
 }
 
+QChart* CachePlotWidget::createReuseDistancePlot() const {
+    const auto& histogram = m_cache.getReuseHistogram();
+    const auto& buckets = histogram.getBuckets();
+
+    // Only plot up until the largest non-empty bucket
+    int lastBucket = buckets.size() - 1;
+    while (lastBucket >= 0 && buckets[lastBucket] == 0) {
+        lastBucket--;
+    }
+
+    QChart* chart = new QChart();
+    chart->setTitle("Reuse distance");
+    QFont font;
+    font.setPointSize(16);
+    chart->setTitleFont(font);
+
+    auto* set = new QBarSet("Accesses");
+    QStringList categories;
+    *set << histogram.getColdAccesses();
+    categories << "Cold";
+    for (int i = 0; i <= lastBucket; i++) {
+        *set << buckets[i];
+        categories << (i == 0 ? QString("1") : QString("%1-%2").arg(1u << i).arg((2u << i) - 1));
+    }
+
+    auto* series = new QBarSeries(chart);
+    series->append(set);
+    chart->addSeries(series);
+
+    auto* axisX = new QBarCategoryAxis(chart);
+    axisX->append(categories);
+    axisX->setTitleText("Reuse distance (accesses)");
+    chart->addAxis(axisX, Qt::AlignBottom);
+    series->attachAxis(axisX);
+
+    auto* axisY = new QValueAxis(chart);
+    axisY->setLabelFormat("%d  ");
+    axisY->setTitleText("#");
+    chart->addAxis(axisY, Qt::AlignLeft);
+    series->attachAxis(axisY);
+
+    chart->legend()->hide();
+
+    return chart;
+}
+
 void CachePlotWidget::setPlot(QChart* plot) {
     if (plot == nullptr)
         return;
@@ -4,6 +4,8 @@
 #include <QMetaType>
 #include <QtCharts/QChartGlobal>
 
+#include "cache_plot_lod.h"
+#include "cache_windowed_metrics.h"
 #include "cachesim.h"
 
 QT_FORWARD_DECLARE_CLASS(QToolBar);
@@ -12,6 +14,7 @@ QT_FORWARD_DECLARE_CLASS(QAction);
 QT_CHARTS_BEGIN_NAMESPACE
 class QChartView;
 class QChart;
+class QLineSeries;
 QT_CHARTS_END_NAMESPACE
 
 QT_CHARTS_USE_NAMESPACE
@@ -26,12 +29,51 @@ class CachePlotWidget : public QDialog {
     Q_OBJECT
 
 public:
-    enum Variable { Writes = 0, Reads, Hits, Misses, Writebacks, Accesses, N_Variables };
-    enum class PlotType { Ratio, Stacked };
+    enum Variable {
+        Writes = 0,
+        Reads,
+        Hits,
+        Misses,
+        Writebacks,
+        CompulsoryMisses,
+        CapacityMisses,
+        ConflictMisses,
+        SectorMisses,
+        FirstProbeHits,
+        Accesses,
+        // Windowed variants of the cumulative variables, computed over the configured window
+        WindowHits,
+        WindowMisses,
+        WindowWritebacks,
+        WindowAccesses,
+        // Timing variables; these are not counts of accesses
+        Latency,
+        StallCycles,
+        AMAT,
+        CPIImpact,
+        MshrOccupancy,
+        MshrMergeRate,
+        WriteBufferTransactions,
+        WriteBufferCoalescing,
+        WriteBufferStallCycles,
+        // Way prediction; ways read by lookups, and ways not read compared to parallel lookups
+        WayReads,
+        WayReadsSaved,
+        // Traffic to and from the next level, in bytes
+        FillBytes,
+        WritebackBytes,
+        N_Variables
+    };
+    enum class PlotType { Ratio, Stacked, ReuseDistance };
     explicit CachePlotWidget(const CacheSim& sim, QWidget* parent = nullptr);
     ~CachePlotWidget();
 
 public slots:
+    /**
+     * @brief setCycleCursor
+     * Marks @p cycle with a vertical line in the plots of the access trace, e.g. the current position of a replay.
+     */
+    void setCycleCursor(unsigned cycle);
 
 private slots:
     void variablesChanged();
@@ -40,29 +82,74 @@ private slots:
 
 private:
     /**
-     * @brief gatherData
-     * @returns a list of QPoints containing plotable data gathered from the cache simulator, as per the specified
+     * @brief gatherSeries
+     * Sets @p x to the cycles of the access trace, and @p y to the values of @p variable at each of these cycles.
+     */
+    void gatherSeries(Variable variable, std::vector<double>& x, std::vector<double>& y) const;
+
+    /**
+     * @brief updateWindowedMetrics
+     * Locates the windows of the access trace, as per the window configuration of the widget.
+     */
+    void updateWindowedMetrics();
+
+    /**
+     * @brief addPhaseMarkers
+     * If enabled, adds vertical markers of height @p maxY to @p chart at each detected program phase change.
+     */
+    void addPhaseMarkers(QChart* chart, double maxY) const;
+    void addCycleCursor(QChart* chart, double maxY);
+
+    /**
+     * @brief lastCycle
+     * @returns the last cycle to plot; the current cycle of the processor, or the last cycle of the access trace if the
+     * cache was accessed outside of the processor.
      */
-    std::map<Variable, QList<QPoint>> gatherData(const std::vector<Variable>& variables) const;
+    unsigned lastCycle() const;
+
+    /**
+     * @brief addLevelOfDetailLine
+     * Registers @p series to display the (x, y) series at the resolution of the plot view. The points of @p series are
+     * resampled from the series pyramid whenever the plotted range changes.
+     */
+    void addLevelOfDetailLine(QLineSeries* series, std::vector<double> x, std::vector<double> y);
+    void updateLevelOfDetail();
+
     void setupToolbar();
     void setupStackedVariablesList();
     void setPlot(QChart* plot);
-    void copyPlotDataToClipboard() const;
+    void copyPlotDataToClipboard();
+    void exportStatistics();
     void savePlot();
     std::vector<CachePlotWidget::Variable> gatherVariables() const;
 
-    QChart* createRatioPlot(const Variable num, const Variable den) const;
-    QChart* createStackedPlot(const std::vector<Variable>& variables) const;
+    QChart* createRatioPlot(const Variable num, const Variable den);
+    QChart* createStackedPlot(const std::vector<Variable>& variables);
+    QChart* createReuseDistancePlot() const;
 
     PlotType m_plotType = PlotType::Ratio;
     QChart* m_currentPlot = nullptr;
 
+    /**
+     * @brief m_lodLines
+     * Line series of the current plot, alongside the pyramids from which their points are sampled.
+     */
+    std::vector<std::pair<QLineSeries*, SeriesPyramid>> m_lodLines;
+
+    WindowedMetrics m_windowedMetrics;
+
+    bool m_hasCycleCursor = false;
+    unsigned m_cycleCursor = 0;
+    double m_cycleCursorHeight = 0;
+    QLineSeries* m_cycleCursorLine = nullptr;  // Of the current plot; nullptr if the plot has no cursor
+
     Ui::CachePlotWidget* m_ui;
     const CacheSim& m_cache;
 
     QToolBar* m_toolbar = nullptr;
     QAction* m_copyDataAction = nullptr;
     QAction* m_savePlotAction = nullptr;
+    QAction* m_exportAction = nullptr;
     QAction* m_crosshairAction = nullptr;
 };
 
@@ -72,13 +159,46 @@ const static std::map<CachePlotWidget::Variable, QString> s_cacheVariableStrings
     {CachePlotWidget::Variable::Hits, "Hits"},
     {CachePlotWidget::Variable::Misses, "Misses"},
     {CachePlotWidget::Variable::Writebacks, "Writebacks"},
-    {CachePlotWidget::Variable::Accesses, "Total accesses"}};
+    {CachePlotWidget::Variable::CompulsoryMisses, "Compulsory misses"},
+    {CachePlotWidget::Variable::CapacityMisses, "Capacity misses"},
+    {CachePlotWidget::Variable::ConflictMisses, "Conflict misses"},
+    {CachePlotWidget::Variable::SectorMisses, "Sector misses"},
+    {CachePlotWidget::Variable::FirstProbeHits, "First probe hits"},
+    {CachePlotWidget::Variable::Accesses, "Total accesses"},
+    {CachePlotWidget::Variable::WindowHits, "Hits (window)"},
+    {CachePlotWidget::Variable::WindowMisses, "Misses (window)"},
+    {CachePlotWidget::Variable::WindowWritebacks, "Writebacks (window)"},
+    {CachePlotWidget::Variable::WindowAccesses, "Accesses (window)"},
+    {CachePlotWidget::Variable::Latency, "Access latency (cycles)"},
+    {CachePlotWidget::Variable::StallCycles, "Stall cycles"},
+    {CachePlotWidget::Variable::AMAT, "AMAT (cycles)"},
+    {CachePlotWidget::Variable::CPIImpact, "CPI impact"},
+    {CachePlotWidget::Variable::MshrOccupancy, "MSHR occupancy"},
+    {CachePlotWidget::Variable::MshrMergeRate, "MSHR merge rate"},
+    {CachePlotWidget::Variable::WriteBufferTransactions, "Write buffer transactions"},
+    {CachePlotWidget::Variable::WriteBufferCoalescing, "Write buffer coalescing ratio"},
+    {CachePlotWidget::Variable::WriteBufferStallCycles, "Write buffer stall cycles"},
+    {CachePlotWidget::Variable::WayReads, "Way reads"},
+    {CachePlotWidget::Variable::WayReadsSaved, "Way reads saved"},
+    {CachePlotWidget::Variable::FillBytes, "Bytes filled"},
+    {CachePlotWidget::Variable::WritebackBytes, "Bytes written back"}};
 
 const static std::map<CachePlotWidget::PlotType, QString> s_cachePlotTypeStrings{
     {CachePlotWidget::PlotType::Ratio, "Ratio"},
-    {CachePlotWidget::PlotType::Stacked, "Stacked"}};
+    {CachePlotWidget::PlotType::Stacked, "Stacked"},
+    {CachePlotWidget::PlotType::ReuseDistance, "Reuse distance histogram"}};
+
+const static std::map<WindowConfig::Mode, QString> s_windowModeStrings{
+    {WindowConfig::Mode::Moving, "Moving"},
+    {WindowConfig::Mode::Interval, "Fixed interval"}};
+
+const static std::map<WindowConfig::Unit, QString> s_windowUnitStrings{
+    {WindowConfig::Unit::Accesses, "Accesses"},
+    {WindowConfig::Unit::Cycles, "Cycles"}};
 
 }  // namespace Ripes
 
 Q_DECLARE_METATYPE(Ripes::CachePlotWidget::Variable);
 Q_DECLARE_METATYPE(Ripes::CachePlotWidget::PlotType);
+Q_DECLARE_METATYPE(Ripes::WindowConfig::Mode);
+Q_DECLARE_METATYPE(Ripes::WindowConfig::Unit);
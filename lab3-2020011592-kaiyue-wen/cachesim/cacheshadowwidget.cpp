@@ -0,0 +1,175 @@
+#include "cacheshadowwidget.h"
+
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QTabWidget>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+#include "cacheconfigwidget.h"
+
+namespace {
+
+enum ComparisonRow {
+    Configuration = 0,
+    Accesses,
+    Hits,
+    Misses,
+    HitRate,
+    Writebacks,
+    AMAT,
+    StallCycles,
+    FirstDivergence,
+    DivergentAccesses,
+    N_Rows
+};
+
+QTableWidgetItem* readOnlyItem(const QString& text) {
+    auto* item = new QTableWidgetItem(text);
+    item->setFlags(item->flags() & ~Qt::ItemIsEditable);
+    return item;
+}
+
+}  // namespace
+
+namespace Ripes {
+
+CacheShadowWidget::CacheShadowWidget(CacheSim& sim, QWidget* parent) : QDialog(parent), m_cache(sim) {
+    setWindowTitle("Shadow Caches");
+    resize(720, 560);
+
+    auto* layout = new QVBoxLayout(this);
+    m_tabs = new QTabWidget(this);
+    layout->addWidget(m_tabs);
+
+    m_table = new QTableWidget(N_Rows, 0, this);
+    m_table->setVerticalHeaderLabels({"Configuration", "Accesses", "Hits", "Misses", "Hit rate", "Writebacks",
+                                      "AMAT (cycles)", "Stall cycles", "First divergence (cycle)",
+                                      "Divergent accesses"});
+    m_table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    m_tabs->addTab(m_table, "Comparison");
+
+    auto* buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    m_addButton = buttons->addButton("Add shadow", QDialogButtonBox::ActionRole);
+    m_removeButton = buttons->addButton("Remove shadow", QDialogButtonBox::ActionRole);
+    m_removeButton->setToolTip("Remove the shadow cache of the current tab");
+    connect(m_addButton, &QPushButton::clicked, this, &CacheShadowWidget::addShadow);
+    connect(m_removeButton, &QPushButton::clicked, this, &CacheShadowWidget::removeShadow);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    connect(m_tabs, &QTabWidget::currentChanged, this, &CacheShadowWidget::updateButtons);
+    layout->addWidget(buttons);
+
+    connect(&m_cache, &CacheSim::hitrateChanged, this, &CacheShadowWidget::updateComparison);
+    connect(&m_cache, &CacheSim::configurationChanged, this, &CacheShadowWidget::updateComparison);
+
+    for (unsigned i = 0; i < m_cache.getShadowCount(); i++) {
+        addShadowTab(m_cache.getShadow(i));
+    }
+    updateButtons();
+    updateComparison();
+}
+
+void CacheShadowWidget::addShadow() {
+    if (CacheSim* shadow = m_cache.addShadow()) {
+        addShadowTab(shadow);
+        m_tabs->setCurrentIndex(m_tabs->count() - 1);
+        updateComparison();
+    }
+    updateButtons();
+}
+
+void CacheShadowWidget::removeShadow() {
+    // Tab i + 1 configures shadow i
+    const int tab = m_tabs->currentIndex();
+    if (tab < 1) {
+        return;
+    }
+    CacheSim* shadow = m_cache.getShadow(tab - 1);
+    QWidget* page = m_tabs->widget(tab);
+    m_tabs->removeTab(tab);
+    delete page;
+    m_cache.removeShadow(shadow);
+
+    for (int i = 1; i < m_tabs->count(); i++) {
+        m_tabs->setTabText(i, "Shadow " + QString::number(i));
+    }
+    updateButtons();
+    updateComparison();
+}
+
+void CacheShadowWidget::addShadowTab(CacheSim* shadow) {
+    auto* configWidget = new CacheConfigWidget(m_tabs);
+    configWidget->setCache(shadow);
+    m_tabs->addTab(configWidget, "Shadow " + QString::number(m_tabs->count()));
+
+    connect(shadow, &CacheSim::hitrateChanged, this, &CacheShadowWidget::updateComparison);
+    connect(shadow, &CacheSim::configurationChanged, this, &CacheShadowWidget::updateComparison);
+}
+
+void CacheShadowWidget::updateButtons() {
+    m_addButton->setEnabled(m_cache.getShadowCount() < CacheSim::s_maxShadows);
+    m_removeButton->setEnabled(m_tabs->currentIndex() > 0);
+}
+
+void CacheShadowWidget::updateComparison() {
+    m_cache.syncShadows();
+
+    std::vector<const CacheSim*> caches = {&m_cache};
+    QStringList headers = {"Cache"};
+    for (unsigned i = 0; i < m_cache.getShadowCount(); i++) {
+        caches.push_back(m_cache.getShadow(i));
+        headers << "Shadow " + QString::number(i + 1);
+    }
+    m_table->setColumnCount(static_cast<int>(caches.size()));
+    m_table->setHorizontalHeaderLabels(headers);
+
+    // The shadow which diverged first is highlighted
+    int firstDivergentColumn = -1;
+    unsigned firstDivergence = 0;
+    for (unsigned column = 1; column < caches.size(); column++) {
+        const auto& divergentCycles = caches[column]->getDivergentCycles();
+        if (divergentCycles.size() != 0 && (firstDivergentColumn == -1 || divergentCycles.front() < firstDivergence)) {
+            firstDivergentColumn = static_cast<int>(column);
+            firstDivergence = divergentCycles.front();
+        }
+    }
+
+    for (unsigned column = 0; column < caches.size(); column++) {
+        const CacheSim& cache = *caches[column];
+        const QString configuration = QString("%1 sets × %2 ways × %3 words, %4, %5, %6")
+                                          .arg(cache.getSets())
+                                          .arg(cache.getWays())
+                                          .arg(cache.getBlocks())
+                                          .arg(s_cacheReplPolicyStrings.at(cache.getReplacementPolicy()))
+                                          .arg(s_cacheWritePolicyStrings.at(cache.getWritePolicy()))
+                                          .arg(s_cacheWriteAllocateStrings.at(cache.getWriteAllocPolicy()));
+        m_table->setItem(Configuration, column, readOnlyItem(configuration));
+        m_table->setItem(Accesses, column, readOnlyItem(QString::number(cache.getHits() + cache.getMisses())));
+        m_table->setItem(Hits, column, readOnlyItem(QString::number(cache.getHits())));
+        m_table->setItem(Misses, column, readOnlyItem(QString::number(cache.getMisses())));
+        m_table->setItem(HitRate, column, readOnlyItem(QString::number(cache.getHitRate(), 'G', 4)));
+        m_table->setItem(Writebacks, column, readOnlyItem(QString::number(cache.getWritebacks())));
+        m_table->setItem(AMAT, column, readOnlyItem(QString::number(cache.getAMAT(), 'G', 4)));
+        m_table->setItem(StallCycles, column, readOnlyItem(QString::number(cache.getStallCycles())));
+
+        if (column == 0) {
+            m_table->setItem(FirstDivergence, column, readOnlyItem("-"));
+            m_table->setItem(DivergentAccesses, column, readOnlyItem("-"));
+            continue;
+        }
+        const auto& divergentCycles = cache.getDivergentCycles();
+        auto* divergenceItem =
+            readOnlyItem(divergentCycles.size() == 0 ? "None" : QString::number(divergentCycles.front()));
+        if (static_cast<int>(column) == firstDivergentColumn) {
+            divergenceItem->setBackground(QColor(Qt::red).lighter(160));
+            QFont font = divergenceItem->font();
+            font.setBold(true);
+            divergenceItem->setFont(font);
+        }
+        m_table->setItem(FirstDivergence, column, divergenceItem);
+        m_table->setItem(DivergentAccesses, column, readOnlyItem(QString::number(divergentCycles.size())));
+    }
+}
+
+}  // namespace Ripes
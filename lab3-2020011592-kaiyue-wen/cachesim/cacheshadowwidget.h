@@ -0,0 +1,40 @@
+#pragma once
+
+#include <QDialog>
+
+#include "cachesim.h"
+
+QT_FORWARD_DECLARE_CLASS(QTableWidget);
+QT_FORWARD_DECLARE_CLASS(QTabWidget);
+QT_FORWARD_DECLARE_CLASS(QPushButton);
+
+namespace Ripes {
+
+/**
+ * @brief The CacheShadowWidget class
+ * Dialog for configuring the shadow caches of a cache, and comparing their statistics side by side with those of the
+ * cache itself. The earliest cycle in which the hit/miss outcome of a shadow diverged from the cache is highlighted.
+ */
+class CacheShadowWidget : public QDialog {
+    Q_OBJECT
+
+public:
+    explicit CacheShadowWidget(CacheSim& sim, QWidget* parent = nullptr);
+
+private slots:
+    void addShadow();
+    void removeShadow();
+    void updateComparison();
+
+private:
+    void addShadowTab(CacheSim* shadow);
+    void updateButtons();
+
+    CacheSim& m_cache;
+    QTabWidget* m_tabs = nullptr;
+    QTableWidget* m_table = nullptr;
+    QPushButton* m_addButton = nullptr;
+    QPushButton* m_removeButton = nullptr;
+};
+
+}  // namespace Ripes
@@ -1,11 +1,13 @@
 #include "cachesim.h"
 #include "binutils.h"
 #include "cache_policy_object.h"
+#include "cache_tracepoints.h"
 
 #include "processorhandler.h"
 
 #include <QApplication>
 #include <QThread>
+#include <algorithm>
 #include <random>
 #include <utility>
 #include <bitset>
@@ -13,21 +15,127 @@
 
 namespace Ripes {
 
+namespace {
+static_assert(CapturedAccess::s_noPC == CacheAttribution::s_invalidPC, "Captured PCs are passed on as-is");
+
+/// 64-bit counterpart of generateBitmask, for masks spanning the address width
+uint64_t generateAddressBitmask(int n) {
+    return n >= 64 ? ~static_cast<uint64_t>(0) : (static_cast<uint64_t>(1) << n) - 1;
+}
+}  // namespace
+
 CacheSim::CacheSim(QObject* parent) : QObject(parent) {
     connect(ProcessorHandler::get(), &ProcessorHandler::reqProcessorReset, this, &CacheSim::processorReset);
 
-    connect(ProcessorHandler::get(), &ProcessorHandler::runFinished, this, [=] {
-        // Given that we are not updating the graphical state of the cache simulator whilst the processor is running,
-        // once running is finished, the entirety of the cache view should be reloaded in the graphical view.
-        emit hitrateChanged();
-        emit cacheInvalidated();
-    });
+    // Given that we are not updating the graphical state of the cache simulator whilst the processor is running, once
+    // running is finished, the entirety of the cache view should be reloaded in the graphical view.
+    connect(ProcessorHandler::get(), &ProcessorHandler::runFinished, this, &CacheSim::invalidateViews);
 
     updateConfiguration();
 }
 
+CacheSim::CacheSim(const CacheSim& configuration, CacheSim* primary, QObject* parent)
+    : QObject(parent), m_isDetached(true), m_primary(primary) {
+    copyConfiguration(configuration);
+    rebuildSymbolIndex();
+    updateConfiguration();
+    if (isShadow()) {
+        m_worker =
+            std::make_unique<CacheWorker<ShadowAccess>>([this](const ShadowAccess& access) { accessShadow(access); });
+    }
+}
+
+std::unique_ptr<CacheSim> CacheSim::createDetached(const CacheSim& configuration) {
+    return std::unique_ptr<CacheSim>(new CacheSim(configuration, nullptr, nullptr));
+}
+
+void CacheSim::invalidateViews() {
+    emit hitrateChanged();
+    emit cacheInvalidated();
+    emit dataChanged(m_traceStack.size() > 0 ? &m_traceStack.front().transaction : nullptr);
+}
+
+CacheSim::Snapshot CacheSim::saveSnapshot() const {
+    Snapshot snapshot;
+    for (unsigned setIdx = 0; setIdx < m_cacheSets.size(); setIdx++) {
+        if (m_setGenerations[setIdx] == m_generation) {
+            snapshot.cacheSets.emplace_back(setIdx, m_cacheSets[setIdx]);
+        }
+    }
+    if (m_replPolicyObject != nullptr) {
+        snapshot.replPolicyObject.reset(m_replPolicyObject->clone());
+    }
+    snapshot.traceStack = m_traceStack;
+    snapshot.missClassifier = m_missClassifier;
+    snapshot.attribution = m_attribution;
+    snapshot.symbolAttribution = m_symbolAttribution;
+    snapshot.reuseHistogram = m_reuseHistogram;
+    snapshot.setHeatMap = m_setHeatMap;
+    snapshot.mshrs = m_mshrs;
+    snapshot.stallUntil = m_stallUntil;
+    snapshot.writeBuffer = m_writeBuffer;
+    snapshot.wayPredictor = m_wayPredictor;
+    snapshot.accessCycle = m_accessCycle;
+
+    // Each undo pops a single entry, and requires a trace; the last entry may also be updated by a later access in the
+    // same cycle. All other entries are final.
+    const size_t recent = std::min(m_accessTrace.size(), m_traceStack.size() + 1);
+    snapshot.recentAccessTrace.assign(m_accessTrace.end() - recent, m_accessTrace.end());
+    return snapshot;
+}
+
+void CacheSim::restoreSnapshot(const Snapshot& snapshot, const AccessTrace& history) {
+    // The final entries of the snapshot are those preceding the cycle of its first recent entry. The final entries of
+    // the current access trace which precede that cycle are shared with the snapshot, and need not be copied.
+    const auto precedes = [](const AccessTrace::value_type& entry, unsigned cycle) { return entry.first < cycle; };
+    const unsigned snapshotCycle =
+        snapshot.recentAccessTrace.empty() ? 0 : snapshot.recentAccessTrace.front().first;
+    const size_t currentFinal = m_accessTrace.size() - std::min(m_accessTrace.size(), m_traceStack.size() + 1);
+    m_accessTrace.erase(
+        std::lower_bound(m_accessTrace.begin(), m_accessTrace.begin() + currentFinal, snapshotCycle, precedes),
+        m_accessTrace.end());
+    const unsigned copyFrom = m_accessTrace.empty() ? 0 : m_accessTrace.back().first + 1;
+    m_accessTrace.insert(m_accessTrace.end(), std::lower_bound(history.begin(), history.end(), copyFrom, precedes),
+                         std::lower_bound(history.begin(), history.end(), snapshotCycle, precedes));
+    m_accessTrace.insert(m_accessTrace.end(), snapshot.recentAccessTrace.begin(), snapshot.recentAccessTrace.end());
+
+    invalidateSets();
+    for (const auto& [setIdx, set] : snapshot.cacheSets) {
+        m_cacheSets[setIdx] = set;
+        m_setGenerations[setIdx] = m_generation;
+    }
+    if (snapshot.replPolicyObject) {
+        delete m_replPolicyObject;
+        m_replPolicyObject = snapshot.replPolicyObject->clone();
+    }
+    m_traceStack = snapshot.traceStack;
+    m_missClassifier = snapshot.missClassifier;
+    m_attribution = snapshot.attribution;
+    m_symbolAttribution = snapshot.symbolAttribution;
+    m_reuseHistogram = snapshot.reuseHistogram;
+    m_setHeatMap = snapshot.setHeatMap;
+    m_mshrs = snapshot.mshrs;
+    m_stallUntil = snapshot.stallUntil;
+    m_writeBuffer = snapshot.writeBuffer;
+    m_wayPredictor = snapshot.wayPredictor;
+    m_accessCycle = snapshot.accessCycle;
+}
+
+size_t CacheSim::Snapshot::getBytes() const {
+    // Each way is a node of a std::map, estimated as the way along with four pointers
+    constexpr size_t wayBytes = sizeof(CacheSet::value_type) + 4 * sizeof(void*);
+    size_t bytes = sizeof(Snapshot) + traceStack.size() * sizeof(CacheTrace) +
+                   recentAccessTrace.size() * sizeof(AccessTrace::value_type);
+    for (const auto& set : cacheSets) {
+        bytes += sizeof(set) + set.second.size() * wayBytes;
+    }
+    return bytes + missClassifier.getBytes() + reuseHistogram.getBytes() + attribution.getBytes() +
+           symbolAttribution.getBytes();
+}
+
 void CacheSim::updateCacheSetReplFields(CacheSet& cacheSet, unsigned int setIdx, unsigned wayIdx, bool isHit) {
     this->m_replPolicyObject->updateCacheSetReplFields(cacheSet, setIdx, wayIdx, isHit);
+    CACHE_TRACEPOINT(ReplUpdate, setIdx, wayIdx, isHit);
 }
 
 void CacheSim::revertCacheSetReplFields(CacheSet& cacheSet, const CacheWay& oldWay, unsigned wayIdx) {
@@ -35,20 +143,22 @@ void CacheSim::revertCacheSetReplFields(CacheSet& cacheSet, const CacheWay& oldW
 }
 
 void CacheSim::setReplacementPolicy(ReplPolicy policy) {
-    if (this->m_replPolicyObject != nullptr) {
-        delete this->m_replPolicyObject;
-        this->m_replPolicyObject = nullptr;
-    }
+    const auto pause = pauseShadow();
     m_replPolicy = policy;
-    this->setReplacementPolicyObject();
     processorReset();
 }
 
 void CacheSim::setReplacementPolicyObject() {
     if (this->m_replPolicyObject != nullptr) {
+        if (m_replPolicyObjectPolicy == m_replPolicy &&
+            m_replPolicyObject->hasGeometry(getWays(), getSets(), getBlocks())) {
+            m_replPolicyObject->reset();
+            return;
+        }
         delete this->m_replPolicyObject;
         this->m_replPolicyObject = nullptr;
     }
+    m_replPolicyObjectPolicy = m_replPolicy;
     switch (this->m_replPolicy) {
     case ReplPolicy::Random: this->m_replPolicyObject = new RandomPolicy(getWays(), getSets(), getBlocks()); break;
     case ReplPolicy::LRU: this->m_replPolicyObject = new LruPolicy(getWays(), getSets(), getBlocks()); break;
@@ -60,14 +170,38 @@ void CacheSim::setReplacementPolicyObject() {
     }
 }
 
+void CacheSim::invalidateSets() {
+    const unsigned sets = getSets();
+    if (m_cacheSets.size() != sets || m_setWays != getWays() || ++m_generation == 0) {
+        // The geometry changed, or the generation counter wrapped around; start over with fresh sets
+        m_cacheSets.assign(sets, CacheSet());
+        m_setGenerations.assign(sets, 0);
+        m_generation = 1;
+        m_setWays = getWays();
+    }
+}
+
+CacheSet& CacheSim::liveSet(unsigned setIdx) {
+    CacheSet& set = m_cacheSets[setIdx];
+    if (m_setGenerations[setIdx] != m_generation) {
+        // Reset the ways of a previous generation in place, keeping their nodes
+        for (auto& way : set) {
+            way.second = CacheWay();
+        }
+        m_setGenerations[setIdx] = m_generation;
+    }
+    return set;
+}
+
 std::pair<unsigned, CacheWay*> CacheSim::locateEvictionWay(const CacheTransaction& transaction) {
-    auto& cacheSet = m_cacheSets[transaction.index.set];
+    auto& cacheSet = liveSet(transaction.index.set);
 
     std::pair<unsigned, CacheWay*> ew;
     ew.first = s_invalidIndex;
     ew.second = nullptr;
 
     this->m_replPolicyObject->locateEvictionWay(ew, cacheSet, transaction.index.set);
+    CACHE_TRACEPOINT(ReplLocate, transaction.index.set, ew.first, 0);
 
     Q_ASSERT(ew.first != s_invalidIndex && "Unable to locate way for eviction");
     Q_ASSERT(ew.second != nullptr && "Unable to locate way for eviction");
@@ -76,7 +210,7 @@ std::pair<unsigned, CacheWay*> CacheSim::locateEvictionWay(const CacheTransactio
 
 CacheWay CacheSim::evictAndUpdate(CacheTransaction& transaction) {
     const unsigned wayIdx = transaction.index.way;
-    auto& cacheSet = m_cacheSets[transaction.index.set];
+    auto& cacheSet = liveSet(transaction.index.set);
     CacheWay* wayPtr = &cacheSet[wayIdx];
 
     CacheWay eviction;
@@ -91,6 +225,7 @@ CacheWay CacheSim::evictAndUpdate(CacheTransaction& transaction) {
             // The eviction will result in a writeback
             transaction.isWriteback = true;
         }
+        CACHE_TRACEPOINT(Evict, transaction.index.set, wayIdx, eviction.tag);
     }
     // Invalidate the target way
     *wayPtr = CacheWay();
@@ -98,22 +233,33 @@ CacheWay CacheSim::evictAndUpdate(CacheTransaction& transaction) {
     wayPtr->valid = true;
     wayPtr->dirty = false;
     wayPtr->tag = getTag(transaction.address);
+    wayPtr->validSectors = getSectorMask(transaction.address, transaction.bytes);
+    transaction.filledSectors = wayPtr->validSectors;
     transaction.tagChanged = true;
 
     return eviction;
 }
 
-void CacheSim::analyzeCacheAccess(CacheTransaction& transaction) {
+void CacheSim::analyzeCacheAccess(CacheTransaction& transaction, unsigned predictedWay) {
     transaction.index.set = getSetIdx(transaction.address);
     transaction.index.block = getBlockIdx(transaction.address);
     transaction.isHit = false;
 
-    if (m_cacheSets.count(transaction.index.set) != 0) {
-        for (const auto& way : m_cacheSets.at(transaction.index.set)) {
-            if ((way.second.tag == getTag(transaction.address)) && way.second.valid) {
-                transaction.index.way = way.first;
-                transaction.isHit = true;
-                break;
+    if (const CacheSet* setPtr = getSet(transaction.index.set)) {
+        const uint64_t tag = getTag(transaction.address);
+        const CacheSet& set = *setPtr;
+        // Probe the predicted way before scanning the set
+        const auto predicted = predictedWay == s_invalidIndex ? set.end() : set.find(predictedWay);
+        if (predicted != set.end() && predicted->second.valid && predicted->second.tag == tag) {
+            transaction.index.way = predictedWay;
+            transaction.isHit = true;
+        } else {
+            for (const auto& way : set) {
+                if ((way.second.tag == tag) && way.second.valid) {
+                    transaction.index.way = way.first;
+                    transaction.isHit = true;
+                    break;
+                }
             }
         }
     }
@@ -133,9 +279,9 @@ uint32_t CacheSim::skewhashhelper(const uint32_t part)
     return (new_part)^((head_bit^tail_bit) << (set_bit - 1));
 }
 
-unsigned CacheSim::skewhash(uint32_t address, unsigned way){
+unsigned CacheSim::skewhash(uint64_t address, unsigned way){
     //notice that in skew policy, the tag is the whole address, hence we don't need to save tag bits
-    address >>= 2 + getBlockBits();
+    address = getBlockAddress(address);
     uint32_t mask_skew = generateBitmask(getSetBits());
     unsigned set_bit = getSetBits();
     unsigned set_number = getSets();
@@ -167,13 +313,13 @@ void CacheSim::analyzeCacheAccessSkewedCache(CacheTransaction& transaction) {
     // check whether there is a hit
     for(unsigned k = 0; k < way_number; k++){
         unsigned possibleset = skewhash(transaction.address,k); // naive hash
-        if(m_cacheSets.count(possibleset) == 0){
-            m_cacheSets[possibleset];
+        CacheSet& cacheSet = liveSet(possibleset);
+        if(cacheSet.empty()){
             for(unsigned j = 0; j < way_number; j++){
-                m_cacheSets[possibleset][j];
+                cacheSet[j];
             }
         }
-        if((m_cacheSets[possibleset][k].tag == getTag(transaction.address)) && m_cacheSets[possibleset][k].valid){
+        if((cacheSet[k].tag == getTag(transaction.address)) && cacheSet[k].valid){
             transaction.index.way = k;
             transaction.index.set = possibleset;
             transaction.isHit = true;
@@ -186,7 +332,7 @@ void CacheSim::analyzeCacheAccessSkewedCache(CacheTransaction& transaction) {
         bool hasasign = false;
         for(unsigned k = 0; k < way_number; k++){
             unsigned possibleset = skewhash(transaction.address,k); // naive hash
-            if(! m_cacheSets[possibleset][k].valid){
+            if(! liveSet(possibleset)[k].valid){
                 transaction.index.way = k;
                 transaction.index.set = possibleset;
                 hasasign = true;
@@ -199,8 +345,8 @@ void CacheSim::analyzeCacheAccessSkewedCache(CacheTransaction& transaction) {
             unsigned victim = 0;
             for(unsigned k = 0; k < way_number; k++){
                 unsigned possibleset = skewhash(transaction.address,k); // naive hash
-                max_counter = (max_counter > m_cacheSets[possibleset][k].counter) ? max_counter :m_cacheSets[possibleset][k].counter;
-                if(max_counter == m_cacheSets[possibleset][k].counter){
+                max_counter = (max_counter > liveSet(possibleset)[k].counter) ? max_counter :liveSet(possibleset)[k].counter;
+                if(max_counter == liveSet(possibleset)[k].counter){
                     victim = k;
                 }
             }
@@ -211,38 +357,144 @@ void CacheSim::analyzeCacheAccessSkewedCache(CacheTransaction& transaction) {
     return;
 }
 
-void CacheSim::access(uint32_t address, AccessType type) {
-    address = address & ~0b11;  // Disregard unaligned accesses
+CacheMissClassifier::Outcome CacheSim::classifyCacheAccess(CacheTransaction& transaction) {
+    // The shadow cache only allocates a block if the simulated cache would do so
+    const bool allocate = transaction.isHit || transaction.type == AccessType::Read ||
+                          getWriteAllocPolicy() == WriteAllocPolicy::WriteAllocate;
+    const auto outcome = m_missClassifier.access(getBlockAddress(transaction.address), allocate);
+
+    if (transaction.isHit) {
+        transaction.missType = MissType::None;
+    } else if (outcome.firstTouch) {
+        transaction.missType = MissType::Compulsory;
+    } else if (!outcome.shadowHit) {
+        transaction.missType = MissType::Capacity;
+    } else {
+        transaction.missType = MissType::Conflict;
+    }
+    return outcome;
+}
+
+void CacheSim::access(uint64_t address, AccessType type, uint64_t pc, unsigned bytes) {
+    const uint64_t cycle = ProcessorHandler::get()->getProcessor()->getCycleCount();
+    CapturedAccess captured;
+    captured.isWrite = type == AccessType::Write;
+    captured.bytes = bytes;
+    captured.cycle = cycle;
+    captured.address = address;
+    captured.pc = pc;
+    capture(captured);
+    const bool isHit = accessInCycle(cycle, address, type, pc, bytes);
+    {
+        std::lock_guard<std::mutex> lock(m_shadowsMutex);
+        for (const auto& shadow : m_shadows) {
+            shadow->m_worker->post({address, pc, cycle, bytes, type, isHit});
+        }
+    }
+    sigCacheIsHit.Emit(isHit);
+}
+
+void CacheSim::accessShadow(const ShadowAccess& access) {
+    const bool isHit = accessInCycle(access.cycle, access.address, access.type, access.pc, access.bytes);
+    if (isHit != access.primaryHit) {
+        m_divergentCycles.push_back(static_cast<unsigned>(access.cycle));
+    }
+}
+
+bool CacheSim::accessInCycle(uint64_t cycle, uint64_t address, AccessType type, uint64_t pc, unsigned bytes) {
+    if (this->m_replPolicy == ReplPolicy::NoCache) {
+        return false;
+    }
+    m_accessCycle = cycle;
+
+    if (bytes == s_wordAccess) {
+        // An access without a size is an access of the word containing the address, and never crosses a line
+        address &= ~static_cast<uint64_t>(getWordBytes() - 1);
+        bytes = getWordBytes();
+    }
+
+    // An access is performed as a transaction on each of the lines which it covers; two if it crosses a line boundary,
+    // and more if it is larger than a line
+    const unsigned lineBytes = getWordBytes() * getBlocks();
+    bool isHit = true;
+    bool isSplit = false;
+    uint64_t lineAddress = address;
+    unsigned remaining = bytes;
+    while (remaining > 0) {
+        const unsigned lineAccessBytes =
+            std::min(remaining, lineBytes - static_cast<unsigned>(lineAddress % lineBytes));
+        // With set sampling, transactions on unsampled sets are dropped
+        if (isSampledAddress(lineAddress)) {
+            isHit &= accessLine(lineAddress, type, pc, lineAccessBytes, isSplit);
+            isSplit = true;
+        }
+        lineAddress += lineAccessBytes;
+        remaining -= lineAccessBytes;
+    }
+    return isHit;
+}
+
+bool CacheSim::accessLine(uint64_t address, AccessType type, uint64_t pc, unsigned bytes, bool isSplit) {
     CacheTrace trace;
     CacheWay oldWay;
     CacheTransaction transaction;
     transaction.address = address;
+    transaction.bytes = bytes;
     transaction.type = type;
-
-    if (this->m_replPolicy == ReplPolicy::NoCache) {
-        sigCacheIsHit.Emit(false);
-        return;
-    }
+    transaction.pc = pc;
+    trace.isSplit = isSplit;
+    const uint32_t sectorMask = getSectorMask(address, bytes);
 
     if (this->m_skewPolicy == SkewedAssocPolicy::Skewed) {
         analyzeCacheAccessSkewedCache(transaction); // this should analyze the set and way
+        transaction.wayReads = getWays();
     } else {
-        analyzeCacheAccess(transaction);
+        trace.wayPredictionOutcome = m_wayPredictor.predict(getSetIdx(address), pc);
+        const auto& prediction = trace.wayPredictionOutcome;
+        analyzeCacheAccess(transaction, prediction.predicted ? prediction.way : s_invalidIndex);
+        // A first probe reads a single way; a second probe reads the remaining ways
+        transaction.wayPredicted = prediction.predicted;
+        transaction.firstProbeHit =
+            prediction.predicted && transaction.isHit && transaction.index.way == prediction.way;
+        transaction.wayReads = transaction.firstProbeHit ? 1 : getWays();
+        transaction.wayReadsSaved = getWays() - transaction.wayReads;
     }
-
-    if (type == AccessType::Write && this->m_wrPolicy == WritePolicy::WriteThrough) {
-        sigCacheIsHit.Emit(false);
-    } else {
-        sigCacheIsHit.Emit(transaction.isHit);
+    if (transaction.isHit) {
+        // A resident line only hits if the accessed sectors have been filled
+        const CacheWay& way = liveSet(transaction.index.set)[transaction.index.way];
+        if ((way.validSectors & sectorMask) != sectorMask) {
+            transaction.isHit = false;
+            transaction.sectorMiss = true;
+        }
     }
+    trace.missOutcome = classifyCacheAccess(transaction);
+    if (transaction.sectorMiss) {
+        transaction.missType = MissType::Sector;
+    }
+    trace.reuseOutcome = m_reuseHistogram.access(getBlockAddress(address));
+    m_setHeatMap.record(transaction.index.set, transaction.isHit, 1);
+
+    const bool signalledHit =
+        transaction.isHit && !(type == AccessType::Write && this->m_wrPolicy == WritePolicy::WriteThrough);
 
     if (!transaction.isHit) {
         if (type == AccessType::Read ||
             (type == AccessType::Write && getWriteAllocPolicy() == WriteAllocPolicy::WriteAllocate)) {
-            oldWay = evictAndUpdate(transaction);
+            if (transaction.sectorMiss) {
+                // Only the accessed sectors of the resident line are filled
+                CacheWay& way = liveSet(transaction.index.set)[transaction.index.way];
+                oldWay = way;
+                transaction.filledSectors = sectorMask & ~way.validSectors;
+                way.validSectors |= sectorMask;
+            } else {
+                oldWay = evictAndUpdate(transaction);
+            }
+        } else {
+            // Nothing is filled. The located way is recorded as-is, such that undoing the access leaves it untouched.
+            oldWay = liveSet(transaction.index.set)[transaction.index.way];
         }
     } else {
-        oldWay = m_cacheSets[transaction.index.set][transaction.index.way];
+        oldWay = liveSet(transaction.index.set)[transaction.index.way];
     }
 
     // === Update dirty and metadata bits ===
@@ -253,13 +505,19 @@ void CacheSim::access(uint32_t address, AccessType type) {
 
     if (!writeMissNoAlloc) {
         // Lazily ensure that the located way has been initialized
-        m_cacheSets[transaction.index.set][transaction.index.way];
+        liveSet(transaction.index.set)[transaction.index.way];
         if (type == AccessType::Write && getWritePolicy() == WritePolicy::WriteBack) {
-            CacheWay& way = m_cacheSets[transaction.index.set][transaction.index.way];
+            CacheWay& way = liveSet(transaction.index.set)[transaction.index.way];
             way.dirty = true;
-            way.dirtyBlocks.insert(transaction.index.block);
+            // All words of the line which are (partially) written are dirty
+            for (unsigned block = transaction.index.block; block <= getBlockIdx(address + bytes - 1); block++) {
+                way.dirtyBlocks.insert(block);
+            }
         }
-        updateCacheSetReplFields(m_cacheSets[transaction.index.set], transaction.index.set, transaction.index.way, transaction.isHit);
+        // A sector miss is a hit on a resident line as far as replacement is concerned
+        updateCacheSetReplFields(liveSet(transaction.index.set), transaction.index.set, transaction.index.way,
+                                 transaction.isHit || transaction.sectorMiss);
+        m_wayPredictor.train(trace.wayPredictionOutcome, transaction.index.way);
     } else {
         // In case of a write miss with no write allocate, the value is always written through to memory (a writeback)
         transaction.isWriteback = true;
@@ -270,14 +528,23 @@ void CacheSim::access(uint32_t address, AccessType type) {
         transaction.isWriteback = true;
     }
 
+    updateTraffic(transaction, oldWay, writeMissNoAlloc);
+    updateTiming(transaction, trace, writeMissNoAlloc);
+
     // ===========================
 
     // At this point, no further changes shall be made to the transaction.
     // We record the transaction as well as a possible eviction
+    m_attribution.record(transaction.pc, transaction.address, transaction.isHit, transaction.isWriteback, 1);
+    m_symbolAttribution.record(transaction.address, transaction.isHit, transaction.isWriteback, 1);
     trace.oldWay = oldWay;
     trace.transaction = transaction;
     pushTrace(trace);
     pushAccessTrace(transaction);
+    CACHE_TRACEPOINT(Access, transaction.address,
+                     static_cast<uint64_t>(transaction.index.set) << 32 | transaction.index.way,
+                     (transaction.isHit ? Tracepoints::Hit : 0) | (type == AccessType::Write ? Tracepoints::Write : 0) |
+                         (transaction.isWriteback ? Tracepoints::Writeback : 0));
 
     // === Some sanity checking ===
     // It should never be possible that a read returns an invalid way index
@@ -294,19 +561,77 @@ void CacheSim::access(uint32_t address, AccessType type) {
     if (writeMissNoAlloc) {
         // There are no graphical changes to perform since nothing is pulled into the cache upon a missed write without
         // write allocation
-        return;
+        return signalledHit;
     }
 
-    if (isAsynchronouslyAccessed()) {
-        return;
+    if (!isAsynchronouslyAccessed()) {
+        emit dataChanged(&transaction);
     }
-    emit dataChanged(&transaction);
+    return signalledHit;
 }
 
-unsigned CacheSim::getSetIdx(const uint32_t address) const {
-    uint32_t maskedAddress = address & m_setMask;
-    maskedAddress >>= 2 + getBlockBits();
-    return maskedAddress;
+unsigned CacheSim::getSetIdx(const uint64_t address) const {
+    switch (m_indexFunction) {
+    case IndexFunction::BitSelect: {
+        uint64_t maskedAddress = address & m_setMask;
+        maskedAddress >>= getByteOffsetBits() + getBlockBits();
+        return maskedAddress;
+    }
+    case IndexFunction::PrimeModulo:
+        return static_cast<unsigned>(getBlockAddress(address) % m_indexModulus);
+    case IndexFunction::XorFold:
+    case IndexFunction::XorMatrix:
+        return xorIndex(getBlockAddress(address));
+    }
+    Q_ASSERT(false);
+    return 0;
+}
+
+unsigned CacheSim::xorIndex(uint64_t blockAddress) const {
+    // Each set index bit is the parity of the block address bits selected by its row; no data-dependent branches
+    unsigned idx = 0;
+    for (unsigned i = 0; i < m_indexRows.size(); i++) {
+        idx |= (bitcount(blockAddress & m_indexRows[i]) & 1u) << i;
+    }
+    return idx;
+}
+
+void CacheSim::updateIndexFunction() {
+    const int setBits = getSetBits();
+    const int blockAddressBits = getAddressBits() - getByteOffsetBits() - getBlockBits();
+    const uint64_t setField = generateAddressBitmask(setBits);
+
+    m_indexRows.clear();
+    if (m_indexFunction == IndexFunction::XorFold) {
+        for (int i = 0; i < setBits; i++) {
+            uint64_t row = 0;
+            for (int bit = i; bit < blockAddressBits; bit += setBits) {
+                row |= static_cast<uint64_t>(1) << bit;
+            }
+            m_indexRows.push_back(row);
+        }
+    } else if (m_indexFunction == IndexFunction::XorMatrix) {
+        for (int i = 0; i < setBits; i++) {
+            const uint64_t row = i < static_cast<int>(m_indexMatrix.size()) ? m_indexMatrix[i] : 0;
+            m_indexRows.push_back((row & ~setField & generateAddressBitmask(blockAddressBits)) |
+                                  static_cast<uint64_t>(1) << i);
+        }
+    }
+
+    m_indexModulus = getSets();
+    if (m_indexFunction == IndexFunction::PrimeModulo) {
+        const auto isPrime = [](unsigned v) {
+            for (unsigned d = 2; d * d <= v; d++) {
+                if (v % d == 0) {
+                    return false;
+                }
+            }
+            return v >= 2;
+        };
+        while (m_indexModulus > 2 && !isPrime(m_indexModulus)) {
+            m_indexModulus--;
+        }
+    }
 }
 
 CacheSim::CacheSize CacheSim::getCacheSize() const {
@@ -315,8 +640,9 @@ CacheSim::CacheSize CacheSim::getCacheSize() const {
     const int entries = getSets() * getWays();
 
     // Valid bits
-    unsigned componentBits = entries;  // 1 bit per entry
-    size.components.push_back("Valid bits: " + QString::number(componentBits));
+    unsigned componentBits = entries * getSectors();  // 1 bit per sector of each entry
+    size.components.push_back((getSectors() > 1 ? "Sector valid bits: " : "Valid bits: ") +
+                               QString::number(componentBits));
     size.bits += componentBits;
 
     if (m_wrPolicy == WritePolicy::WriteBack) {
@@ -335,17 +661,24 @@ CacheSim::CacheSize CacheSim::getCacheSize() const {
 
     // Tag bits
     if (this->m_skewPolicy == SkewedAssocPolicy::NonSkewed) {
-        componentBits = bitcount(m_tagMask) * entries;
+        componentBits = getTagBits() * entries;
         size.components.push_back("Tag bits: " + QString::number(componentBits));
         size.bits += componentBits;
     } else {
-        componentBits = 32 * entries;
+        componentBits = getAddressBits() * entries;
         size.components.push_back("Tag bits: " + QString::number(componentBits));
         size.bits += componentBits;
     }
 
+    if (m_wayPredictor.isEnabled()) {
+        // Predicted way bits
+        componentBits = getWaysBits() * m_wayPredictor.getEntries();
+        size.components.push_back("Way prediction bits: " + QString::number(componentBits));
+        size.bits += componentBits;
+    }
+
     // Data bits
-    componentBits = 32 * entries * getBlocks();
+    componentBits = 8 * getWordBytes() * entries * getBlocks();
     size.components.push_back("Data bits: " + QString::number(componentBits));
     size.bits += componentBits;
 
@@ -355,6 +688,11 @@ CacheSim::CacheSize CacheSim::getCacheSize() const {
 void CacheSim::setType(CacheSim::CacheType type) {
     m_type = type;
     reassociateMemory();
+    std::lock_guard<std::mutex> lock(m_shadowsMutex);
+    syncShadows();
+    for (const auto& shadow : m_shadows) {
+        shadow->m_type = type;
+    }
 }
 
 void CacheSim::reassociateMemory() {
@@ -405,25 +743,199 @@ double CacheSim::getHitRate() const {
 }
 
 
+CacheSim::HitRateEstimate CacheSim::getHitRateEstimate() const {
+    HitRateEstimate estimate;
+    estimate.hitRate = getHitRate();
+    estimate.sampled = isSampling();
+    if (!estimate.sampled) {
+        return estimate;
+    }
+
+    // Clusters are the sampled sets; accesses of skewed caches may additionally have been placed in other sets
+    const auto& accesses = m_setHeatMap.getAccesses();
+    const auto& misses = m_setHeatMap.getMisses();
+    unsigned clusters = 0;
+    double totalAccesses = 0, totalHits = 0;
+    for (unsigned set = 0; set < accesses.size(); set++) {
+        if ((set & m_sampleMask) == 0 || accesses[set] != 0) {
+            clusters++;
+            totalAccesses += accesses[set];
+            totalHits += accesses[set] - misses[set];
+        }
+    }
+    if (clusters < 2 || totalAccesses == 0) {
+        estimate.halfWidth = 1;
+        return estimate;
+    }
+
+    const double ratio = totalHits / totalAccesses;
+    double residuals = 0;
+    for (unsigned set = 0; set < accesses.size(); set++) {
+        if ((set & m_sampleMask) == 0 || accesses[set] != 0) {
+            const double residual = (accesses[set] - misses[set]) - ratio * accesses[set];
+            residuals += residual * residual;
+        }
+    }
+    const double meanAccesses = totalAccesses / clusters;
+    const double finitePopulation = 1.0 - 1.0 / (1 << getSampleBits());
+    const double variance = finitePopulation * residuals / (clusters - 1) / (clusters * meanAccesses * meanAccesses);
+    estimate.hitRate = ratio;
+    estimate.halfWidth = std::min(1.96 * std::sqrt(variance), 1.0);
+    return estimate;
+}
+
+double CacheSim::getAMAT() const {
+    if (m_accessTrace.size() == 0) {
+        return 0;
+    } else {
+        auto& trace = m_accessTrace.rbegin()->second;
+        return static_cast<double>(trace.latency) / (trace.hits + trace.misses);
+    }
+}
+
+CacheSim::WayPredictionStats CacheSim::getWayPredictionStats() const {
+    WayPredictionStats stats;
+    if (m_accessTrace.size() == 0) {
+        return stats;
+    }
+    const auto& trace = m_accessTrace.rbegin()->second;
+    if (trace.wayPredictions != 0) {
+        stats.firstProbeHitRate = static_cast<double>(trace.firstProbeHits) / trace.wayPredictions;
+    }
+    stats.secondProbes = trace.wayPredictions - trace.firstProbeHits;
+    stats.secondProbeCycles = stats.secondProbes * m_timing.secondProbeLatency;
+    const uint64_t parallelWayReads = trace.wayReads + trace.wayReadsSaved;
+    if (parallelWayReads != 0) {
+        stats.wayReadsSaved = static_cast<double>(trace.wayReadsSaved) / parallelWayReads;
+    }
+    return stats;
+}
+
+uint64_t CacheSim::getStallCycles() const {
+    if (m_accessTrace.size() == 0) {
+        return 0;
+    } else {
+        auto& trace = m_accessTrace.rbegin()->second;
+        return trace.stallCycles;
+    }
+}
+
+unsigned CacheSim::lookupLatency(const CacheTransaction& transaction) const {
+    const bool secondProbe = transaction.wayPredicted && !transaction.firstProbeHit;
+    return m_timing.hitLatency + (secondProbe ? m_timing.secondProbeLatency : 0);
+}
+
+unsigned CacheSim::accessLatency(const CacheTransaction& transaction) const {
+    unsigned latency = lookupLatency(transaction);
+
+    if (transaction.fillBytes != 0) {
+        latency += m_timing.missPenalty + m_timing.transferCycles(transaction.fillBytes);
+    }
+    if (transaction.writebackBytes != 0 && !transaction.writeBuffered) {
+        // Buffered words are written by the write buffer, off the critical path of the access
+        latency += m_timing.writebackCost + m_timing.transferCycles(transaction.writebackBytes);
+    }
+    return latency;
+}
+
+bool CacheSim::isWriteThrough(const CacheTransaction& transaction, bool writeMissNoAlloc) const {
+    return transaction.type == AccessType::Write &&
+           (getWritePolicy() == WritePolicy::WriteThrough || writeMissNoAlloc);
+}
+
+void CacheSim::updateTraffic(CacheTransaction& transaction, const CacheWay& oldWay, bool writeMissNoAlloc) const {
+    const unsigned sectorBytes = getWordBytes() * getSectorBlocks();
+    transaction.fillBytes = bitcount(transaction.filledSectors) * sectorBytes;
+
+    if (isWriteThrough(transaction, writeMissNoAlloc)) {
+        transaction.writebackBytes = transaction.bytes;
+    } else if (transaction.isWriteback) {
+        uint32_t dirtySectors = 0;
+        for (const unsigned blockIdx : oldWay.dirtyBlocks) {
+            dirtySectors |= 1u << (blockIdx / getSectorBlocks());
+        }
+        transaction.writebackBytes = bitcount(dirtySectors) * sectorBytes;
+    }
+}
+
+void CacheSim::updateTiming(CacheTransaction& transaction, CacheTrace& trace, bool writeMissNoAlloc) {
+    const uint64_t cycle = m_accessCycle;
+
+    if (isWriteThrough(transaction, writeMissNoAlloc) && m_writeBuffer.isEnabled()) {
+        trace.writeBufferOutcome = m_writeBuffer.write(getBlockAddress(transaction.address), cycle);
+        transaction.writeBuffered = true;
+        transaction.writeCoalesced = trace.writeBufferOutcome.coalesced;
+        transaction.writeBufferStallCycles = trace.writeBufferOutcome.stallCycles;
+        // A coalesced write does not result in a separate write to the next level
+        transaction.isWriteback = !transaction.writeCoalesced;
+    }
+
+    const unsigned latency = accessLatency(transaction);
+
+    if (m_mshrs.isNonBlocking()) {
+        // Only misses which fill a sector occupy an MSHR; writes to the next level are posted and complete as hits
+        const bool allocate = transaction.fillBytes != 0;
+        trace.mshrOutcome = m_mshrs.access(getSectorAddress(transaction.address), cycle, allocate,
+                                           lookupLatency(transaction), latency);
+        transaction.latency = trace.mshrOutcome.latency;
+        transaction.stallCycles = trace.mshrOutcome.stallCycles;
+        transaction.mshrMerged = trace.mshrOutcome.merged;
+        transaction.mshrAllocated = trace.mshrOutcome.allocated;
+        transaction.mshrBusyCycles = trace.mshrOutcome.busyCycles;
+    } else {
+        // A blocking cache stalls the processor for the entirety of the access beyond the hit latency
+        transaction.latency = latency;
+        transaction.stallCycles = latency - m_timing.hitLatency;
+    }
+    transaction.latency += transaction.writeBufferStallCycles;
+    transaction.stallCycles += transaction.writeBufferStallCycles;
+
+    trace.oldStallUntil = m_stallUntil;
+    if (transaction.stallCycles != 0) {
+        m_stallUntil = std::max(m_stallUntil, cycle + transaction.stallCycles);
+        sigCacheStall.Emit(transaction.stallCycles);
+    }
+}
+
 void CacheSim::pushAccessTrace(const CacheTransaction& transaction) {
-    // Access traces are pushed in sorted order into the access trace map; indexed by a key corresponding to the cycle
-    // of the acces.
-    const unsigned currentCycle = ProcessorHandler::get()->getProcessor()->getCycleCount();
+    // Access traces are pushed in sorted order onto the access trace; indexed by a key corresponding to the cycle of
+    // the access.
+    const unsigned currentCycle = static_cast<unsigned>(m_accessCycle);
 
     const CacheAccessTrace& mostRecentTrace =
         m_accessTrace.size() == 0 ? CacheAccessTrace() : m_accessTrace.rbegin()->second;
 
-    m_accessTrace[currentCycle] = CacheAccessTrace(mostRecentTrace, transaction);
+    if (m_accessTrace.size() != 0 && m_accessTrace.back().first == currentCycle) {
+        m_accessTrace.back().second = CacheAccessTrace(mostRecentTrace, transaction);
+    } else {
+        m_accessTrace.emplace_back(currentCycle, CacheAccessTrace(mostRecentTrace, transaction));
+        if (m_accessTraceLimit != 0 && m_accessTrace.size() > 2 * m_accessTraceLimit) {
+            thinAccessTrace();
+        }
+    }
 
     if (!isAsynchronouslyAccessed()) {
         emit hitrateChanged();
     }
 }
 
+void CacheSim::thinAccessTrace() {
+    // Entries which may still be undone or updated are kept, as in saveSnapshot()
+    const size_t final = m_accessTrace.size() - std::min(m_accessTrace.size(), m_traceStack.size() + 1);
+    size_t kept = 0;
+    for (size_t i = (final + 1) % 2; i < final; i += 2) {
+        m_accessTrace[kept++] = m_accessTrace[i];
+    }
+    for (size_t i = final; i < m_accessTrace.size(); i++) {
+        m_accessTrace[kept++] = m_accessTrace[i];
+    }
+    m_accessTrace.resize(kept);
+}
+
 void CacheSim::popAccessTrace() {
     Q_ASSERT(m_accessTrace.size() > 0);
     // The access trace should have an entry
-    m_accessTrace.erase(m_accessTrace.rbegin()->first);
+    m_accessTrace.pop_back();
     emit hitrateChanged();
 }
 
@@ -435,21 +947,51 @@ void CacheSim::undo() {
     if (m_traceStack.size() == 0)
         return;
 
-    const auto trace = popTrace();
+    // All transactions of a split access are recorded in the same cycle, and thus within a single access trace entry
     popAccessTrace();
+    bool isSplit = true;
+    while (isSplit && m_traceStack.size() > 0) {
+        const auto trace = popTrace();
+        revertTransaction(trace);
+        isSplit = trace.isSplit;
+    }
+
+    // Finally, re-emit the transaction which occurred in the previous cache access to update the cache
+    // highlighting state
+    if (m_traceStack.size() > 0) {
+        emit dataChanged(&m_traceStack.begin()->transaction);
+    } else {
+        emit dataChanged(nullptr);
+    }
+}
+
+void CacheSim::revertTransaction(const CacheTrace& trace) {
+    CACHE_TRACEPOINT(Undo, trace.transaction.address, trace.transaction.index.set, trace.transaction.index.way);
+    m_missClassifier.revert(getBlockAddress(trace.transaction.address), trace.missOutcome);
+    m_reuseHistogram.revert(getBlockAddress(trace.transaction.address), trace.reuseOutcome);
+    m_setHeatMap.record(trace.transaction.index.set, trace.transaction.isHit, -1);
+    m_attribution.record(trace.transaction.pc, trace.transaction.address, trace.transaction.isHit,
+                         trace.transaction.isWriteback, -1);
+    m_symbolAttribution.record(trace.transaction.address, trace.transaction.isHit, trace.transaction.isWriteback, -1);
+    m_mshrs.revert(trace.mshrOutcome);
+    m_wayPredictor.revert(trace.wayPredictionOutcome);
+    if (trace.transaction.writeBuffered) {
+        m_writeBuffer.revert(trace.writeBufferOutcome);
+    }
+    m_stallUntil = trace.oldStallUntil;
 
     const auto& oldWay = trace.oldWay;
     const auto& transaction = trace.transaction;
     const unsigned& setIdx = trace.transaction.index.set;
     const unsigned& blockIdx = trace.transaction.index.block;
     const unsigned& wayIdx = trace.transaction.index.way;
-    auto& set = m_cacheSets.at(setIdx);
+    auto& set = liveSet(setIdx);
     auto& way = set.at(wayIdx);
 
     // Case 1: A cache way was transitioned to valid. In this case, we simply invalidate the cache way
     if (trace.transaction.transToValid) {
         // Invalidate the way
-        Q_ASSERT(m_cacheSets.at(setIdx).count(wayIdx) != 0);
+        Q_ASSERT(set.count(wayIdx) != 0);
         way = CacheWay();
     }
     // Case 2: A miss occured on a valid entry. In this case, we have to restore the old way, which was evicted
@@ -463,14 +1005,6 @@ void CacheSim::undo() {
 
     // Notify that changes to the way has been performed
     emit wayInvalidated(setIdx, wayIdx);
-
-    // Finally, re-emit the transaction which occurred in the previous cache access to update the cache
-    // highlighting state
-    if (m_traceStack.size() > 0) {
-        emit dataChanged(&m_traceStack.begin()->transaction);
-    } else {
-        emit dataChanged(nullptr);
-    }
 }
 
 CacheSim::CacheTrace CacheSim::popTrace() {
@@ -487,37 +1021,51 @@ void CacheSim::pushTrace(const CacheTrace& eviction) {
     }
 }
 
-uint32_t CacheSim::buildAddress(unsigned tag, unsigned setIdx, unsigned blockIdx) const {
+uint64_t CacheSim::buildAddress(uint64_t tag, unsigned setIdx, unsigned blockIdx) const {
     if (this->m_skewPolicy == SkewedAssocPolicy::NonSkewed) {
-        uint32_t address = 0;
-        address |= tag << (2 /*byte offset*/ + getBlockBits() + getSetBits());
-        address |= setIdx << (2 /*byte offset*/ + getBlockBits());
-        address |= blockIdx << (2 /*byte offset*/);
+        if (m_indexFunction == IndexFunction::PrimeModulo) {
+            const uint64_t blockAddress = tag * m_indexModulus + setIdx;
+            return blockAddress << (getByteOffsetBits() + getBlockBits()) |
+                   static_cast<uint64_t>(blockIdx) << getByteOffsetBits();
+        }
+        if (m_indexFunction == IndexFunction::XorFold || m_indexFunction == IndexFunction::XorMatrix) {
+            // Row i only selects bit i of the set index field, so the field is recovered by removing the contribution
+            // of the tag bits
+            setIdx ^= xorIndex(tag << getSetBits());
+        }
+        uint64_t address = 0;
+        address |= tag << (getByteOffsetBits() + getBlockBits() + getSetBits());
+        address |= static_cast<uint64_t>(setIdx) << (getByteOffsetBits() + getBlockBits());
+        address |= static_cast<uint64_t>(blockIdx) << getByteOffsetBits();
         return address;
     } else {
         return tag;
     }
 }
 
-unsigned CacheSim::getTag(const uint32_t address) const {
+uint64_t CacheSim::getTag(const uint64_t address) const {
     if (this->m_skewPolicy == SkewedAssocPolicy::NonSkewed) {
-        uint32_t maskedAddress = address & m_tagMask;
-        maskedAddress >>= 2 + getBlockBits() + getSetBits();
+        if (m_indexFunction == IndexFunction::PrimeModulo) {
+            return getBlockAddress(address) / m_indexModulus;
+        }
+        uint64_t maskedAddress = address & m_tagMask;
+        maskedAddress >>= getByteOffsetBits() + getBlockBits() + getSetBits();
         return maskedAddress;
     } else {
-        return address;
+        // The tag is the address of the accessed word
+        return address & m_addressMask & ~generateAddressBitmask(getByteOffsetBits());
     }
 }
 
-unsigned CacheSim::getBlockIdx(const uint32_t address) const {
-    uint32_t maskedAddress = address & m_blockMask;
-    maskedAddress >>= 2;
+unsigned CacheSim::getBlockIdx(const uint64_t address) const {
+    uint64_t maskedAddress = address & m_blockMask;
+    maskedAddress >>= getByteOffsetBits();
     return maskedAddress;
 }
 
 const CacheSet* CacheSim::getSet(unsigned idx) const {
-    if (m_cacheSets.count(idx)) {
-        return &m_cacheSets.at(idx);
+    if (idx < m_cacheSets.size() && m_setGenerations[idx] == m_generation) {
+        return &m_cacheSets[idx];
     } else {
         return nullptr;
     }
@@ -525,16 +1073,27 @@ const CacheSet* CacheSim::getSet(unsigned idx) const {
 
 void CacheSim::processorWasClocked() {
     // We do not access cache per clock due to memory stalls
-    // The cache access is triggered by the signal sent from memory module.
-    return;
+    // The cache access is triggered by the signal sent from memory module. Here, the processor is only notified of the
+    // remaining cycles of an ongoing stall.
+    if (m_stallUntil == 0) {
+        return;
+    }
+    const uint64_t cycle = ProcessorHandler::get()->getProcessor()->getCycleCount();
+    const unsigned remaining = m_stallUntil > cycle ? static_cast<unsigned>(m_stallUntil - cycle) : 0;
+    if (remaining == 0) {
+        m_stallUntil = 0;
+    }
+    sigCacheStall.Emit(remaining);
 }
 
 void CacheSim::processorWasReversed() {
+    const unsigned cycleToUndo = ProcessorHandler::get()->getProcessor()->getCycleCount() + 1;
+    revertShadows(cycleToUndo);
+    captureUndo(cycleToUndo);
     if (m_accessTrace.size() == 0) {
         // Nothing to reverse
         return;
     }
-    const unsigned cycleToUndo = ProcessorHandler::get()->getProcessor()->getCycleCount() + 1;
     if (m_accessTrace.rbegin()->first != cycleToUndo) {
         // No cache access in this cycle
         return;
@@ -545,20 +1104,36 @@ void CacheSim::processorWasReversed() {
 
 void CacheSim::updateConfiguration() {
     // Cache configuration changed. Reset all state
-    m_cacheSets.clear();
+    invalidateSets();
+    setReplacementPolicyObject();
     m_accessTrace.clear();
     m_traceStack.clear();
+    m_missClassifier.reset(getSets() * getWays());
+    m_attribution.reset();
+    m_reuseHistogram.reset();
+    m_setHeatMap.reset(getSets());
+    m_mshrs.reset(m_timing.mshrs);
+    m_writeBuffer.reset(m_timing.writeBufferEntries, m_timing.writeBufferDrainCycles);
+    m_wayPredictor.reset(m_skewPolicy == SkewedAssocPolicy::NonSkewed ? m_wayPrediction : WayPredictionPolicy::None,
+                         getSets());
+    m_stallUntil = 0;
+    m_divergentCycles.clear();
+    updateStackRegion();
+    m_symbolAttribution.reset();
 
     // Recalculate masks
-    int bitoffset = 2;  // 2^2 = 4-byte offset (32-bit words in cache)
+    int bitoffset = getByteOffsetBits();  // 2^N-byte offset (words in cache)
 
-    m_blockMask = generateBitmask(getBlockBits()) << bitoffset;
+    m_blockMask = generateAddressBitmask(getBlockBits()) << bitoffset;
     bitoffset += getBlockBits();
 
-    m_setMask = generateBitmask(getSetBits()) << bitoffset;
+    m_setMask = generateAddressBitmask(getSetBits()) << bitoffset;
     bitoffset += getSetBits();
 
-    m_tagMask = generateBitmask(32 - bitoffset) << bitoffset;
+    m_tagMask = generateAddressBitmask(getAddressBits() - bitoffset) << bitoffset;
+    m_addressMask = generateAddressBitmask(getAddressBits());
+    m_sampleMask = generateBitmask(getSampleBits());
+    updateIndexFunction();
 
     // Reset the graphical view & processor
     emit configurationChanged();
@@ -577,6 +1152,17 @@ void CacheSim::processorReset() {
     }
 
     m_isResetting = true;
+    if (isDetached()) {
+        // Shadows are driven by their primary cache rather than by the processor
+        if (isShadow()) {
+            m_primary->syncShadows();
+        }
+        rebuildSymbolIndex();
+        updateConfiguration();
+        m_isResetting = false;
+        return;
+    }
+
     // The processor might have changed. Since our signals/slot library cannot check for existing connection, we do the
     // safe, slightly redundant, thing of disconnecting and reconnecting the VSRTL design update signals.
     reassociateMemory();
@@ -585,37 +1171,249 @@ void CacheSim::processorReset() {
     proc->designWasReversed.Connect(this, &CacheSim::processorWasReversed);
     proc->designWasReset.Connect(this, &CacheSim::processorReset);
 
+    rebuildSymbolIndex();
     updateConfiguration();
+    CapturedAccess captured;
+    captured.kind = CapturedAccess::Kind::Reset;
+    capture(captured);
+
+    // Shadows restart along with this cache, such that all caches observe the same accesses
+    syncShadows();
+    for (const auto& shadow : m_shadows) {
+        shadow->processorReset();
+    }
     m_isResetting = false;
 }
 
+CacheSim* CacheSim::addShadow() {
+    if (isDetached() || m_shadows.size() >= s_maxShadows) {
+        return nullptr;
+    }
+    // The shadow is constructed outside of the lock, such that the processor thread is only held off whilst adding it
+    std::unique_ptr<CacheSim> shadow(new CacheSim(*this, this, nullptr));
+    CacheSim* added = shadow.get();
+    std::lock_guard<std::mutex> lock(m_shadowsMutex);
+    m_shadows.push_back(std::move(shadow));
+    return added;
+}
+
+void CacheSim::removeShadow(CacheSim* shadow) {
+    const auto it = std::find_if(m_shadows.begin(), m_shadows.end(),
+                                 [shadow](const std::unique_ptr<CacheSim>& other) { return other.get() == shadow; });
+    if (it != m_shadows.end()) {
+        // Destroying the shadow performs its posted accesses before joining its worker
+        std::lock_guard<std::mutex> lock(m_shadowsMutex);
+        m_shadows.erase(it);
+    }
+}
+
+std::unique_lock<std::mutex> CacheSim::pauseShadow() {
+    if (!isShadow()) {
+        return {};
+    }
+    std::unique_lock<std::mutex> lock(m_primary->m_shadowsMutex);
+    // Not yet created whilst the shadow is being constructed
+    if (m_worker) {
+        m_worker->sync();
+    }
+    return lock;
+}
+
+bool CacheSim::startCapture(const std::string& path) {
+    std::lock_guard<std::mutex> lock(m_captureMutex);
+    m_capturedCycles.clear();
+    return m_capture.open(path, m_type == CacheType::InstrCache ? CacheTraceWriter::Source::InstrCache
+                                                                : CacheTraceWriter::Source::DataCache);
+}
+
+bool CacheSim::stopCapture() {
+    std::lock_guard<std::mutex> lock(m_captureMutex);
+    return m_capture.close();
+}
+
+void CacheSim::capture(const CapturedAccess& captured) {
+    std::lock_guard<std::mutex> lock(m_captureMutex);
+    if (!m_capture.isOpen()) {
+        return;
+    }
+    m_capture.append(captured);
+    if (captured.kind == CapturedAccess::Kind::Reset) {
+        m_capturedCycles.clear();
+    } else if (m_capturedCycles.empty() || m_capturedCycles.back() != captured.cycle) {
+        m_capturedCycles.push_back(captured.cycle);
+        if (m_capturedCycles.size() > vsrtl::core::ClockedComponent::reverseStackSize()) {
+            m_capturedCycles.pop_front();
+        }
+    }
+}
+
+void CacheSim::captureUndo(uint64_t cycle) {
+    std::lock_guard<std::mutex> lock(m_captureMutex);
+    if (!m_capture.isOpen() || m_capturedCycles.empty() || m_capturedCycles.back() != cycle) {
+        return;
+    }
+    m_capturedCycles.pop_back();
+    CapturedAccess captured;
+    captured.kind = CapturedAccess::Kind::Undo;
+    captured.cycle = cycle;
+    m_capture.append(captured);
+}
+
+void CacheSim::syncShadows() {
+    for (const auto& shadow : m_shadows) {
+        shadow->m_worker->sync();
+    }
+}
+
+void CacheSim::revertShadows(unsigned cycle) {
+    syncShadows();
+    for (const auto& shadow : m_shadows) {
+        const auto& trace = shadow->getAccessTrace();
+        if (trace.size() != 0 && trace.back().first == cycle) {
+            shadow->undo();
+        }
+        auto& divergentCycles = shadow->m_divergentCycles;
+        while (divergentCycles.size() != 0 && divergentCycles.back() >= cycle) {
+            divergentCycles.pop_back();
+        }
+    }
+}
+
+void CacheSim::copyConfiguration(const CacheSim& other) {
+    m_type = other.m_type;
+    m_blocks = other.m_blocks;
+    m_sets = other.m_sets;
+    m_ways = other.m_ways;
+    m_sectors = other.m_sectors;
+    m_wordBits = other.m_wordBits;
+    m_addressBits = other.m_addressBits;
+    m_sampleBits = other.m_sampleBits;
+    m_wrPolicy = other.m_wrPolicy;
+    m_wrAllocPolicy = other.m_wrAllocPolicy;
+    m_skewPolicy = other.m_skewPolicy;
+    m_timing = other.m_timing;
+    m_indexFunction = other.m_indexFunction;
+    m_indexMatrix = other.m_indexMatrix;
+    m_wayPrediction = other.m_wayPrediction;
+    m_replPolicy = other.m_replPolicy;
+    m_attribution.setRegions(other.m_attribution.getRegions());
+}
+
+void CacheSim::rebuildSymbolIndex() {
+    std::map<uint32_t, QString> symbols;
+    std::vector<CacheSymbolAttribution::SectionRange> sections;
+    if (const auto program = ProcessorHandler::get()->getProgram()) {
+        symbols = program->symbols;
+        for (const auto& section : program->sections) {
+            if (section.second.data.size() > 0) {
+                sections.push_back({section.second.address,
+                                    static_cast<uint32_t>(section.second.address + section.second.data.size() - 1)});
+            }
+        }
+    }
+    m_symbolAttribution.build(symbols, sections);
+}
+
+void CacheSim::updateStackRegion() {
+    // Stack accesses are attributed in granules of a cache block
+    for (const auto& region : m_attribution.getRegions()) {
+        if (region.name == "Stack") {
+            m_symbolAttribution.setStackRegion(region, getWordBytes() * getBlocks());
+        }
+    }
+}
+
+void CacheSim::setMemoryRegions(const std::vector<MemoryRegion>& regions) {
+    const auto pause = pauseShadow();
+    m_attribution.setRegions(regions);
+    updateStackRegion();
+}
+
 void CacheSim::setBlocks(unsigned blocks) {
+    const auto pause = pauseShadow();
     m_blocks = blocks;
-    setReplacementPolicyObject();
     processorReset();
 }
 void CacheSim::setSets(unsigned sets) {
+    const auto pause = pauseShadow();
     m_sets = sets;
-    setReplacementPolicyObject();
     processorReset();
 }
 void CacheSim::setWays(unsigned ways) {
+    const auto pause = pauseShadow();
     m_ways = ways;
-    setReplacementPolicyObject();
+    processorReset();
+}
+
+void CacheSim::setTiming(const TimingConfig& timing) {
+    const auto pause = pauseShadow();
+    m_timing = timing;
+    // Accumulated latencies are only meaningful for a single timing configuration
     processorReset();
 }
 
 void CacheSim::setWritePolicy(WritePolicy policy) {
+    const auto pause = pauseShadow();
     m_wrPolicy = policy;
     processorReset();
 }
 
 void CacheSim::setWriteAllocatePolicy(WriteAllocPolicy policy) {
+    const auto pause = pauseShadow();
     m_wrAllocPolicy = policy;
     processorReset();
 }
 
+uint32_t CacheSim::getSectorMask(const uint64_t address, unsigned bytes) const {
+    const unsigned first = getSectorIdx(address);
+    const unsigned last = getSectorIdx(address + bytes - 1);
+    return static_cast<uint32_t>(generateBitmask(last + 1) & ~generateBitmask(first));
+}
+
+void CacheSim::setIndexFunction(IndexFunction function) {
+    const auto pause = pauseShadow();
+    m_indexFunction = function;
+    processorReset();
+}
+
+void CacheSim::setIndexMatrix(const std::vector<uint64_t>& rows) {
+    const auto pause = pauseShadow();
+    m_indexMatrix = rows;
+    processorReset();
+}
+
+void CacheSim::setWayPrediction(WayPredictionPolicy policy) {
+    const auto pause = pauseShadow();
+    m_wayPrediction = policy;
+    processorReset();
+}
+
+void CacheSim::setSampleBits(unsigned sampleBits) {
+    const auto pause = pauseShadow();
+    m_sampleBits = sampleBits;
+    processorReset();
+}
+
+void CacheSim::setAddressBits(unsigned addressBits) {
+    const auto pause = pauseShadow();
+    m_addressBits = addressBits;
+    processorReset();
+}
+
+void CacheSim::setWordBits(unsigned wordBits) {
+    const auto pause = pauseShadow();
+    m_wordBits = wordBits;
+    processorReset();
+}
+
+void CacheSim::setSectors(unsigned sectors) {
+    const auto pause = pauseShadow();
+    m_sectors = sectors;
+    processorReset();
+}
+
 void CacheSim::setPreset(const CachePreset& preset) {
+    const auto pause = pauseShadow();
     m_blocks = preset.blocks;
     m_ways = preset.ways;
     m_sets = preset.sets;
@@ -1,7 +1,11 @@
 #pragma once
 
 #include <math.h>
+#include <algorithm>
+#include <deque>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include <QObject>
@@ -9,8 +13,17 @@
 #include "Signals/Signal.h"
 #include "../external/VSRTL/core/vsrtl_register.h"
 #include "processors/RISC-V/rv_memory.h"
+#include "cache_attribution.h"
+#include "cache_locality_stats.h"
+#include "cache_miss_classifier.h"
+#include "cache_mshr.h"
 #include "cache_organize_component.h"
 #include "cache_policy_object.h"
+#include "cache_symbol_attribution.h"
+#include "cache_trace_capture.h"
+#include "cache_way_predictor.h"
+#include "cache_worker.h"
+#include "cache_write_buffer.h"
 
 using RWMemory = vsrtl::core::RVMemory<32, 32>;
 using ROMMemory = vsrtl::core::ROM<32, 32>;
@@ -24,10 +37,23 @@ public:
 
     enum class WriteAllocPolicy { WriteAllocate, NoWriteAllocate };
     enum class SkewedAssocPolicy {Skewed, NonSkewed};
+    /**
+     * @brief The IndexFunction enum
+     * Function mapping block addresses to sets in non-skewed caches:
+     * - BitSelect: the low bits of the block address.
+     * - XorFold: the low bits of the block address, XOR'ed with each consecutive group of higher bits.
+     * - PrimeModulo: the block address modulo the largest prime not exceeding the number of sets. The sets beyond the
+     *   prime are unused, and the tag is the quotient (one bit wider than for bit selection).
+     * - XorMatrix: bit i of the set index is the parity of the block address masked by row i of a configurable matrix.
+     */
+    enum class IndexFunction { BitSelect, XorFold, PrimeModulo, XorMatrix };
+    using WayPredictionPolicy = CacheWayPredictor::Policy;
     enum class WritePolicy { WriteThrough, WriteBack };
     enum class ReplPolicy { Random, LRU, LRU_LIP, NoCache, PLRU, DIP };
     enum class AccessType { Read, Write };
     enum class CacheType { DataCache, InstrCache };
+    // Sector misses are misses to an unfilled sector of a resident line, and are not classified by the 3C model
+    enum class MissType { None, Compulsory, Capacity, Conflict, Sector };
 
     struct CacheSize {
         unsigned bits = 0;
@@ -45,6 +71,26 @@ public:
         SkewedAssocPolicy skewPolicy;
     };
 
+    /**
+     * @brief The TimingConfig struct
+     * Timing parameters of the cache and its connection to the next level of the memory hierarchy, used to estimate
+     * the latency of each access.
+     */
+    struct TimingConfig {
+        unsigned hitLatency = 1;      // Cycles to access the cache
+        unsigned missPenalty = 20;    // Cycles until the next level starts delivering a missed line
+        unsigned writebackCost = 10;  // Cycles until the next level starts accepting written data
+        unsigned bytesPerCycle = 4;   // Bandwidth of the connection to the next level
+        unsigned mshrs = 0;           // Miss status holding registers of a non-blocking cache; 0: blocking cache
+        unsigned writeBufferEntries = 0;       // Entries of the coalescing write buffer; 0: no write buffer
+        unsigned writeBufferDrainCycles = 10;  // Cycles to drain an entry of the write buffer to the next level
+        unsigned secondProbeLatency = 1;  // Extra cycles of a lookup which does not find the line in the predicted way
+
+        unsigned transferCycles(unsigned bytes) const {
+            return bytesPerCycle == 0 ? 0 : (bytes + bytesPerCycle - 1) / bytesPerCycle;
+        }
+    };
+
     struct CacheIndex {
         unsigned set = s_invalidIndex;
         unsigned way = s_invalidIndex;
@@ -57,7 +103,8 @@ public:
     };
 
     struct CacheTransaction {
-        uint32_t address;
+        uint64_t address;
+        unsigned bytes = 4;  // Bytes accessed within the line
         CacheIndex index;
 
         bool isHit = false;
@@ -65,6 +112,24 @@ public:
         AccessType type;
         bool transToValid = false;  // True if the cache set just transitioned from invalid to valid
         bool tagChanged = false;    // True if transToValid or the previous entry was evicted
+        bool sectorMiss = false;    // True if the line was resident, but the accessed sectors were not
+        uint32_t filledSectors = 0;  // Sectors filled from the next level
+        MissType missType = MissType::None;  // 3C classification of the access; None if the access was a hit
+        uint64_t pc = CacheAttribution::s_invalidPC;  // Program counter of the instruction performing the access
+        unsigned latency = 0;      // Estimated latency of the access, in cycles
+        unsigned stallCycles = 0;  // Cycles for which the access stalls the processor
+        bool mshrMerged = false;     // True if the access merged into the MSHR of a block in flight
+        bool mshrAllocated = false;  // True if the access allocated an MSHR
+        unsigned mshrBusyCycles = 0;  // Cycles for which the allocated MSHR is occupied
+        bool writeBuffered = false;   // True if the word written to the next level was placed in the write buffer
+        bool writeCoalesced = false;  // True if the buffered write merged into an entry of the write buffer
+        unsigned writeBufferStallCycles = 0;  // Cycles spent waiting for a free write buffer entry
+        unsigned fillBytes = 0;       // Bytes read from the next level
+        unsigned writebackBytes = 0;  // Bytes written to the next level
+        bool wayPredicted = false;  // True if the lookup first probed a predicted way
+        bool firstProbeHit = false;  // True if the line was found in the predicted way
+        unsigned wayReads = 0;       // Ways whose tag and data were read by the lookup
+        unsigned wayReadsSaved = 0;  // Ways not read, compared to reading all ways of the set in parallel
     };
 
     struct CacheAccessTrace {
@@ -73,6 +138,24 @@ public:
         int reads = 0;
         int writes = 0;
         int writebacks = 0;
+        int compulsoryMisses = 0;
+        int capacityMisses = 0;
+        int conflictMisses = 0;
+        int sectorMisses = 0;
+        uint64_t fillBytes = 0;
+        uint64_t writebackBytes = 0;
+        uint64_t latency = 0;
+        uint64_t stallCycles = 0;
+        int mshrMerges = 0;
+        int mshrAllocations = 0;
+        uint64_t mshrBusyCycles = 0;
+        int writeBufferWrites = 0;
+        int writeBufferTransactions = 0;  // Writes issued to the next level by the write buffer
+        uint64_t writeBufferStallCycles = 0;
+        int wayPredictions = 0;
+        int firstProbeHits = 0;
+        uint64_t wayReads = 0;
+        uint64_t wayReadsSaved = 0;
         CacheAccessTrace() {}
         CacheAccessTrace(const CacheTransaction& transaction) : CacheAccessTrace(CacheAccessTrace(), transaction) {}
         CacheAccessTrace(const CacheAccessTrace& pre, const CacheTransaction& transaction) {
@@ -81,23 +164,96 @@ public:
             writebacks = pre.writebacks + (transaction.isWriteback ? 1 : 0);
             hits = pre.hits + (transaction.isHit ? 1 : 0);
             misses = pre.misses + (transaction.isHit ? 0 : 1);
+            compulsoryMisses = pre.compulsoryMisses + (transaction.missType == MissType::Compulsory ? 1 : 0);
+            capacityMisses = pre.capacityMisses + (transaction.missType == MissType::Capacity ? 1 : 0);
+            conflictMisses = pre.conflictMisses + (transaction.missType == MissType::Conflict ? 1 : 0);
+            sectorMisses = pre.sectorMisses + (transaction.missType == MissType::Sector ? 1 : 0);
+            fillBytes = pre.fillBytes + transaction.fillBytes;
+            writebackBytes = pre.writebackBytes + transaction.writebackBytes;
+            latency = pre.latency + transaction.latency;
+            stallCycles = pre.stallCycles + transaction.stallCycles;
+            mshrMerges = pre.mshrMerges + (transaction.mshrMerged ? 1 : 0);
+            mshrAllocations = pre.mshrAllocations + (transaction.mshrAllocated ? 1 : 0);
+            mshrBusyCycles = pre.mshrBusyCycles + transaction.mshrBusyCycles;
+            writeBufferWrites = pre.writeBufferWrites + (transaction.writeBuffered ? 1 : 0);
+            writeBufferTransactions =
+                pre.writeBufferTransactions + (transaction.writeBuffered && !transaction.writeCoalesced ? 1 : 0);
+            writeBufferStallCycles = pre.writeBufferStallCycles + transaction.writeBufferStallCycles;
+            wayPredictions = pre.wayPredictions + (transaction.wayPredicted ? 1 : 0);
+            firstProbeHits = pre.firstProbeHits + (transaction.firstProbeHit ? 1 : 0);
+            wayReads = pre.wayReads + transaction.wayReads;
+            wayReadsSaved = pre.wayReadsSaved + transaction.wayReadsSaved;
         }
     };
 
+    /**
+     * @brief AccessTrace
+     * Cumulative cache access statistics, indexed by the cycle in which they were recorded. Entries are stored in
+     * increasing cycle order in a flat array, such that long traces can be traversed (and plotted) efficiently.
+     */
+    using AccessTrace = std::vector<std::pair<unsigned /*cycle*/, CacheAccessTrace>>;
+
     CacheSim(QObject* parent);
+    /**
+     * @brief createDetached
+     * @returns a cache configured as @p configuration, which is not attached to the processor. A detached cache is only
+     * accessed through accessInCycle(), e.g. when replaying a captured trace, and its processorReset() merely clears
+     * its state.
+     */
+    static std::unique_ptr<CacheSim> createDetached(const CacheSim& configuration);
+    bool isDetached() const { return m_isDetached; }
     void setType(CacheType type);
     void setWritePolicy(WritePolicy policy);
     void setWriteAllocatePolicy(WriteAllocPolicy policy);
     void setReplacementPolicy(ReplPolicy policy);
     void setSkewedAssocPolicy(SkewedAssocPolicy policy) {
+        const auto pause = pauseShadow();
         m_skewPolicy = policy;
     }
 
+    /**
+     * @brief s_wordAccess
+     * Access size denoting an access of a single word, of the configured word size. The address of such an access is
+     * aligned down to its word; only accesses with an explicit size are split over the lines they cover.
+     */
+    static constexpr unsigned s_wordAccess = 0;
+
+    /**
+     * @brief recvSigAccess
+     * Processor-side hook for memory accesses without a known PC. The PC of an instruction fetch is the fetched
+     * address; loads and stores are only attributed to an instruction if the memory component reports them through
+     * recvSigAccessPC. The memory components are part of the processor models, outside of the cache simulator.
+     */
     void recvSigAccess(uint32_t address, bool isWrite) {
-        if (isWrite) access(address, AccessType::Write);
-        else access(address, AccessType::Read);
+        // An instruction fetch is performed by the instruction at the fetched address
+        const uint64_t pc = m_type == CacheType::InstrCache ? address : CacheAttribution::s_invalidPC;
+        recvSigAccessPC(address, isWrite, pc);
     }
-    void access(uint32_t address, AccessType type);
+    /**
+     * @brief recvSigAccessPC
+     * Processor-side hook for memory accesses where the program counter @p pc of the accessing instruction, and
+     * optionally the size of the access in @p bytes, is known.
+     */
+    void recvSigAccessPC(uint64_t address, bool isWrite, uint64_t pc, unsigned bytes = s_wordAccess) {
+        if (isWrite) access(address, AccessType::Write, pc, bytes);
+        else access(address, AccessType::Read, pc, bytes);
+    }
+    /**
+     * @brief access
+     * Accesses @p bytes bytes at the (byte) @p address. An access which crosses a line boundary, or is larger than a
+     * line, is split into a transaction on each of the lines it covers, which are recorded and undone as a single
+     * access.
+     */
+    void access(uint64_t address, AccessType type, uint64_t pc = CacheAttribution::s_invalidPC,
+                unsigned bytes = s_wordAccess);
+    /**
+     * @brief accessInCycle
+     * Performs an access as access() does, recorded in @p cycle rather than in the current cycle of the processor. The
+     * outcome is not signalled to the processor, and the access is not forwarded to the shadow caches.
+     * @returns whether the access is a hit, as signalled to the processor.
+     */
+    bool accessInCycle(uint64_t cycle, uint64_t address, AccessType type, uint64_t pc = CacheAttribution::s_invalidPC,
+                       unsigned bytes = s_wordAccess);
     void undo();
     void processorReset();
 
@@ -108,44 +264,234 @@ public:
         return m_skewPolicy;
     }
 
-    const std::map<unsigned, CacheAccessTrace>& getAccessTrace() const { return m_accessTrace; }
+    /**
+     * @brief s_maxShadows
+     * Shadow caches are independently configured caches which are accessed with the accesses of this (primary) cache,
+     * each on its own host thread. They are reset and rolled back along with the primary cache, such that a single run
+     * of a program compares several configurations. Shadows are not attached to the processor, and do not signal it.
+     */
+    static constexpr unsigned s_maxShadows = 4;
+    /**
+     * @brief addShadow, removeShadow
+     * Adds a shadow cache, initially configured as this cache, or removes one. Either may be called whilst the
+     * processor is running; the processor thread is held off from accessing the shadows until the change is done.
+     * @returns the shadow, or nullptr if this cache already has s_maxShadows shadows.
+     */
+    CacheSim* addShadow();
+    void removeShadow(CacheSim* shadow);
+    unsigned getShadowCount() const { return static_cast<unsigned>(m_shadows.size()); }
+    CacheSim* getShadow(unsigned idx) const { return m_shadows.at(idx).get(); }
+    bool isShadow() const { return m_primary != nullptr; }
+    /**
+     * @brief syncShadows
+     * Blocks until the shadow caches have performed all accesses of this cache. Must be called before inspecting the
+     * state of a shadow.
+     */
+    void syncShadows();
+    /**
+     * @brief getDivergentCycles
+     * Of a shadow cache: the cycles, in increasing order, of the accesses for which the hit/miss outcome of the shadow
+     * differed from that of its primary cache.
+     */
+    const std::vector<unsigned>& getDivergentCycles() const { return m_divergentCycles; }
+
+    /**
+     * @brief startCapture, stopCapture
+     * Whilst capturing, every access performed by the processor through access() is appended to the trace file at
+     * @p path, along with the rollbacks and resets of the cache, such that the run can be replayed without the
+     * processor. Shadow caches are not captured. Capturing may be started and stopped whilst the processor is running.
+     * @returns false if the trace file could not be created or written; see getCapture().errorString().
+     */
+    bool startCapture(const std::string& path);
+    bool stopCapture();
+    /**
+     * @brief getCapture
+     * The trace writer may only be inspected whilst not capturing, as it is written by the processor thread.
+     */
+    const CacheTraceWriter& getCapture() const { return m_capture; }
+
+    class Snapshot;
+    /**
+     * @brief saveSnapshot, restoreSnapshot
+     * A snapshot holds the simulation state of the cache, from which the cache is later restored without repeating
+     * the accesses which led to it. The cache must be configured as when the snapshot was saved, and must be in a
+     * state of the same run of accesses as the snapshot. To keep snapshots small, the access trace is only partially
+     * copied; the entries which are final (can no longer be undone) are taken from @p history, the access trace of
+     * that run at any later point. Final entries are matched by cycle, such that either trace may have been thinned
+     * (see setAccessTraceLimit()).
+     */
+    Snapshot saveSnapshot() const;
+    void restoreSnapshot(const Snapshot& snapshot, const AccessTrace& history);
+    /**
+     * @brief setAccessTraceLimit
+     * Bounds the access trace to about 2 * @p entries entries; 0 (the default) keeps an entry for every cycle with an
+     * access. Whenever the trace exceeds the bound, every other final entry is dropped, halving the resolution of the
+     * older part of the trace. The entries are cumulative, so the remaining entries, and the statistics of the cache,
+     * are unaffected.
+     */
+    void setAccessTraceLimit(size_t entries) { m_accessTraceLimit = entries; }
+
+    const AccessTrace& getAccessTrace() const { return m_accessTrace; }
+    const CacheAttribution& getAttribution() const { return m_attribution; }
+    const CacheSymbolAttribution& getSymbolAttribution() const { return m_symbolAttribution; }
+    const CacheReuseHistogram& getReuseHistogram() const { return m_reuseHistogram; }
+    const CacheSetHeatMap& getSetHeatMap() const { return m_setHeatMap; }
+    void setMemoryRegions(const std::vector<MemoryRegion>& regions);
 
     double getHitRate() const;
+    /**
+     * @brief The HitRateEstimate struct
+     * Estimate of the hit rate of the full cache, with the half width of its 95% confidence interval. Without set
+     * sampling, the estimate is exact.
+     */
+    struct HitRateEstimate {
+        double hitRate = 0;
+        double halfWidth = 0;
+        bool sampled = false;
+    };
+    /**
+     * @brief getHitRateEstimate
+     * @returns the hit rate of the full cache, extrapolated from the sampled sets if set sampling is enabled. Each
+     * sampled set is treated as a cluster of accesses, and the confidence interval is that of the ratio estimator of
+     * cluster sampling.
+     */
+    HitRateEstimate getHitRateEstimate() const;
+    /**
+     * @brief getAMAT
+     * @returns the average memory access time, in cycles, of the accesses performed so far.
+     */
+    double getAMAT() const;
+    uint64_t getStallCycles() const;
+    /**
+     * @brief The WayPredictionStats struct
+     * Way prediction statistics of the accesses performed so far. Second probes also include lookups which miss, since
+     * a miss is only detected once all ways have been probed.
+     */
+    struct WayPredictionStats {
+        double firstProbeHitRate = 0;  // Fraction of predicted lookups which found the line in the predicted way
+        uint64_t secondProbes = 0;
+        uint64_t secondProbeCycles = 0;  // Latency added by second probes
+        double wayReadsSaved = 0;        // Fraction of way reads saved compared to parallel lookups
+    };
+    WayPredictionStats getWayPredictionStats() const;
+    const TimingConfig& getTiming() const { return m_timing; }
+    void setTiming(const TimingConfig& timing);
     unsigned getHits() const;
     unsigned getMisses() const;
     unsigned getWritebacks() const;
     CacheSize getCacheSize() const;
     CacheType getCacheType() const { return this->m_type; }
 
-    uint32_t buildAddress(unsigned tag, unsigned lineIdx, unsigned blockIdx) const;
+    uint64_t buildAddress(uint64_t tag, unsigned lineIdx, unsigned blockIdx) const;
 
     int getBlockBits() const { return m_blocks; }
     int getWaysBits() const { return m_ways; }
     int getSetBits() const { return m_sets; }
-    int getTagBits() const { return 32 - 2 /*byte offset*/ - getBlockBits() - getSetBits(); }
+    /**
+     * @brief getSectorBits, getSectors
+     * Cache lines are divided into 2^N sectors, which are filled individually. The number of sectors is bounded by the
+     * number of blocks in a line; a line of a single sector is not sectored.
+     */
+    int getSectorBits() const { return std::min(m_sectors, m_blocks); }
+    int getSectors() const { return 1 << getSectorBits(); }
+    int getSectorBlocks() const { return getBlocks() / getSectors(); }
+    unsigned getSectorIdx(const uint64_t address) const { return getBlockIdx(address) >> (m_blocks - getSectorBits()); }
+    int getTagBits() const {
+        // The quotient of prime modulo indexing requires an extra bit
+        return getAddressBits() - getByteOffsetBits() - getBlockBits() - getSetBits() +
+               (static_cast<int>(m_indexModulus) < getSets() ? 1 : 0);
+    }
+    /**
+     * @brief getAddressBits
+     * Width of the simulated address space; 32 bits for RV32 and 64 bits for RV64 programs or host traces. Address
+     * bits beyond the address width are ignored.
+     */
+    int getAddressBits() const { return m_addressBits; }
+    /**
+     * @brief getSampleBits, isSampling
+     * With set sampling, only 1 in 2^N sets (those whose index is a multiple of 2^N) is simulated. Accesses to other
+     * sets are dropped before any lookup, and are reported to the processor as hits. All counters and statistics then
+     * cover the sampled sets only.
+     */
+    int getSampleBits() const { return std::min(m_sampleBits, m_sets); }
+    bool isSampling() const { return getSampleBits() > 0; }
+    IndexFunction getIndexFunction() const { return m_indexFunction; }
+    const std::vector<uint64_t>& getIndexMatrix() const { return m_indexMatrix; }
+    /**
+     * @brief getWayPrediction
+     * Way prediction applies to non-skewed caches only. The predicted way is probed before the remaining ways of the
+     * set, both in the modelled hardware and in the simulator's own lookup.
+     */
+    WayPredictionPolicy getWayPrediction() const { return m_wayPrediction; }
+    /**
+     * @brief getByteOffsetBits, getWordBytes
+     * Cache blocks are words of 2^N bytes; 4 bytes for RV32 and 8 bytes for RV64.
+     */
+    int getByteOffsetBits() const { return m_wordBits; }
+    unsigned getWordBytes() const { return 1u << m_wordBits; }
 
     int getBlocks() const { return static_cast<int>(std::pow(2, m_blocks)); }
     int getWays() const { return static_cast<int>(std::pow(2, m_ways)); }
     int getSets() const { return static_cast<int>(std::pow(2, m_sets)); }
-    unsigned getBlockMask() const { return m_blockMask; }
-    unsigned getTagMask() const { return m_tagMask; }
-    unsigned getSetMask() const { return m_setMask; }
+    uint64_t getBlockMask() const { return m_blockMask; }
+    uint64_t getTagMask() const { return m_tagMask; }
+    uint64_t getSetMask() const { return m_setMask; }
 
-    unsigned getSetIdx(const uint32_t address) const;
-    unsigned skewhash(uint32_t address, unsigned way);
+    unsigned getSetIdx(const uint64_t address) const;
+    unsigned skewhash(uint64_t address, unsigned way);
     uint32_t skewhashhelper(const uint32_t part);
 
-    unsigned getBlockIdx(const uint32_t address) const;
-    unsigned getTag(const uint32_t address) const;
+    unsigned getBlockIdx(const uint64_t address) const;
+    uint64_t getTag(const uint64_t address) const;
+    /**
+     * @brief getBlockAddress
+     * @returns the address of the cache line containing @p address, with the block and byte offset bits removed.
+     */
+    uint64_t getBlockAddress(const uint64_t address) const {
+        return (address & m_addressMask) >> (getByteOffsetBits() + getBlockBits());
+    }
+    /**
+     * @brief getSectorAddress
+     * @returns the address of the sector containing @p address, with the byte offset and the block offset within the
+     * sector removed.
+     */
+    uint64_t getSectorAddress(const uint64_t address) const {
+        return (address & m_addressMask) >> (getByteOffsetBits() + getBlockBits() - getSectorBits());
+    }
+    /**
+     * @brief getSectorMask
+     * @returns the mask of the sectors of a line which are accessed by an access of @p bytes bytes at @p address. The
+     * access must not cross a line boundary.
+     */
+    uint32_t getSectorMask(const uint64_t address, unsigned bytes) const;
 
     const CacheSet* getSet(unsigned idx) const;
 
     Gallant::Signal1<bool> sigCacheIsHit;
+    /**
+     * @brief sigCacheStall
+     * Emitted with the number of cycles for which the processor should stall on the cache; once upon an access which
+     * stalls, and upon each subsequent clock cycle until the stall has passed (at which point 0 is emitted).
+     */
+    Gallant::Signal1<unsigned> sigCacheStall;
 
 public slots:
     void setBlocks(unsigned blocks);
     void setSets(unsigned sets);
     void setWays(unsigned ways);
+    void setSectors(unsigned sectors);
+    void setAddressBits(unsigned addressBits);
+    void setSampleBits(unsigned sampleBits);
+    void setIndexFunction(IndexFunction function);
+    /**
+     * @brief setIndexMatrix
+     * Sets the rows of the matrix of the XorMatrix index function. Row i is a mask of the block address bits which
+     * are XOR'ed into bit i of the set index. Bit i of the block address is always included in row i, and no other
+     * bits of the set index field are; this keeps the function reversible given the tag.
+     */
+    void setIndexMatrix(const std::vector<uint64_t>& rows);
+    void setWordBits(unsigned wordBits);
+    void setWayPrediction(WayPredictionPolicy policy);
     void setPreset(const CachePreset& preset);
 
     /**
@@ -155,6 +501,13 @@ public slots:
     void processorWasClocked();
     void processorWasReversed();
 
+    /**
+     * @brief invalidateViews
+     * Signals the graphical views to reload the entire state of the cache, after it changed without signalling; after
+     * asynchronous running, or after restoring a snapshot.
+     */
+    void invalidateViews();
+
 signals:
     void configurationChanged();
     void dataChanged(const CacheTransaction* transaction);
@@ -175,19 +528,137 @@ signals:
     void cacheInvalidated();
 
 private:
+    /**
+     * @brief CacheSim
+     * Constructs a detached cache configured as @p configuration; a shadow cache if @p primary is set.
+     */
+    CacheSim(const CacheSim& configuration, CacheSim* primary, QObject* parent);
+
+    /**
+     * @brief The ShadowAccess struct
+     * An access of the primary cache, forwarded to a shadow cache along with its outcome in the primary cache.
+     */
+    struct ShadowAccess {
+        uint64_t address;
+        uint64_t pc;
+        uint64_t cycle;
+        unsigned bytes;
+        AccessType type;
+        bool primaryHit;
+    };
+    void accessShadow(const ShadowAccess& access);
+    /**
+     * @brief revertShadows
+     * Rolls back the accesses of the shadow caches in @p cycle.
+     */
+    void revertShadows(unsigned cycle);
+    /**
+     * @brief capture, captureUndo
+     * Appends @p captured to the trace file, if capturing. captureUndo() appends an undo of @p cycle if an access was
+     * captured in that cycle, regardless of whether the access was simulated by this cache (it may have been dropped by
+     * set sampling, or the cache may be disabled), such that the trace does not depend on the configuration.
+     */
+    void capture(const CapturedAccess& captured);
+    void captureUndo(uint64_t cycle);
+    /**
+     * @brief pauseShadow
+     * Of a shadow cache: holds off its primary cache from posting accesses, and waits for the posted accesses to be
+     * performed, such that the configuration of the shadow may be changed from the GUI thread whilst the processor is
+     * running. The shadow is paused until the returned lock is released. Of any other cache, returns an empty lock.
+     */
+    std::unique_lock<std::mutex> pauseShadow();
+    void copyConfiguration(const CacheSim& other);
+
     struct CacheTrace {
         CacheTransaction transaction;
         CacheWay oldWay;
+        CacheMissClassifier::Outcome missOutcome;
+        CacheReuseHistogram::Outcome reuseOutcome;
+        bool isSplit = false;  // True if the transaction follows another transaction of the same split access
+        CacheMshrFile::Outcome mshrOutcome;
+        CacheWriteBuffer::Outcome writeBufferOutcome;
+        CacheWayPredictor::Outcome wayPredictionOutcome;
+        uint64_t oldStallUntil;
     };
 
+    /**
+     * @brief accessLine
+     * Performs a transaction of @p bytes bytes at @p address, within a single line. @p isSplit is true for all but the
+     * first performed transaction of a split access.
+     * @returns whether the transaction should be signalled as a hit to the processor.
+     */
+    bool accessLine(uint64_t address, AccessType type, uint64_t pc, unsigned bytes, bool isSplit);
+    bool isSampledAddress(uint64_t address) const { return (getSetIdx(address) & m_sampleMask) == 0; }
+    unsigned xorIndex(uint64_t blockAddress) const;
+    void updateIndexFunction();
+    /**
+     * @brief revertTransaction
+     * Reverts the changes to the cache performed by the transaction of @p trace.
+     */
+    void revertTransaction(const CacheTrace& trace);
     std::pair<unsigned, CacheWay*> locateEvictionWay(const CacheTransaction& transaction);
     CacheWay evictAndUpdate(CacheTransaction& transaction);
-    void analyzeCacheAccess(CacheTransaction& transaction);
+    /**
+     * @brief analyzeCacheAccess
+     * Looks up the line of @p transaction, probing @p predictedWay (if valid) before scanning the set.
+     */
+    void analyzeCacheAccess(CacheTransaction& transaction, unsigned predictedWay = s_invalidIndex);
     void analyzeCacheAccessSkewedCache(CacheTransaction& transaction);
+    CacheMissClassifier::Outcome classifyCacheAccess(CacheTransaction& transaction);
+    /**
+     * @brief accessLatency
+     * @returns the estimated latency of @p transaction: the lookup latency, plus the time to fill data from the next
+     * level on an allocating miss, plus the time to write data to the next level on a writeback.
+     */
+    unsigned accessLatency(const CacheTransaction& transaction) const;
+    /**
+     * @brief lookupLatency
+     * @returns the hit latency, plus the second probe latency if the line was not found in a predicted way.
+     */
+    unsigned lookupLatency(const CacheTransaction& transaction) const;
+    /**
+     * @brief isWriteThrough
+     * @returns true if @p transaction writes the accessed bytes directly to the next level; write-through writes and
+     * non-allocating write misses. Such writes never evict a dirty line.
+     */
+    bool isWriteThrough(const CacheTransaction& transaction, bool writeMissNoAlloc) const;
+    /**
+     * @brief updateTraffic
+     * Sets the bytes filled from and written to the next level by @p transaction. Only the accessed sectors are filled,
+     * and only the dirty sectors of an evicted line @p oldWay are written back.
+     */
+    void updateTraffic(CacheTransaction& transaction, const CacheWay& oldWay, bool writeMissNoAlloc) const;
+    /**
+     * @brief updateTiming
+     * Sets the latency and stall cycles of @p transaction, according to either the blocking or non-blocking timing
+     * model. Words written to the next level are placed in the write buffer, if enabled.
+     */
+    void updateTiming(CacheTransaction& transaction, CacheTrace& trace, bool writeMissNoAlloc);
     void updateConfiguration();
     void pushAccessTrace(const CacheTransaction& transaction);
     void popAccessTrace();
+    /**
+     * @brief thinAccessTrace
+     * Drops every other final entry of the access trace, keeping the most recent one.
+     */
+    void thinAccessTrace();
+    /**
+     * @brief setReplacementPolicyObject
+     * Creates the replacement policy object of the configured policy and geometry. An existing object of the same
+     * policy and geometry is reset and reused rather than recreated.
+     */
     void setReplacementPolicyObject();
+    /**
+     * @brief invalidateSets
+     * Invalidates all cache sets. The storage of the sets is reused if the number of sets and ways is unchanged, in
+     * which case the sets are invalidated in constant time by advancing m_generation.
+     */
+    void invalidateSets();
+    /**
+     * @brief liveSet
+     * @returns the cache set @p setIdx, after resetting its ways if the set was last used in a previous generation.
+     */
+    CacheSet& liveSet(unsigned setIdx);
 
     /**
      * @brief isAsynchronouslyAccessed
@@ -205,20 +676,36 @@ private:
     void reassociateMemory();
 
     ReplPolicy m_replPolicy = ReplPolicy::LRU;
-    CachePolicyBase* m_replPolicyObject = new LruPolicy(4, 8, 1);
+    CachePolicyBase* m_replPolicyObject = nullptr;
+    ReplPolicy m_replPolicyObjectPolicy = ReplPolicy::NoCache;  // The policy of which m_replPolicyObject is an object
 
 
     WritePolicy m_wrPolicy = WritePolicy::WriteBack;
     WriteAllocPolicy m_wrAllocPolicy = WriteAllocPolicy::WriteAllocate;
+    TimingConfig m_timing;
     SkewedAssocPolicy m_skewPolicy = SkewedAssocPolicy::NonSkewed;
 
-    unsigned m_blockMask = -1;
-    unsigned m_setMask = -1;
-    unsigned m_tagMask = -1;
+    uint64_t m_blockMask = -1;
+    uint64_t m_setMask = -1;
+    uint64_t m_tagMask = -1;
+    uint64_t m_addressMask = -1;
+    unsigned m_sampleMask = 0;
+
+    // Precomputed parameters of the index function
+    IndexFunction m_indexFunction = IndexFunction::BitSelect;
+    std::vector<uint64_t> m_indexMatrix;
+    std::vector<uint64_t> m_indexRows;  // Rows of the XOR matrix in effect, for the XorFold and XorMatrix functions
+    unsigned m_indexModulus = 1;        // Modulus of prime modulo indexing; the number of sets otherwise
+
+    WayPredictionPolicy m_wayPrediction = WayPredictionPolicy::None;
 
     int m_blocks = 0;  // Some power of 2
     int m_sets = 3;   // Some power of 2
     int m_ways = 2;    // Some power of 2
+    int m_sectors = 0;  // Some power of 2
+    int m_wordBits = 2;  // Some power of 2; bytes per word
+    int m_addressBits = 32;  // 32 or 64
+    int m_sampleBits = 0;    // Some power of 2
 
     /**
      * @brief m_memory
@@ -233,10 +720,15 @@ private:
     } m_memory;
 
     /**
-     * @brief m_cacheSets
-     * The datastructure for storing our cache hierachy, as per the current cache configuration.
+     * @brief m_cacheSets, m_setGenerations, m_generation
+     * The datastructure for storing our cache hierachy, as per the current cache configuration. A set only holds valid
+     * contents if its entry in m_setGenerations equals m_generation; sets of earlier generations are reset upon their
+     * first use (see liveSet), such that resetting the cache does not depend on its size.
      */
-    std::map<unsigned, CacheSet> m_cacheSets;
+    std::vector<CacheSet> m_cacheSets;
+    std::vector<uint32_t> m_setGenerations;
+    uint32_t m_generation = 0;
+    unsigned m_setWays = 0;  // The number of ways for which m_cacheSets was allocated
 
     void updateCacheSetReplFields(CacheSet& cacheSet, unsigned int setIdx, unsigned wayIdx, bool isHit);
     /**
@@ -251,7 +743,8 @@ private:
      * The access trace stack contains cache access statistics for each simulation cycle. Contrary to the TraceStack
      * (m_traceStack).
      */
-    std::map<unsigned, CacheAccessTrace> m_accessTrace;
+    AccessTrace m_accessTrace;
+    size_t m_accessTraceLimit = 0;  // See setAccessTraceLimit()
 
     /**
      * @brief m_traceStack
@@ -261,6 +754,78 @@ private:
      */
     std::deque<CacheTrace> m_traceStack;
 
+    /**
+     * @brief m_missClassifier
+     * Shadow state used for classifying each miss as either a compulsory, capacity or conflict miss.
+     */
+    CacheMissClassifier m_missClassifier;
+
+    /**
+     * @brief m_attribution
+     * Per-PC and per-memory region access statistics.
+     */
+    CacheAttribution m_attribution;
+
+    /**
+     * @brief m_symbolAttribution
+     * Access statistics per symbol of the currently loaded program. The symbol index is rebuilt upon processor reset,
+     * which is performed whenever a new program is loaded.
+     */
+    CacheSymbolAttribution m_symbolAttribution;
+    void rebuildSymbolIndex();
+    void updateStackRegion();
+
+    /**
+     * @brief m_reuseHistogram, m_setHeatMap
+     * Locality statistics; reuse distances of all accesses, and per-set access and miss counts.
+     */
+    CacheReuseHistogram m_reuseHistogram;
+    CacheSetHeatMap m_setHeatMap;
+
+    /**
+     * @brief m_mshrs, m_stallUntil
+     * MSHRs of the non-blocking timing model, and the cycle until which the processor should stall on the cache (0 if
+     * not stalling).
+     */
+    CacheMshrFile m_mshrs;
+    uint64_t m_stallUntil = 0;
+
+    /**
+     * @brief m_writeBuffer
+     * Coalescing write buffer for words written through to the next level.
+     */
+    CacheWriteBuffer m_writeBuffer;
+
+    /**
+     * @brief m_wayPredictor
+     * Predicted-way table of the way prediction model.
+     */
+    CacheWayPredictor m_wayPredictor;
+
+    /**
+     * @brief m_accessCycle
+     * The cycle in which the current access is performed.
+     */
+    uint64_t m_accessCycle = 0;
+
+    /**
+     * @brief m_capture, m_captureMutex
+     * Trace file of the accesses of the processor, whilst capturing. The mutex is held whilst appending to the trace,
+     * and whilst starting or stopping the capture, which the GUI thread may do whilst the processor thread appends.
+     */
+    CacheTraceWriter m_capture;
+    std::mutex m_captureMutex;
+    std::deque<uint64_t> m_capturedCycles;  // The most recent cycles with a captured access, which may be undone
+
+    bool m_isDetached = false;
+
+    /**
+     * @brief m_primary, m_divergentCycles
+     * Of a shadow cache: the primary cache, and the cycles of the accesses whose outcome diverged from the primary.
+     */
+    CacheSim* m_primary = nullptr;
+    std::vector<unsigned> m_divergentCycles;
+
     /**
      * @brief m_isResetting
      * The cacheSim can be reset by either internally modyfing cache configuration parameters or externally through a
@@ -272,6 +837,45 @@ private:
 
     CacheTrace popTrace();
     void pushTrace(const CacheTrace& trace);
+
+    /**
+     * @brief m_shadows, m_worker
+     * Shadow caches of this cache, and of a shadow cache, the host thread performing its accesses. The worker is
+     * declared last, such that it finishes its queued accesses before any other member is destroyed.
+     * m_shadowsMutex is held by the processor thread whilst posting accesses to the shadows, and by the GUI thread
+     * whilst adding, removing or reconfiguring a shadow.
+     */
+    std::mutex m_shadowsMutex;
+    std::vector<std::unique_ptr<CacheSim>> m_shadows;
+    std::unique_ptr<CacheWorker<ShadowAccess>> m_worker;
+};
+
+class CacheSim::Snapshot {
+    friend class CacheSim;
+
+    std::vector<std::pair<unsigned, CacheSet>> cacheSets;  // The live sets, by index
+    std::unique_ptr<CachePolicyBase> replPolicyObject;
+    std::deque<CacheTrace> traceStack;
+    CacheMissClassifier missClassifier;
+    CacheAttribution attribution;
+    CacheSymbolAttribution symbolAttribution;
+    CacheReuseHistogram reuseHistogram;
+    CacheSetHeatMap setHeatMap;
+    CacheMshrFile mshrs;
+    uint64_t stallUntil = 0;
+    CacheWriteBuffer writeBuffer;
+    CacheWayPredictor wayPredictor;
+    uint64_t accessCycle = 0;
+    AccessTrace recentAccessTrace;  // The entries of the access trace which are not final
+
+public:
+    /**
+     * @brief getBytes
+     * @returns an estimate of the memory held by the snapshot. Besides the cache-sized state, this includes the miss
+     * classifier, reuse histogram and attribution tables, which grow with the number of distinct blocks and PCs
+     * accessed.
+     */
+    size_t getBytes() const;
 };
 
 const static std::map<CacheSim::ReplPolicy, QString> s_cacheReplPolicyStrings{{CacheSim::ReplPolicy::Random, "Random"},
@@ -292,4 +896,15 @@ const static std::map<CacheSim::SkewedAssocPolicy, QString> s_cacheSkewedAssocSt
     {CacheSim::SkewedAssocPolicy::Skewed,"Skewed-associative"},
     {CacheSim::SkewedAssocPolicy::NonSkewed, "Non-skewed-associative"}};
 
+const static std::map<CacheSim::IndexFunction, QString> s_cacheIndexFunctionStrings{
+    {CacheSim::IndexFunction::BitSelect, "Bit selection"},
+    {CacheSim::IndexFunction::XorFold, "XOR folding"},
+    {CacheSim::IndexFunction::PrimeModulo, "Prime modulo"},
+    {CacheSim::IndexFunction::XorMatrix, "XOR matrix"}};
+
+const static std::map<CacheSim::WayPredictionPolicy, QString> s_cacheWayPredictionStrings{
+    {CacheSim::WayPredictionPolicy::None, "None"},
+    {CacheSim::WayPredictionPolicy::MRU, "MRU"},
+    {CacheSim::WayPredictionPolicy::PC, "PC-indexed"}};
+
 }  // namespace Ripes
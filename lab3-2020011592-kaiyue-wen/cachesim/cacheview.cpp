@@ -1,9 +1,10 @@
 #include "cacheview.h"
 
 #include <qmath.h>
-#include <QGraphicsSimpleTextItem>
 #include <QWheelEvent>
 
+#include "cachegraphic.h"
+
 namespace Ripes {
 
 CacheView::CacheView(QWidget* parent) : QGraphicsView(parent) {
@@ -16,13 +17,14 @@ CacheView::CacheView(QWidget* parent) : QGraphicsView(parent) {
 }
 
 void CacheView::mousePressEvent(QMouseEvent* event) {
-    // If we press on a cache data block, get the address stored for that block and emit a signal indicating that the
-    // address was selected through the cache
+    // If we press on a cache data block, get the address of the data in that block and emit a signal indicating that
+    // the address was selected through the cache
     for (const auto& item : items(event->pos())) {
-        if (auto* textItem = dynamic_cast<QGraphicsSimpleTextItem*>(item)) {
-            const QVariant data = textItem->data(Qt::UserRole);
-            if (data.isValid()) {
-                emit cacheAddressSelected(data.toUInt());
+        if (auto* cacheGraphic = dynamic_cast<CacheGraphic*>(item)) {
+            uint64_t address;
+            if (cacheGraphic->addressAt(cacheGraphic->mapFromScene(mapToScene(event->pos())), address)) {
+                // The memory of the processor has a 32-bit address space
+                emit cacheAddressSelected(static_cast<uint32_t>(address));
                 break;
             }
         }
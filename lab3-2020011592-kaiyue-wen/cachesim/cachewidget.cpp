@@ -1,35 +1,159 @@
 #include "cachewidget.h"
 #include "ui_cachewidget.h"
 
+#include <QApplication>
+#include <QFileDialog>
 #include <QGraphicsScene>
 #include <QGraphicsView>
+#include <QMessageBox>
+#include <QSignalBlocker>
+#include <limits>
 
+#include "cache_trace_replay.h"
 #include "cachegraphic.h"
+#include "cacheplotwidget.h"
 
 namespace Ripes {
 
 CacheWidget::CacheWidget(QWidget* parent) : QWidget(parent), m_ui(new Ui::CacheWidget) {
     m_ui->setupUi(this);
 
-    auto* scene = new QGraphicsScene(this);
+    m_scene = new QGraphicsScene(this);
     m_cacheSim = new CacheSim(this);
     m_ui->cacheConfig->setCache(m_cacheSim);
 
-    auto* cacheGraphic = new CacheGraphic(*m_cacheSim);
-    m_ui->cacheView->setScene(scene);
-    scene->addItem(cacheGraphic);
+    m_cacheGraphic = new CacheGraphic(*m_cacheSim);
+    m_ui->cacheView->setScene(m_scene);
+    m_scene->addItem(m_cacheGraphic);
 
     connect(m_ui->cacheView, &CacheView::cacheAddressSelected,
             [=](uint32_t address) { emit cacheAddressSelected(address); });
 
-    connect(m_cacheSim, &CacheSim::configurationChanged, [=] { emit configurationChanged(); });
+    connect(m_cacheSim, &CacheSim::configurationChanged, [=] {
+        // The replayed trace follows the configuration of the cache
+        if (m_replay) {
+            replayTrace(QString::fromStdString(m_replay->getPath()), m_replay->getPosition());
+        }
+        emit configurationChanged();
+    });
+
+    connect(m_ui->loadReplay, &QToolButton::clicked, this, &CacheWidget::loadReplay);
+    connect(m_ui->closeReplay, &QToolButton::clicked, this, &CacheWidget::closeReplay);
+    connect(m_ui->replayPlot, &QToolButton::clicked, this, &CacheWidget::showReplayPlot);
+    connect(m_ui->replaySlider, &QSlider::valueChanged, this, &CacheWidget::seekReplay);
+    connect(m_ui->replayPosition, QOverload<int>::of(&QSpinBox::valueChanged), m_ui->replaySlider,
+            &QSlider::setValue);
+    connect(m_ui->replayStart, &QToolButton::clicked, [=] { m_ui->replaySlider->setValue(0); });
+    connect(m_ui->replayBack, &QToolButton::clicked,
+            [=] { m_ui->replaySlider->setValue(m_ui->replaySlider->value() - 1); });
+    connect(m_ui->replayForward, &QToolButton::clicked,
+            [=] { m_ui->replaySlider->setValue(m_ui->replaySlider->value() + 1); });
+    connect(m_ui->replayEnd, &QToolButton::clicked,
+            [=] { m_ui->replaySlider->setValue(m_ui->replaySlider->maximum()); });
+    updateReplayControls();
 }
 
 void CacheWidget::setType(CacheSim::CacheType type) {
     m_cacheSim->setType(type);
 }
 
+void CacheWidget::loadReplay() {
+    const QString path =
+        QFileDialog::getOpenFileName(this, "Replay trace", "", "Cache access traces (*.rcat);;All files (*)");
+    if (!path.isEmpty()) {
+        replayTrace(path, std::numeric_limits<uint64_t>::max());
+    }
+}
+
+void CacheWidget::replayTrace(const QString& path, uint64_t position) {
+    auto replay = std::make_unique<CacheTraceReplay>(*m_cacheSim);
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    const bool loaded = replay->load(path.toStdString());
+    if (loaded) {
+        replay->seek(position);
+    }
+    QApplication::restoreOverrideCursor();
+    if (!loaded) {
+        QMessageBox::warning(this, "Replay trace", QString::fromStdString(replay->errorString()));
+        return;
+    }
+
+    closeReplay();
+    m_replay = std::move(replay);
+    m_replayGraphic = new CacheGraphic(m_replay->getCache());
+    m_scene->removeItem(m_cacheGraphic);
+    m_scene->addItem(m_replayGraphic);
+    updateReplayControls();
+}
+
+void CacheWidget::closeReplay() {
+    if (!m_replay) {
+        return;
+    }
+    // The plot and the graphic refer to the caches of the replay
+    delete m_replayPlot;
+    delete m_replayGraphic;
+    m_replayGraphic = nullptr;
+    m_replay.reset();
+    m_scene->addItem(m_cacheGraphic);
+    updateReplayControls();
+}
+
+void CacheWidget::seekReplay(int position) {
+    if (!m_replay) {
+        return;
+    }
+    m_replay->seek(static_cast<uint64_t>(position));
+    if (m_replayPlot) {
+        m_replayPlot->setCycleCursor(m_replay->getCycle());
+    }
+    updateReplayControls();
+}
+
+void CacheWidget::showReplayPlot() {
+    if (!m_replay) {
+        return;
+    }
+    if (!m_replayPlot) {
+        m_replayPlot = new CachePlotWidget(m_replay->getRun(), this);
+        m_replayPlot->setAttribute(Qt::WA_DeleteOnClose);
+        m_replayPlot->setWindowTitle("Trace Statistics: " + QString::fromStdString(m_replay->getPath()));
+        m_replayPlot->setCycleCursor(m_replay->getCycle());
+    }
+    m_replayPlot->show();
+    m_replayPlot->raise();
+}
+
+void CacheWidget::updateReplayControls() {
+    const bool replaying = static_cast<bool>(m_replay);
+    for (QWidget* control : std::vector<QWidget*>{m_ui->replayStart, m_ui->replayBack, m_ui->replaySlider,
+                                                  m_ui->replayForward, m_ui->replayEnd, m_ui->replayPosition,
+                                                  m_ui->replayStatus, m_ui->replayPlot, m_ui->closeReplay}) {
+        control->setVisible(replaying);
+    }
+    if (!replaying) {
+        return;
+    }
+
+    // Positions are limited to the range of the slider
+    const int records = static_cast<int>(std::min<uint64_t>(m_replay->getRecords(), std::numeric_limits<int>::max()));
+    const int position = static_cast<int>(std::min<uint64_t>(m_replay->getPosition(), records));
+    const QSignalBlocker sliderBlocker(m_ui->replaySlider);
+    const QSignalBlocker positionBlocker(m_ui->replayPosition);
+    m_ui->replaySlider->setRange(0, records);
+    m_ui->replaySlider->setValue(position);
+    m_ui->replayPosition->setRange(0, records);
+    m_ui->replayPosition->setValue(position);
+
+    const CacheSim& cache = m_replay->getCache();
+    m_ui->replayStatus->setText(QString("/ %1, cycle %2, hit rate %3")
+                                    .arg(m_replay->getRecords())
+                                    .arg(m_replay->getCycle())
+                                    .arg(QString::number(cache.getHitRate(), 'G', 4)));
+}
+
 CacheWidget::~CacheWidget() {
+    closeReplay();
     delete m_ui;
 }
 
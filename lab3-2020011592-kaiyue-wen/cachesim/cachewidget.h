@@ -1,14 +1,21 @@
 #pragma once
 
+#include <QPointer>
 #include <QWidget>
+#include <memory>
 #include "cachesim.h"
 #include "processors/RISC-V/rv_memory.h"
 
 using RVMemory = vsrtl::core::RVMemory<32, 32>;
 
+QT_FORWARD_DECLARE_CLASS(QGraphicsScene);
+
 namespace Ripes {
 
 class CacheSim;
+class CacheGraphic;
+class CachePlotWidget;
+class CacheTraceReplay;
 
 namespace Ui {
 class CacheWidget;
@@ -29,8 +36,33 @@ signals:
     void cacheAddressSelected(uint32_t);
     void configurationChanged();
 
+private slots:
+    void loadReplay();
+    void closeReplay();
+    void seekReplay(int position);
+    void showReplayPlot();
+
 private:
+    /**
+     * @brief replayTrace
+     * Replays the trace file at @p path on the configuration of the cache, and displays the cache at @p position of
+     * the trace in place of the cache of the processor.
+     */
+    void replayTrace(const QString& path, uint64_t position);
+    void updateReplayControls();
+
     Ui::CacheWidget* m_ui;
+    QGraphicsScene* m_scene = nullptr;
+    CacheGraphic* m_cacheGraphic = nullptr;
+
+    /**
+     * @brief m_replay, m_replayGraphic, m_replayPlot
+     * The trace being replayed, if any, the graphic of the cache at the current position of the replay, and the plot
+     * of the trace statistics, on which the current position is marked.
+     */
+    std::unique_ptr<CacheTraceReplay> m_replay;
+    CacheGraphic* m_replayGraphic = nullptr;
+    QPointer<CachePlotWidget> m_replayPlot;
 };
 
 }  // namespace Ripes
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Ripes {
+
+/**
+ * @brief The OpenAddressingMap class
+ * A small hash map from 32- or 64-bit keys to values, using open addressing with linear probing. All entries are
+ * stored in a single contiguous table, which keeps lookups on the cache simulator's access path cheap compared to
+ * node-based maps. Entries are never erased; the table is grown once its load factor exceeds 1/2.
+ * Each entry is tagged with the generation in which it was inserted. Clearing the map advances the generation, which
+ * marks all entries as unused at once, such that the map is cleared in constant time regardless of its size; the table
+ * keeps its capacity.
+ * The key @var s_emptyKey is reserved to mark unused slots and may not be inserted.
+ */
+template <typename T, typename Key = uint32_t>
+class OpenAddressingMap {
+public:
+    static constexpr Key s_emptyKey = static_cast<Key>(-1);
+    struct Entry {
+        Key key;
+        uint32_t generation;
+        T value;
+    };
+
+    explicit OpenAddressingMap(unsigned initialCapacity = 256) {
+        m_table.resize(roundUpPow2(initialCapacity), {s_emptyKey, 0, T()});
+    }
+
+    /**
+     * @brief operator []
+     * @returns a reference to the value associated with @p key. A default-constructed value is inserted if the key is
+     * not yet present.
+     */
+    T& operator[](Key key) {
+        if ((m_size + 1) * 2 > m_table.size()) {
+            grow();
+        }
+        Entry& entry = m_table[probe(key)];
+        if (!isUsed(entry)) {
+            entry = {key, m_generation, T()};
+            m_size++;
+        }
+        return entry.value;
+    }
+
+    /**
+     * @brief find
+     * @returns a pointer to the value associated with @p key, or nullptr if the key is not present.
+     */
+    const T* find(Key key) const {
+        const Entry& entry = m_table[probe(key)];
+        return isUsed(entry) ? &entry.value : nullptr;
+    }
+
+    void clear() {
+        m_size = 0;
+        if (++m_generation == 0) {
+            // The generation wrapped around; entries of the first generation would otherwise become used again
+            for (auto& entry : m_table) {
+                entry = {s_emptyKey, 0, T()};
+            }
+            m_generation = 1;
+        }
+    }
+
+    unsigned size() const { return m_size; }
+    size_t getBytes() const { return m_table.capacity() * sizeof(Entry); }
+
+    /**
+     * @brief forEach
+     * Calls @p f(key, value) for all entries in the map, in unspecified order.
+     */
+    template <typename F>
+    void forEach(F&& f) const {
+        for (const auto& entry : m_table) {
+            if (isUsed(entry)) {
+                f(entry.key, entry.value);
+            }
+        }
+    }
+
+private:
+    static unsigned roundUpPow2(unsigned v) {
+        unsigned p = 1;
+        while (p < v) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    static uint32_t hash(Key key) {
+        // Fibonacci hashing; spreads the (typically word-aligned and clustered) addresses over the table
+        if (sizeof(Key) > sizeof(uint32_t)) {
+            return static_cast<uint32_t>((static_cast<uint64_t>(key) * 11400714819323198485ull) >> 32);
+        }
+        return static_cast<uint32_t>(key) * 2654435769u;
+    }
+
+    /**
+     * @brief isUsed
+     * Entries of a previous generation are unused. Since entries are only marked unused all at once, no entry of the
+     * current generation follows an unused slot in its probe sequence, and probing may stop at the first unused slot.
+     */
+    bool isUsed(const Entry& entry) const { return entry.key != s_emptyKey && entry.generation == m_generation; }
+
+    unsigned probe(Key key) const {
+        const unsigned mask = m_table.size() - 1;
+        unsigned idx = (hash(key) >> 8) & mask;
+        while (isUsed(m_table[idx]) && m_table[idx].key != key) {
+            idx = (idx + 1) & mask;
+        }
+        return idx;
+    }
+
+    void grow() {
+        std::vector<Entry> old;
+        old.swap(m_table);
+        m_table.resize(old.size() * 2, {s_emptyKey, 0, T()});
+        for (auto& entry : old) {
+            if (isUsed(entry)) {
+                m_table[probe(entry.key)] = std::move(entry);
+            }
+        }
+    }
+
+    std::vector<Entry> m_table;
+    unsigned m_size = 0;
+    uint32_t m_generation = 1;
+};
+
+}  // namespace Ripes
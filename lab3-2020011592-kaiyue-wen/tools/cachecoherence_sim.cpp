@@ -0,0 +1,152 @@
+/**
+ * Driver for the multi-core MESI coherence simulator (see cachesim/cache_coherence.h).
+ *
+ * Usage: cachecoherence_sim [--cores N] [--sets BITS] [--ways BITS] [--blocks BITS] [--word-bits BITS] [--threads N]
+ *                           [--top N] trace_file
+ *
+ * Replays an interleaved multi-threaded trace (see CoherenceTraceReader for the format) on a private L1 cache per core,
+ * and prints the statistics of each core, the bus traffic, and the blocks with the most false sharing. The geometry
+ * options are given as powers of two, as in the cache configuration of Ripes; by default, each core has an 8 KiB cache
+ * of 64 sets of 4 ways with 32-byte lines. The number of cores defaults to the number of cores in the trace.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "../cachesim/cache_coherence.h"
+
+using namespace Ripes;
+
+namespace {
+
+double percent(uint64_t part, uint64_t total) {
+    return total == 0 ? 0 : 100.0 * part / total;
+}
+
+void printCoreStats(const CacheCoherenceSim& sim) {
+    std::printf("%-6s %12s %12s %12s %8s %10s %10s %10s %10s %10s %10s\n", "core", "accesses", "hits", "misses",
+                "miss %", "cold", "replace", "true shr", "false shr", "invalid.", "writebacks");
+    CacheCoherenceSim::CoreStats total;
+    for (unsigned core = 0; core < sim.getConfig().cores; core++) {
+        const auto stats = sim.getCoreStats(core);
+        std::printf("%-6u %12llu %12llu %12llu %8.2f %10llu %10llu %10llu %10llu %10llu %10llu\n", core,
+                    static_cast<unsigned long long>(stats.accesses), static_cast<unsigned long long>(stats.hits),
+                    static_cast<unsigned long long>(stats.misses), percent(stats.misses, stats.accesses),
+                    static_cast<unsigned long long>(stats.coldMisses),
+                    static_cast<unsigned long long>(stats.replacementMisses),
+                    static_cast<unsigned long long>(stats.trueSharingMisses),
+                    static_cast<unsigned long long>(stats.falseSharingMisses),
+                    static_cast<unsigned long long>(stats.invalidations),
+                    static_cast<unsigned long long>(stats.writebacks));
+        total.accesses += stats.accesses;
+        total.misses += stats.misses;
+        total.trueSharingMisses += stats.trueSharingMisses;
+        total.falseSharingMisses += stats.falseSharingMisses;
+    }
+    std::printf("total: %llu accesses, %.2f%% misses, of which %.2f%% true sharing and %.2f%% false sharing misses\n",
+                static_cast<unsigned long long>(total.accesses), percent(total.misses, total.accesses),
+                percent(total.trueSharingMisses, total.misses), percent(total.falseSharingMisses, total.misses));
+}
+
+void printBusStats(const CacheCoherenceSim& sim) {
+    const auto bus = sim.getBusStats();
+    std::printf("\nbus: %llu transactions\n", static_cast<unsigned long long>(bus.transactions()));
+    std::printf("  BusRd %llu, BusRdX %llu, BusUpgr %llu, eviction writebacks %llu\n",
+                static_cast<unsigned long long>(bus.busRd), static_cast<unsigned long long>(bus.busRdX),
+                static_cast<unsigned long long>(bus.busUpgr), static_cast<unsigned long long>(bus.writebacks));
+    std::printf("  snoop flushes %llu, cache-to-cache transfers %llu\n", static_cast<unsigned long long>(bus.flushes),
+                static_cast<unsigned long long>(bus.cacheToCache));
+}
+
+void printFalseSharing(const CacheCoherenceSim& sim, unsigned n) {
+    const auto blocks = sim.getFalseSharing(n);
+    if (blocks.empty()) {
+        std::printf("\nno false sharing\n");
+        return;
+    }
+    const unsigned offsetBits = sim.getConfig().wordBits + sim.getConfig().blockBits;
+    std::printf("\nblocks with the most false sharing:\n");
+    std::printf("%-20s %14s %14s %14s %14s\n", "block", "invalidations", "false inval.", "false dirty", "false misses");
+    for (const auto& block : blocks) {
+        std::printf("0x%-18llx %14llu %14llu %14llu %14llu\n",
+                    static_cast<unsigned long long>(block.block << offsetBits),
+                    static_cast<unsigned long long>(block.invalidations),
+                    static_cast<unsigned long long>(block.falseInvalidations),
+                    static_cast<unsigned long long>(block.falseDirtyConflicts),
+                    static_cast<unsigned long long>(block.falseSharingMisses));
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    CacheCoherenceSim::Config config;
+    config.cores = 0;
+    unsigned top = 10;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--cores") == 0 && hasValue) {
+            config.cores = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--sets") == 0 && hasValue) {
+            config.setBits = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--ways") == 0 && hasValue) {
+            config.wayBits = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--blocks") == 0 && hasValue) {
+            config.blockBits = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--word-bits") == 0 && hasValue) {
+            config.wordBits = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+            config.threads = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--top") == 0 && hasValue) {
+            top = std::strtoul(argv[++i], nullptr, 10);
+        } else if (argv[i][0] != '-' && path == nullptr) {
+            path = argv[i];
+        } else {
+            path = nullptr;
+            break;
+        }
+    }
+    if (path == nullptr || config.setBits < 0 || config.setBits > 20 || config.wayBits < 0 || config.wayBits > 8 ||
+        config.blockBits < 0 || config.blockBits > 5 || config.wordBits < 0 || config.wordBits > 3) {
+        std::fprintf(stderr,
+                     "usage: %s [--cores N] [--sets BITS (0-20)] [--ways BITS (0-8)] [--blocks BITS (0-5)] "
+                     "[--word-bits BITS (0-3)] [--threads N] [--top N] trace_file\n",
+                     argv[0]);
+        return 1;
+    }
+
+    std::vector<CoherenceAccess> trace;
+    CoherenceTraceReader reader;
+    if (!reader.read(path, trace)) {
+        std::fprintf(stderr, "%s\n", reader.errorString().c_str());
+        return 1;
+    }
+    if (config.cores == 0) {
+        config.cores = std::max(reader.getCores(), 1u);
+    } else if (config.cores < reader.getCores()) {
+        std::fprintf(stderr, "the trace accesses %u cores, but only %u were configured\n", reader.getCores(),
+                     config.cores);
+        return 1;
+    }
+
+    CacheCoherenceSim sim;
+    sim.reset(config);
+    const auto start = std::chrono::steady_clock::now();
+    sim.run(trace);
+    const auto end = std::chrono::steady_clock::now();
+
+    const auto& applied = sim.getConfig();
+    std::printf("%zu accesses by %u cores; per core %u sets x %u ways x %u-byte lines; %u host threads, %.1f ms\n\n",
+                trace.size(), applied.cores, 1u << applied.setBits, 1u << applied.wayBits,
+                1u << (applied.blockBits + applied.wordBits), applied.threads,
+                std::chrono::duration<double, std::milli>(end - start).count());
+    printCoreStats(sim);
+    printBusStats(sim);
+    printFalseSharing(sim, top);
+    return 0;
+}
@@ -0,0 +1,506 @@
+/**
+ * Throughput benchmark for the cache simulator.
+ *
+ * Drives CacheSim::access with synthetic access streams across a grid of cache geometries, replacement policies, write
+ * policies and skew modes, and reports, per configuration, the simulation time per access, the number of heap
+ * allocations per access and the growth of the resident set size of the process over the run. Results may be saved as a
+ * JSON baseline, and compared against a previously saved baseline.
+ *
+ * Usage: cachesim_bench [--accesses N] [--seed S] [--filter SUBSTRING] [--save baseline.json]
+ *                       [--compare baseline.json] [--sample N] [--way-prediction mru|pc]
+ *                       [--trace trace.rcat] [--capture trace.rcat] [--export csv|bin] [--export-dir DIR] [--reset]
+ *
+ * With --sample N, only 1 in 2^N sets is simulated; the reported hit rates are then extrapolated estimates, and
+ * results are marked as sampled. With --way-prediction, non-skewed caches probe a predicted way first, and the first
+ * probe hit rate and the fraction of way reads saved are reported. The synthetic streams carry no program counters,
+ * such that PC-indexed prediction degenerates to a table per set.
+ *
+ * With --trace, the synthetic streams are replaced by a trace captured from a program run in Ripes (see
+ * CacheSim::startCapture), which is replayed with its original cycles, PCs, access sizes and rollbacks. Only the
+ * records following the last reset of the cache are replayed. With --capture, each synthetic run is captured to the
+ * given file (overwritten per run), such that the cost of capturing shows up in the time per access.
+ *
+ * With --export, the statistics timeline of each run is written by the CacheStatsExporter, as CSV or in the binary
+ * columnar format, to a file named after the configuration in the directory given by --export-dir (by default, the
+ * working directory). Synthetic streams are then performed with one access per cycle, such that the timeline has a row
+ * per access; otherwise, all accesses of a synthetic stream fall in the same cycle.
+ *
+ * With --reset, the time of a processor reset of the cache is reported instead, after filling the cache with the
+ * sequential and the random streams, for each geometry and a larger one of 16384 sets. The reset time should not grow
+ * with the size of the cache, nor with the working set of the stream.
+ *
+ * The benchmark links against the Ripes library. Accesses are performed from a worker thread, as when the processor
+ * is running, such that the cache simulator does not signal the (non-existent) graphical views.
+ */
+
+#include <QApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../cachesim/cache_stats_exporter.h"
+#include "../cachesim/cache_trace_capture.h"
+#include "../cachesim/cache_workloads.h"
+#include "../cachesim/cachesim.h"
+#include "processorhandler.h"
+
+// ============================================================================
+// Allocation counting
+// All heap allocations of the process pass through the replaced global operator new.
+
+namespace {
+std::atomic<uint64_t> s_allocations{0};
+}
+
+void* operator new(std::size_t size) {
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+// ============================================================================
+
+using namespace Ripes;
+
+namespace {
+
+struct Geometry {
+    const char* name;
+    unsigned blockBits;
+    unsigned setBits;
+    unsigned wayBits;
+};
+
+struct WriteConfig {
+    const char* name;
+    CacheSim::WritePolicy wrPolicy;
+    CacheSim::WriteAllocPolicy wrAllocPolicy;
+};
+
+const std::vector<Geometry> s_geometries = {
+    {"b4s16w2", 2, 4, 1}, {"b4s64w4", 2, 6, 2}, {"b8s256w8", 3, 8, 3}, {"b16s1024w16", 4, 10, 4}};
+
+const std::vector<WriteConfig> s_writeConfigs = {
+    {"WB/WA", CacheSim::WritePolicy::WriteBack, CacheSim::WriteAllocPolicy::WriteAllocate},
+    {"WB/NWA", CacheSim::WritePolicy::WriteBack, CacheSim::WriteAllocPolicy::NoWriteAllocate},
+    {"WT/WA", CacheSim::WritePolicy::WriteThrough, CacheSim::WriteAllocPolicy::WriteAllocate},
+    {"WT/NWA", CacheSim::WritePolicy::WriteThrough, CacheSim::WriteAllocPolicy::NoWriteAllocate}};
+
+const std::map<CacheSim::ReplPolicy, const char*> s_replPolicies = {{CacheSim::ReplPolicy::Random, "Random"},
+                                                                    {CacheSim::ReplPolicy::LRU, "LRU"},
+                                                                    {CacheSim::ReplPolicy::LRU_LIP, "LRU_LIP"},
+                                                                    {CacheSim::ReplPolicy::PLRU, "PLRU"},
+                                                                    {CacheSim::ReplPolicy::DIP, "DIP"}};
+
+const std::map<CacheSim::SkewedAssocPolicy, const char*> s_skewPolicies = {
+    {CacheSim::SkewedAssocPolicy::NonSkewed, "NonSkewed"}, {CacheSim::SkewedAssocPolicy::Skewed, "Skewed"}};
+
+// Base address of the stack allocated arrays of the designed benchmarks
+constexpr uint32_t s_stackArrayBase = 0x7ffff000;
+constexpr uint32_t s_dataBase = 0x10000000;
+
+// ============================================================================
+// Access streams
+
+/**
+ * @brief generate
+ * Generates @p n accesses from @p generator ahead of time, such that the benchmark times the cache simulator alone.
+ */
+std::vector<WorkloadAccess> generate(WorkloadGenerator&& generator, unsigned n, uint64_t seed) {
+    std::vector<WorkloadAccess> stream(n);
+    generator.reset(seed);
+    generator.fill(stream.data(), n);
+    return stream;
+}
+
+/// designed_benchmarks/writemiss_benchmarks/bench_writemiss_*.c: a[j] = k for j < 32; sum += a[j] for 32 <= j < 64
+std::vector<WorkloadAccess> writeMissBenchIteration() {
+    std::vector<WorkloadAccess> iteration;
+    for (unsigned j = 0; j < 64; j++) {
+        iteration.push_back({s_stackArrayBase + 4 * j, j < 32});
+    }
+    return iteration;
+}
+
+/**
+ * @brief loadTrace
+ * Reads the records of the trace file at @p path which follow its last reset record. @returns false, after printing
+ * the error, if the file could not be read.
+ */
+bool loadTrace(const char* path, std::vector<CapturedAccess>& trace) {
+    CacheTraceReader reader;
+    if (!reader.open(path)) {
+        std::fprintf(stderr, "%s\n", reader.errorString().c_str());
+        return false;
+    }
+    CapturedAccess record;
+    while (reader.next(record)) {
+        if (record.kind == CapturedAccess::Kind::Reset) {
+            trace.clear();
+        } else {
+            trace.push_back(record);
+        }
+    }
+    if (!reader.errorString().empty()) {
+        std::fprintf(stderr, "'%s': %s\n", path, reader.errorString().c_str());
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+
+struct Result {
+    QString name;
+    double nsPerAccess;
+    double allocationsPerAccess;
+    double hitRate;
+    double hitRateHalfWidth;  // Of the 95% confidence interval; 0 unless sampled
+    double firstProbeHitRate;
+    double wayReadsSaved;
+    long rssGrowthKiB;  // May be negative if the run released memory held by the previous configuration
+};
+
+/// The current resident set size of the process, as opposed to getrusage's high-water mark over all previous runs
+long residentKiB() {
+    long size = 0;
+    long resident = 0;
+    if (FILE* statm = std::fopen("/proc/self/statm", "r")) {
+        if (std::fscanf(statm, "%ld %ld", &size, &resident) != 2) {
+            resident = 0;
+        }
+        std::fclose(statm);
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+void replay(CacheSim& cache, const std::vector<WorkloadAccess>& stream, bool cyclePerAccess) {
+    if (cyclePerAccess) {
+        for (size_t i = 0; i < stream.size(); i++) {
+            cache.accessInCycle(i + 1, stream[i].address,
+                                stream[i].isWrite ? CacheSim::AccessType::Write : CacheSim::AccessType::Read);
+        }
+        return;
+    }
+    for (const auto& access : stream) {
+        cache.access(access.address, access.isWrite ? CacheSim::AccessType::Write : CacheSim::AccessType::Read);
+    }
+}
+
+/// Captured traces are always replayed in their original cycles
+void replay(CacheSim& cache, const std::vector<CapturedAccess>& trace, bool) {
+    for (const auto& record : trace) {
+        if (record.kind == CapturedAccess::Kind::Undo) {
+            const auto& undoable = cache.getAccessTrace();
+            if (undoable.size() != 0 && undoable.back().first == record.cycle) {
+                cache.undo();
+            }
+        } else {
+            cache.accessInCycle(record.cycle, record.address,
+                                record.isWrite ? CacheSim::AccessType::Write : CacheSim::AccessType::Read, record.pc,
+                                record.bytes);
+        }
+    }
+}
+
+template <typename Stream>
+Result run(CacheSim& cache, const QString& name, const Stream& stream, bool cyclePerAccess) {
+    Result result;
+    result.name = name;
+
+    const long residentBefore = residentKiB();
+    // Accesses are performed from a worker thread; see file header
+    std::thread worker([&] {
+        const uint64_t allocationsBefore = s_allocations.load();
+        const auto start = std::chrono::steady_clock::now();
+        replay(cache, stream, cyclePerAccess);
+        const auto end = std::chrono::steady_clock::now();
+        const uint64_t allocations = s_allocations.load() - allocationsBefore;
+
+        result.nsPerAccess = std::chrono::duration<double, std::nano>(end - start).count() / stream.size();
+        result.allocationsPerAccess = static_cast<double>(allocations) / stream.size();
+    });
+    worker.join();
+
+    const auto estimate = cache.getHitRateEstimate();
+    result.hitRate = estimate.hitRate;
+    result.hitRateHalfWidth = estimate.halfWidth;
+    const auto wayPrediction = cache.getWayPredictionStats();
+    result.firstProbeHitRate = wayPrediction.firstProbeHitRate;
+    result.wayReadsSaved = wayPrediction.wayReadsSaved;
+    result.rssGrowthKiB = residentKiB() - residentBefore;
+    return result;
+}
+
+/**
+ * @brief measureReset
+ * Fills @p cache with @p stream, from a worker thread as in run(), and times the processor reset which follows, over
+ * @p rounds rounds. @returns the mean time of a reset in microseconds, and sets @p allocationsPerReset.
+ */
+double measureReset(CacheSim& cache, const std::vector<WorkloadAccess>& stream, unsigned rounds,
+                    double& allocationsPerReset) {
+    double totalUs = 0;
+    uint64_t allocations = 0;
+    for (unsigned round = 0; round < rounds; round++) {
+        std::thread worker([&] { replay(cache, stream, true); });
+        worker.join();
+        const uint64_t allocationsBefore = s_allocations.load();
+        const auto start = std::chrono::steady_clock::now();
+        cache.processorReset();
+        const auto end = std::chrono::steady_clock::now();
+        allocations += s_allocations.load() - allocationsBefore;
+        totalUs += std::chrono::duration<double, std::micro>(end - start).count();
+    }
+    allocationsPerReset = static_cast<double>(allocations) / rounds;
+    return totalUs / rounds;
+}
+
+QJsonObject toJson(const Result& result) {
+    QJsonObject obj;
+    obj["name"] = result.name;
+    obj["ns_per_access"] = result.nsPerAccess;
+    obj["allocations_per_access"] = result.allocationsPerAccess;
+    obj["hit_rate"] = result.hitRate;
+    obj["hit_rate_ci95"] = result.hitRateHalfWidth;
+    obj["first_probe_hit_rate"] = result.firstProbeHitRate;
+    obj["way_reads_saved"] = result.wayReadsSaved;
+    obj["rss_growth_kib"] = static_cast<double>(result.rssGrowthKiB);
+    return obj;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    unsigned accesses = 200000;
+    unsigned sampleBits = 0;
+    auto wayPrediction = CacheSim::WayPredictionPolicy::None;
+    uint64_t seed = 1;
+    QString filter, savePath, comparePath;
+    const char* tracePath = nullptr;
+    const char* capturePath = nullptr;
+    const char* exportFormat = nullptr;
+    QString exportDir = ".";
+    bool resetBench = false;
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--accesses") == 0 && hasValue) {
+            accesses = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--filter") == 0 && hasValue) {
+            filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--save") == 0 && hasValue) {
+            savePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--compare") == 0 && hasValue) {
+            comparePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--sample") == 0 && hasValue) {
+            sampleBits = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--way-prediction") == 0 && hasValue &&
+                   (std::strcmp(argv[i + 1], "mru") == 0 || std::strcmp(argv[i + 1], "pc") == 0)) {
+            wayPrediction = std::strcmp(argv[++i], "mru") == 0 ? CacheSim::WayPredictionPolicy::MRU
+                                                                : CacheSim::WayPredictionPolicy::PC;
+        } else if (std::strcmp(argv[i], "--trace") == 0 && hasValue) {
+            tracePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--capture") == 0 && hasValue) {
+            capturePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--export") == 0 && hasValue &&
+                   (std::strcmp(argv[i + 1], "csv") == 0 || std::strcmp(argv[i + 1], "bin") == 0)) {
+            exportFormat = argv[++i];
+        } else if (std::strcmp(argv[i], "--export-dir") == 0 && hasValue) {
+            exportDir = argv[++i];
+        } else if (std::strcmp(argv[i], "--reset") == 0) {
+            resetBench = true;
+        } else {
+            std::fprintf(stderr,
+                         "usage: %s [--accesses N] [--seed S] [--filter SUBSTRING] [--save baseline.json] "
+                         "[--compare baseline.json] [--sample N] [--way-prediction mru|pc] [--trace trace.rcat] "
+                         "[--capture trace.rcat] [--export csv|bin] [--export-dir DIR] [--reset]\n",
+                         argv[0]);
+            return 1;
+        }
+    }
+
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+    ProcessorHandler::get();
+
+    std::vector<CapturedAccess> trace;
+    if (tracePath != nullptr && !loadTrace(tracePath, trace)) {
+        return 1;
+    }
+
+    const auto writeMissIteration = writeMissBenchIteration();
+    std::vector<std::pair<const char*, std::vector<WorkloadAccess>>> streams = {
+        {"sequential", generate(StrideGenerator(s_dataBase, 4, accesses), accesses, seed)},
+        {"strided", generate(StrideGenerator(s_dataBase, 256, 4096, 4), accesses, seed)},
+        {"random", generate(RandomGenerator(s_dataBase, 1 << 20, 0.25), accesses, seed)},
+        {"working_set", generate(WorkingSetSweepGenerator(s_dataBase, 1 << 10, 1 << 20, 4), accesses, seed)},
+        {"zipf", generate(ZipfGenerator(s_dataBase, 1 << 16, 0.99), accesses, seed)},
+        {"pointer_chase", generate(PointerChaseGenerator(s_dataBase, 1 << 14, 64), accesses, seed)},
+        {"matmul", generate(BlockedMatMulGenerator(s_dataBase, s_dataBase + 0x10000, s_dataBase + 0x20000, 128, 16),
+                            accesses, seed)},
+        {"stencil", generate(StencilGenerator(s_dataBase, s_dataBase + 0x10000, 128, 128), accesses, seed)},
+        {"producer_consumer", generate(ProducerConsumerGenerator(s_dataBase, 4096, 64), accesses, seed)},
+        // designed_benchmarks/replacement_benchmarks/bench_lru.c and bench_lrulip.c: sum += a[4*i] for i < 7 (9)
+        {"bench_lru", generate(StrideGenerator(s_stackArrayBase, 16, 7), accesses, seed)},
+        {"bench_lrulip", generate(StrideGenerator(s_stackArrayBase, 16, 9), accesses, seed)},
+        // designed_benchmarks/writehit_benchmarks/bench_writehit_back.c: a[0] = k
+        {"bench_writehit", generate(StrideGenerator(s_stackArrayBase, 4, 1, 1), accesses, seed)},
+        {"bench_writemiss",
+         generate(ReplayGenerator(writeMissIteration.data(), writeMissIteration.size()), accesses, seed)}};
+
+    if (resetBench) {
+        std::printf("%-40s %12s %12s\n", "configuration", "reset us", "allocs/reset");
+        auto geometries = s_geometries;
+        geometries.push_back({"b16s16384w16", 4, 14, 4});
+        CacheSim cache(nullptr);
+        for (const auto& geometry : geometries) {
+            for (const auto& [streamName, stream] : streams) {
+                const QString name = QString("%1/%2").arg(geometry.name, streamName);
+                if ((std::strcmp(streamName, "sequential") != 0 && std::strcmp(streamName, "random") != 0) ||
+                    (!filter.isEmpty() && !name.contains(filter))) {
+                    continue;
+                }
+                cache.setBlocks(geometry.blockBits);
+                cache.setSets(geometry.setBits);
+                cache.setWays(geometry.wayBits);
+                cache.processorReset();
+                double allocationsPerReset = 0;
+                const double us = measureReset(cache, stream, 10, allocationsPerReset);
+                std::printf("%-40s %12.2f %12.1f\n", qPrintable(name), us, allocationsPerReset);
+                std::fflush(stdout);
+            }
+        }
+        return 0;
+    }
+
+    if (tracePath != nullptr) {
+        streams = {{"trace", {}}};
+    }
+
+    std::map<QString, QJsonObject> baseline;
+    if (!comparePath.isEmpty()) {
+        QFile file(comparePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            std::fprintf(stderr, "could not open baseline '%s'\n", qPrintable(comparePath));
+            return 1;
+        }
+        for (const auto& value : QJsonDocument::fromJson(file.readAll()).object()["results"].toArray()) {
+            baseline[value.toObject()["name"].toString()] = value.toObject();
+        }
+    }
+
+    if (sampleBits != 0) {
+        std::printf("SAMPLED: 1 in %u sets simulated; hit rates are extrapolated estimates\n", 1u << sampleBits);
+    }
+    std::printf("%-60s %10s %10s %8s %10s %8s\n", "configuration", "ns/access", "allocs/acc", "hitrate", "RSS +KiB",
+                comparePath.isEmpty() ? "" : "delta");
+
+    CacheSim cache(nullptr);
+    QJsonArray results;
+    for (const auto& geometry : s_geometries) {
+        for (const auto& [replPolicy, replName] : s_replPolicies) {
+            for (const auto& writeConfig : s_writeConfigs) {
+                for (const auto& [skewPolicy, skewName] : s_skewPolicies) {
+                    for (const auto& [streamName, stream] : streams) {
+                        const QString name = QString("%1/%2/%3/%4/%5")
+                                                 .arg(geometry.name, replName, writeConfig.name, skewName, streamName);
+                        if (!filter.isEmpty() && !name.contains(filter)) {
+                            continue;
+                        }
+
+                        // Each setter resets the cache, so the cache is empty at the start of each run
+                        cache.setBlocks(geometry.blockBits);
+                        cache.setSets(geometry.setBits);
+                        cache.setWays(geometry.wayBits);
+                        cache.setReplacementPolicy(replPolicy);
+                        cache.setWritePolicy(writeConfig.wrPolicy);
+                        cache.setWriteAllocatePolicy(writeConfig.wrAllocPolicy);
+                        cache.setSkewedAssocPolicy(skewPolicy);
+                        cache.setSampleBits(sampleBits);
+                        cache.setWayPrediction(wayPrediction);
+                        cache.processorReset();
+
+                        if (capturePath != nullptr && !cache.startCapture(capturePath)) {
+                            std::fprintf(stderr, "%s\n", cache.getCapture().errorString().c_str());
+                            return 1;
+                        }
+                        const bool cyclePerAccess = exportFormat != nullptr;
+                        const Result result = tracePath != nullptr ? run(cache, name, trace, cyclePerAccess)
+                                                                   : run(cache, name, stream, cyclePerAccess);
+                        if (capturePath != nullptr && !cache.stopCapture()) {
+                            std::fprintf(stderr, "%s\n", cache.getCapture().errorString().c_str());
+                            return 1;
+                        }
+                        results.append(toJson(result));
+
+                        if (exportFormat != nullptr) {
+                            const bool binary = std::strcmp(exportFormat, "bin") == 0;
+                            QString fileName = name;
+                            fileName.replace('/', '_');
+                            const QString path = exportDir + "/" + fileName + (binary ? ".rcst" : ".csv");
+                            CacheStatsExporter exporter(binary ? CacheStatsExporter::Format::Binary
+                                                               : CacheStatsExporter::Format::CSV);
+                            exporter.setSampleBits(sampleBits);
+                            if (!exporter.write(cache.getAccessTrace(), path.toStdString())) {
+                                std::fprintf(stderr, "%s\n", exporter.errorString().c_str());
+                                return 1;
+                            }
+                        }
+
+                        QString delta;
+                        if (baseline.count(name) != 0) {
+                            const double before = baseline.at(name)["ns_per_access"].toDouble();
+                            delta = QString("%1%").arg((result.nsPerAccess / before - 1) * 100, 0, 'f', 1);
+                        }
+                        std::printf("%-60s %10.1f %10.2f %8.4f %10ld %8s\n", qPrintable(name), result.nsPerAccess,
+                                    result.allocationsPerAccess, result.hitRate, result.rssGrowthKiB,
+                                    qPrintable(delta));
+                        std::fflush(stdout);
+                    }
+                }
+            }
+        }
+    }
+
+    if (!savePath.isEmpty()) {
+        QJsonObject root;
+        root["accesses"] = static_cast<double>(accesses);
+        root["sample_bits"] = static_cast<double>(sampleBits);
+        root["way_prediction"] = wayPrediction == CacheSim::WayPredictionPolicy::None  ? "none"
+                                 : wayPrediction == CacheSim::WayPredictionPolicy::MRU ? "mru"
+                                                                                       : "pc";
+        root["trace"] = tracePath != nullptr ? tracePath : "";
+        root["results"] = results;
+        QFile file(savePath);
+        if (!file.open(QIODevice::WriteOnly)) {
+            std::fprintf(stderr, "could not write baseline '%s'\n", qPrintable(savePath));
+            return 1;
+        }
+        file.write(QJsonDocument(root).toJson());
+    }
+    return 0;
+}
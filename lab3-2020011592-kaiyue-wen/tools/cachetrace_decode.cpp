@@ -0,0 +1,98 @@
+/**
+ * Offline decoder for cache simulator tracepoint files (see cachesim/cache_tracepoints.h).
+ *
+ * Usage: cachetrace_decode [--csv] trace_file
+ * Records are printed in timestamp order, either as human readable text or as CSV.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "../cachesim/cache_tracepoints.h"
+
+using namespace Ripes::Tracepoints;
+
+namespace {
+
+using ull = unsigned long long;
+
+void printText(const Record& r) {
+    const ull a0 = r.args[0], a1 = r.args[1], a2 = r.args[2];
+    std::printf("%12.3f us  [%u] %-12s", r.timestamp / 1000.0, r.thread, eventName(r.event));
+    switch (static_cast<Event>(r.event)) {
+    case Event::Access:
+        std::printf("addr=0x%08llx set=%llu way=%llu %s%s%s\n", a0, a1 >> 32, a1 & 0xFFFFFFFF,
+                    a2 & Write ? "write" : "read", a2 & Hit ? " hit" : " miss", a2 & Writeback ? " writeback" : "");
+        break;
+    case Event::Evict: std::printf("set=%llu way=%llu tag=0x%llx\n", a0, a1, a2); break;
+    case Event::Undo: std::printf("addr=0x%08llx set=%llu way=%llu\n", a0, a1, a2); break;
+    case Event::ReplLocate: std::printf("set=%llu way=%llu\n", a0, a1); break;
+    case Event::ReplUpdate: std::printf("set=%llu way=%llu hit=%llu\n", a0, a1, a2); break;
+    case Event::DipSwitch:
+        std::printf("policy=%s lru_hitrate=%.4f lip_hitrate=%.4f\n", a0 ? "LRU" : "LIP", a1 / 1e6, a2 / 1e6);
+        break;
+    default: std::printf("%llu %llu %llu\n", a0, a1, a2); break;
+    }
+}
+
+void printCSV(const Record& r) {
+    std::printf("%llu,%u,%s,%llu,%llu,%llu\n", static_cast<ull>(r.timestamp), r.thread, eventName(r.event),
+                static_cast<ull>(r.args[0]), static_cast<ull>(r.args[1]), static_cast<ull>(r.args[2]));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    bool csv = false;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--csv") == 0) {
+            csv = true;
+        } else {
+            path = argv[i];
+        }
+    }
+    if (path == nullptr) {
+        std::fprintf(stderr, "usage: %s [--csv] trace_file\n", argv[0]);
+        return 1;
+    }
+
+    std::FILE* file = std::fopen(path, "rb");
+    if (file == nullptr) {
+        std::fprintf(stderr, "could not open '%s'\n", path);
+        return 1;
+    }
+
+    FileHeader header;
+    const FileHeader expected;
+    if (std::fread(&header, sizeof(header), 1, file) != 1 ||
+        std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+        header.version != expected.version || header.recordSize != sizeof(Record)) {
+        std::fprintf(stderr, "'%s' is not a cache tracepoint file\n", path);
+        std::fclose(file);
+        return 1;
+    }
+
+    std::vector<Record> records;
+    Record record;
+    while (std::fread(&record, sizeof(record), 1, file) == 1) {
+        records.push_back(record);
+    }
+    std::fclose(file);
+
+    // Records are stored per thread; interleave them by time
+    std::stable_sort(records.begin(), records.end(),
+                     [](const Record& a, const Record& b) { return a.timestamp < b.timestamp; });
+
+    if (csv) {
+        std::printf("timestamp_ns,thread,event,arg0,arg1,arg2\n");
+    } else if (header.droppedRecords != 0) {
+        std::printf("# %u older records were overwritten before the trace was dumped\n", header.droppedRecords);
+    }
+    for (const auto& r : records) {
+        csv ? printCSV(r) : printText(r);
+    }
+    return 0;
+}